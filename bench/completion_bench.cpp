@@ -0,0 +1,257 @@
+// Tab completion latency: a keystroke trace is replayed through
+// TabCompletion::complete with one provider registered at a time, then
+// with all of them as the shell runs. Each Tab in the trace is a sample;
+// the report gives p50/p99/max latency and heap allocations per Tab, counted
+// through a replaced operator new (pool workers included).
+//
+// Record a trace from a real session with
+//   NOVASHELL_KEYTRACE=keys.trace ./bin/customos-shell
+// and replay it with
+//   ./bin/completion_bench keys.trace [repeat]
+// Without a trace a synthetic session is replayed. Run it from a source
+// tree so file completion has something to list. No API key is loaded,
+// so the AI provider is measured up to its key check, never the network.
+
+#include "core/tab_completion.h"
+#include "core/command_registry.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+} // anonymous namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+namespace fs = std::filesystem;
+using namespace customos::core;
+
+// The shell's built-in command names. CommandProcessor itself is not
+// linked (it pulls in every module); bench/CMakeLists.txt extracts the names
+// from its registration code at configure time instead.
+const char* const BUILTIN_COMMANDS[] = {
+#include "builtin_commands.inc"
+};
+
+// One key as recorded by Shell::read_input_with_completion
+struct KeyRecord {
+    int key;
+    size_t cursor;
+    std::string line;  // before the key was applied
+};
+
+bool load_trace(const std::string& path, std::vector<KeyRecord>& trace) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string text;
+    while (std::getline(in, text)) {
+        long long delay_ms;
+        int key;
+        size_t cursor;
+        int consumed = 0;
+        if (std::sscanf(text.c_str(), "%lld %d %zu %n", &delay_ms, &key, &cursor, &consumed) < 3 || consumed == 0) {
+            continue;
+        }
+        KeyRecord record{key, cursor, text.substr(static_cast<size_t>(consumed))};
+        record.cursor = std::min(record.cursor, record.line.size());
+        trace.push_back(std::move(record));
+    }
+    return true;
+}
+
+// Typing sessions with a Tab at each '\t'; every script ends with Enter
+std::vector<KeyRecord> synthetic_trace() {
+    const char* scripts[] = {
+        "he\tlp",           "hist\tory",         "\t",
+        "ls sr\tc",         "ls src/co\tre",     "cat src/core/tab\t_completion.cpp",
+        "cd inc\tlude",     "cd ..",             "git st\tatus",
+        "git checkout ma\tin",                   "db qu\tery users",
+        "ai-\tcompletion-stats",                 "echo hello",
+        "vault-\tlist",     "gre\tp -i todo src/core/sh\tell.cpp",
+        "\t",               "ls\t",              "cat README\t.md",
+    };
+
+    std::vector<KeyRecord> trace;
+    for (int round = 0; round < 4; ++round) {
+        for (const char* script : scripts) {
+            std::string line;
+            for (const char* c = script; *c; ++c) {
+                trace.push_back({static_cast<unsigned char>(*c), line.size(), line});
+                if (*c != '\t') {
+                    line += *c;
+                }
+            }
+            trace.push_back({'\n', line.size(), line});
+        }
+    }
+    return trace;
+}
+
+struct Result {
+    size_t tabs = 0;
+    double p50_us = 0;
+    double p99_us = 0;
+    double max_us = 0;
+    double allocs_per_tab = 0;
+    double matches_per_tab = 0;
+};
+
+Result replay(const std::vector<KeyRecord>& trace, size_t repeat) {
+    auto& completion = TabCompletion::instance();
+    std::vector<double> samples;
+    size_t allocations = 0;
+    size_t matches = 0;
+    std::string previous;
+
+    for (size_t r = 0; r < repeat; ++r) {
+        for (const auto& record : trace) {
+            if (record.key == '\t') {
+                size_t allocs_before = g_allocations.load();
+                auto start = std::chrono::steady_clock::now();
+                auto result = completion.complete(record.line, static_cast<int>(record.cursor));
+                double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                allocations += g_allocations.load() - allocs_before;
+                matches += result.size();
+                samples.push_back(us);
+            }
+            else if ((record.key == '\n' || record.key == '\r') && !record.line.empty()) {
+                // What Shell::execute_command feeds back after each command
+                completion.add_to_history(record.line);
+                completion.learn_from_command(record.line, previous);
+                previous = record.line;
+            }
+        }
+    }
+
+    Result result;
+    result.tabs = samples.size();
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))];
+    };
+    result.p50_us = percentile(0.50);
+    result.p99_us = percentile(0.99);
+    result.max_us = samples.back();
+    result.allocs_per_tab = static_cast<double>(allocations) / static_cast<double>(samples.size());
+    result.matches_per_tab = static_cast<double>(matches) / static_cast<double>(samples.size());
+    return result;
+}
+
+void report(const char* provider, const Result& result) {
+    std::printf("%-10s %7zu %10.1f %10.1f %10.1f %12.1f %10.1f\n", provider, result.tabs, result.p50_us,
+                result.p99_us, result.max_us, result.allocs_per_tab, result.matches_per_tab);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    std::vector<KeyRecord> trace;
+    if (argc > 1) {
+        if (!load_trace(argv[1], trace)) {
+            std::fprintf(stderr, "cannot read trace %s\n", argv[1]);
+            return 1;
+        }
+    }
+    else {
+        trace = synthetic_trace();
+    }
+    size_t tabs = static_cast<size_t>(std::count_if(trace.begin(), trace.end(),
+                                                     [](const KeyRecord& record) { return record.key == '\t'; }));
+    if (tabs == 0) {
+        std::fprintf(stderr, "trace has no Tab presses\n");
+        return 1;
+    }
+    // Enough passes for a stable p99 unless told otherwise
+    size_t repeat = argc > 2 ? static_cast<size_t>(std::strtoul(argv[2], nullptr, 10))
+                             : std::max<size_t>(1, 2000 / tabs);
+
+    // Learned state goes to a scratch directory, not the user's, and each
+    // run gets its own so concurrent runs never share one
+    std::string scratch_name = (fs::temp_directory_path() / "completion_bench.XXXXXX").string();
+#ifdef _WIN32
+    bool created = _mktemp_s(&scratch_name[0], scratch_name.size() + 1) == 0 && fs::create_directory(scratch_name);
+#else
+    bool created = mkdtemp(&scratch_name[0]) != nullptr;
+#endif
+    if (!created) {
+        std::fprintf(stderr, "cannot create a scratch directory in %s\n", fs::temp_directory_path().string().c_str());
+        return 1;
+    }
+    fs::path scratch = scratch_name;
+
+    CommandRegistry registry;
+    for (const char* name : BUILTIN_COMMANDS) {
+        CommandInfo info;
+        info.name = name;
+        info.handler = [](const CommandContext&) { return 0; };
+        registry.register_command(info);
+    }
+    auto& completion = TabCompletion::instance();
+    completion.set_command_registry(&registry);
+    completion.set_learning_path((scratch / "command_model").string());
+    completion.load_learning_data();
+
+    std::vector<std::shared_ptr<ICompletionProvider>> providers = {
+        std::make_shared<CommandCompletionProvider>(),  std::make_shared<FileCompletionProvider>(),
+        std::make_shared<GitCompletionProvider>(),      std::make_shared<DatabaseCompletionProvider>(),
+        std::make_shared<AICompletionProvider>(),       std::make_shared<LearningCompletionProvider>(),
+    };
+
+    std::printf("%zu keys, %zu Tab presses, %zu passes\n", trace.size(), tabs, repeat);
+    std::printf("%-10s %7s %10s %10s %10s %12s %10s\n", "provider", "tabs", "p50 us", "p99 us", "max us",
+                "allocs/tab", "matches");
+    for (const auto& provider : providers) {
+        completion.register_provider(provider);
+        report(provider->get_name().c_str(), replay(trace, repeat));
+        completion.unregister_provider(provider->get_name());
+    }
+
+    for (const auto& provider : providers) {
+        completion.register_provider(provider);
+    }
+    report("all", replay(trace, repeat));
+    for (const auto& provider : providers) {
+        completion.unregister_provider(provider->get_name());
+    }
+
+    completion.shutdown();
+    completion.set_command_registry(nullptr);
+    std::error_code ec;
+    fs::remove_all(scratch, ec);
+    return 0;
+}
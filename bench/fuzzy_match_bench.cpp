@@ -0,0 +1,101 @@
+// Fuzzy completion latency: 50k synthetic paths and commands ranked once
+// per keystroke as a query is typed, plus edit-distance throughput.
+
+#include "core/fuzzy_matcher.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using customos::core::FuzzyMatcher;
+
+std::vector<std::string> make_candidates(size_t count) {
+    const char* dirs[] = {"src", "include", "build", "docs", "tests", "third_party", "scripts", "assets"};
+    const char* parts[] = {"core", "ai", "vault", "network", "git", "database", "ui", "mobile",
+                           "analytics", "remote", "notes", "plugins", "auth", "containers"};
+    const char* names[] = {"Manager", "command", "history", "Search", "index", "session", "config",
+                           "tab_completion", "journal", "registry", "module", "handler"};
+    const char* exts[] = {".cpp", ".h", ".md", ".txt", ".json", ""};
+
+    std::mt19937 rng(7);
+    std::vector<std::string> out;
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string path = dirs[rng() % 8];
+        path += '/';
+        path += parts[rng() % 14];
+        path += '/';
+        path += names[rng() % 12];
+        if (rng() % 2 == 0) {
+            path += '_';
+            path += names[rng() % 12];
+        }
+        path += std::to_string(rng() % 1000);
+        path += exts[rng() % 6];
+        out.push_back(std::move(path));
+    }
+    return out;
+}
+
+struct Timing {
+    double mean_us;
+    double max_us;
+    size_t last_hits;
+};
+
+Timing type_query(const std::vector<std::string>& candidates, const std::vector<uint64_t>* masks,
+                  const std::string& query) {
+    std::vector<double> samples;
+    std::string typed;
+    size_t hits = 0;
+    for (char c : query) {
+        typed.push_back(c);
+        auto start = std::chrono::steady_clock::now();
+        FuzzyMatcher matcher(typed);
+        hits = (masks ? matcher.rank(candidates, *masks, 20) : matcher.rank(candidates, 20)).size();
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    return {sum / samples.size(), *std::max_element(samples.begin(), samples.end()), hits};
+}
+
+} // anonymous namespace
+
+int main() {
+    const size_t CANDIDATES = 50000;
+    std::vector<std::string> candidates = make_candidates(CANDIDATES);
+    std::printf("%zu candidates\n\n", CANDIDATES);
+
+    std::vector<uint64_t> masks;
+    for (const auto& candidate : candidates) {
+        masks.push_back(FuzzyMatcher::char_mask(candidate));
+    }
+
+    for (bool cached : {false, true}) {
+        std::printf("%s\n%-24s %12s %12s %8s\n", cached ? "\nmasks cached:" : "masks per keystroke:",
+                    "query (typed)", "mean us/key", "max us/key", "top");
+        for (const char* query : {"srccorehist", "tab_comp.cpp", "vaultMgr", "incl/ai/module", "qqq", "README"}) {
+            Timing t = type_query(candidates, cached ? &masks : nullptr, query);
+            std::printf("%-24s %12.1f %12.1f %8zu\n", query, t.mean_us, t.max_us, t.last_hits);
+        }
+    }
+
+    // Typo fallback: distance from the query to every candidate's best prefix
+    const std::string typo = "src/croe/hsitory";
+    auto start = std::chrono::steady_clock::now();
+    size_t close = 0;
+    for (const auto& candidate : candidates) {
+        if (FuzzyMatcher::prefix_distance(typo, candidate) <= 2) {
+            ++close;
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("\nprefix_distance(\"%s\") over all: %.2f ms, %zu within 2 edits\n", typo.c_str(), ms, close);
+    return 0;
+}
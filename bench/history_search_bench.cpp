@@ -0,0 +1,94 @@
+// Reverse-i-search latency: a million synthetic history lines, then
+// queries typed one character at a time (each keystroke is one find()
+// with the same cursor, as the shell does), plus repeated Ctrl-R steps.
+
+#include "core/history_search.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using customos::core::HistorySearchIndex;
+
+std::vector<std::string> make_history(size_t count) {
+    const char* commands[] = {"git-status", "git-commit -m", "git-push origin", "vault-get", "note-add",
+                              "ls -la", "grep -r", "docker ps", "ssh deploy@", "ai-explain", "cat", "make -j8"};
+    const char* words[] = {"src", "build", "release", "main", "feature", "config", "server", "prod",
+                           "staging", "notes", "backup", "logs", "api", "db", "cache", "client"};
+
+    std::mt19937 rng(42);
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string line = commands[rng() % 12];
+        int args = 1 + static_cast<int>(rng() % 3);
+        for (int a = 0; a < args; ++a) {
+            line += ' ';
+            line += words[rng() % 16];
+            if (rng() % 3 == 0) {
+                line += "-" + std::to_string(rng() % 5000);  // keeps many lines distinct
+            }
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+struct Timing {
+    double mean_us;
+    double max_us;
+};
+
+Timing type_query(const HistorySearchIndex& index, const std::string& query, int ctrl_r_steps) {
+    HistorySearchIndex::Cursor cursor;
+    std::string typed;
+    std::string match;
+    uint64_t seq = HistorySearchIndex::NEWEST;
+    std::vector<double> samples;
+
+    auto timed_find = [&](uint64_t before) {
+        auto start = std::chrono::steady_clock::now();
+        bool found = index.find(typed, before, cursor, match, seq);
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        return found;
+    };
+
+    for (char c : query) {
+        typed.push_back(c);
+        timed_find(HistorySearchIndex::NEWEST);
+    }
+    for (int i = 0; i < ctrl_r_steps; ++i) {
+        if (!timed_find(seq)) break;
+    }
+
+    double sum = 0.0;
+    for (double s : samples) sum += s;
+    return {sum / samples.size(), *std::max_element(samples.begin(), samples.end())};
+}
+
+} // anonymous namespace
+
+int main() {
+    const size_t LINES = 1000000;
+    std::vector<std::string> history = make_history(LINES);
+
+    HistorySearchIndex index;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& line : history) {
+        index.add(line);
+    }
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("indexed %zu lines (%zu distinct) in %.1f ms\n\n", LINES, index.unique_count(), build_ms);
+
+    std::printf("%-28s %12s %12s\n", "query (typed + 20x Ctrl-R)", "mean us/key", "max us/key");
+    for (const char* query : {"git-push origin prod", "vault-get api-42", "docker", "ssh deploy@staging-1",
+                              "make -j8 release", "zzz-not-there", "logs"}) {
+        Timing t = type_query(index, query, 20);
+        std::printf("%-28s %12.2f %12.2f\n", query, t.mean_us, t.max_us);
+    }
+    return 0;
+}
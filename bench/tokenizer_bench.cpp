@@ -0,0 +1,203 @@
+// Command-line parsing cost: the previous std::istringstream tokenizer
+// against core::Tokenizer, on a short command, a long line and a pasted
+// script. Heap allocations are counted through a replaced operator new.
+// "tokenizer" is tokenize() alone; "parse path" also builds the pipeline
+// stages and the handler's argument list the way CommandProcessor does,
+// which copies every word into a std::string.
+
+#include "core/tokenizer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+} // anonymous namespace
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using customos::core::Tokenizer;
+
+// What CommandProcessor::parse_command did before the tokenizer
+size_t parse_with_istringstream(const std::string& line) {
+    std::istringstream iss(line);
+    std::vector<std::string> tokens;
+    std::string token;
+    while (iss >> token) {
+        tokens.push_back(token);
+    }
+    return tokens.size();
+}
+
+size_t parse_with_tokenizer(Tokenizer& tokenizer, const std::string& line) {
+    static const Tokenizer::VariableLookup lookup = [](std::string_view name, std::string_view& value) {
+        if (name == "HOME") {
+            value = "/home/user";
+            return true;
+        }
+        return false;
+    };
+    tokenizer.tokenize(line, lookup);
+    return tokenizer.tokens().size();
+}
+
+// Mirror of CommandProcessor::parse_pipeline plus the argument copy in
+// make_context, without the registry and environment it needs
+struct Stage {
+    std::string name;
+    std::vector<std::string> arguments;
+    std::string input_redirect;
+    std::string output_redirect;
+};
+
+size_t parse_full_path(Tokenizer& tokenizer, const std::string& line) {
+    using customos::core::TokenType;
+    parse_with_tokenizer(tokenizer, line);
+    std::vector<Stage> stages;
+    const auto& tokens = tokenizer.tokens();
+    if (tokens.empty()) {
+        return 0;
+    }
+    stages.emplace_back();
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        Stage& stage = stages.back();
+        switch (tokens[i].type) {
+            case TokenType::WORD:
+                if (stage.name.empty() && stage.arguments.empty()) {
+                    stage.name.assign(tokens[i].text);
+                }
+                else {
+                    stage.arguments.emplace_back(tokens[i].text);
+                }
+                break;
+            case TokenType::PIPE:
+                stages.emplace_back();
+                break;
+            case TokenType::REDIRECT_IN:
+                stage.input_redirect.assign(tokens[++i].text);
+                break;
+            case TokenType::REDIRECT_OUT:
+            case TokenType::REDIRECT_APPEND:
+                stage.output_redirect.assign(tokens[++i].text);
+                break;
+            case TokenType::BACKGROUND:
+                break;
+        }
+    }
+    size_t words = 0;
+    for (const auto& stage : stages) {
+        std::vector<std::string> args = stage.arguments;  // CommandContext::args
+        words += 1 + args.size();
+    }
+    return words;
+}
+
+struct Result {
+    double ns_per_line;
+    double mb_per_s;
+    double allocs_per_line;
+};
+
+template <typename Fn>
+Result measure(const std::vector<std::string>& lines, size_t iterations, Fn&& fn) {
+    size_t bytes = 0;
+    for (const auto& line : lines) {
+        bytes += line.size();
+    }
+
+    // Warm up (lets the tokenizer arena reach its steady-state size)
+    size_t sink = 0;
+    for (const auto& line : lines) {
+        sink += fn(line);
+    }
+
+    size_t allocs_before = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t it = 0; it < iterations; ++it) {
+        for (const auto& line : lines) {
+            sink += fn(line);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t allocs = g_allocations.load() - allocs_before;
+
+    if (sink == 42) {
+        std::puts("");  // keep the work observable
+    }
+
+    double total_lines = static_cast<double>(iterations * lines.size());
+    return {seconds * 1e9 / total_lines,
+            static_cast<double>(bytes) * iterations / seconds / (1024.0 * 1024.0),
+            static_cast<double>(allocs) / total_lines};
+}
+
+void report(const char* workload, const std::vector<std::string>& lines, size_t iterations) {
+    Tokenizer tokenizer;
+    Result old_parser = measure(lines, iterations, parse_with_istringstream);
+    Result new_parser = measure(lines, iterations, [&tokenizer](const std::string& line) {
+        return parse_with_tokenizer(tokenizer, line);
+    });
+    Result full_path = measure(lines, iterations, [&tokenizer](const std::string& line) {
+        return parse_full_path(tokenizer, line);
+    });
+
+    std::printf("%-14s %-14s %12.1f %10.1f %12.2f\n", workload, "istringstream",
+                old_parser.ns_per_line, old_parser.mb_per_s, old_parser.allocs_per_line);
+    std::printf("%-14s %-14s %12.1f %10.1f %12.2f\n", workload, "tokenizer",
+                new_parser.ns_per_line, new_parser.mb_per_s, new_parser.allocs_per_line);
+    std::printf("%-14s %-14s %12.1f %10.1f %12.2f\n", workload, "parse path",
+                full_path.ns_per_line, full_path.mb_per_s, full_path.allocs_per_line);
+}
+
+} // anonymous namespace
+
+int main() {
+    std::vector<std::string> short_line = {"note-add \"my title\" some body text > notes.txt"};
+
+    std::string long_line = "grep -i";
+    for (int i = 0; i < 400; ++i) {
+        long_line += " arg" + std::to_string(i) + " \"quoted value " + std::to_string(i) + "\" $HOME/path";
+    }
+    std::vector<std::string> long_lines = {long_line};
+
+    // A pasted provisioning script: many short, varied lines
+    std::vector<std::string> script;
+    for (int i = 0; i < 1000; ++i) {
+        switch (i % 4) {
+            case 0: script.push_back("vault-add service" + std::to_string(i) + " admin 'p@ss word'"); break;
+            case 1: script.push_back("help all | grep -c vault"); break;
+            case 2: script.push_back("echo ${HOME}/projects/" + std::to_string(i) + " >> log.txt"); break;
+            default: script.push_back("git-status & "); break;
+        }
+    }
+
+    std::printf("%-14s %-14s %12s %10s %12s\n", "workload", "parser", "ns/line", "MB/s", "allocs/line");
+    report("short", short_line, 200000);
+    report("long (14 KB)", long_lines, 500);
+    report("script x1000", script, 200);
+    return 0;
+}
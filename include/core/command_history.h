@@ -0,0 +1,89 @@
+#ifndef CUSTOMOS_COMMAND_HISTORY_H
+#define CUSTOMOS_COMMAND_HISTORY_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "history_search.h"
+
+namespace customos {
+namespace core {
+
+struct HistoryEntry {
+    int64_t timestamp;  // Unix seconds
+    std::string command;
+};
+
+// Shell command history.
+// The most recent entries live in a fixed-capacity ring. Every command is
+// also appended to an append-only log file ("<unix time>;<command>\n") with
+// one O_APPEND write, so shells sharing the file never overwrite each
+// other's records. On open only the tail of the log is parsed (through a
+// read-only mapping), never more than the ring holds. Commands are also
+// appended to the process-wide HistoryJournal, whose group commit to SQLite
+// syncs the log file in the same step.
+class CommandHistory {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 100000;
+
+    static CommandHistory& instance();
+
+    // Open the log file and load its most recent entries into the ring
+    bool open(const std::string& path, size_t capacity = DEFAULT_CAPACITY);
+
+    // Detach from the journal and close the log file. Flush the journal
+    // first (Shell::shutdown does) so its last drain syncs the log.
+    void close();
+
+    // Append a command; returns false if it repeats the previous entry
+    // (the journal still receives it)
+    bool record(const std::string& command, const std::string& user);
+
+    // Entries in the ring; index 0 is the oldest
+    size_t size() const;
+    std::string at(size_t index) const;
+
+    // The last `count` entries, oldest first
+    std::vector<HistoryEntry> recent(size_t count) const;
+
+    // Substring index for reverse-i-search. Built from the ring on first
+    // use, then kept current by record().
+    const HistorySearchIndex& search_index();
+
+private:
+    CommandHistory();
+    ~CommandHistory();
+    CommandHistory(const CommandHistory&) = delete;
+    CommandHistory& operator=(const CommandHistory&) = delete;
+
+    void push_ring(int64_t timestamp, std::string command);
+    size_t load_tail(const char* data, size_t size);
+    bool open_log();
+    void close_log();
+    bool append_to_log(const std::string& record);
+    bool rewrite_log();
+    void sync_log();
+
+    mutable std::mutex mutex_;
+
+    // Ring buffer
+    std::vector<HistoryEntry> ring_;  // grows to capacity_, then wraps
+    size_t capacity_;
+    size_t head_;   // index of the oldest entry once full
+    HistorySearchIndex search_index_;
+    bool index_built_;
+
+    // Log file
+    std::string path_;
+    int fd_;               // O_APPEND; holds a shared flock on POSIX
+
+    std::condition_variable sync_done_;
+    bool sync_in_flight_;  // keeps the file open while it is synced
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_COMMAND_HISTORY_H
@@ -0,0 +1,75 @@
+#ifndef CUSTOMOS_COMMAND_METRICS_H
+#define CUSTOMOS_COMMAND_METRICS_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace customos {
+namespace core {
+
+// Log-linear (HDR-style) histogram of microsecond values.
+// Values below 2*SUB_BUCKETS are exact; above that each power of two is
+// split into SUB_BUCKETS buckets, so any recorded value is reported within
+// about 3% of its true value while the whole range (1us .. ~19h) needs
+// only a few KB.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr int MAX_VALUE_BITS = 36;
+    static constexpr size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram();
+
+    void record(uint64_t value_us);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    double mean() const;
+
+    // Value at or below which the given fraction (0..1] of samples fall
+    uint64_t percentile(double fraction) const;
+
+private:
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_upper_bound(size_t index);
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t max_;
+};
+
+// Per-command timing summary merged from every thread
+struct CommandStats {
+    std::string name;
+    uint64_t calls;
+    uint64_t failures;
+    LatencyHistogram wall;
+    LatencyHistogram cpu;
+};
+
+// Dispatch timings recorded by CommandRegistry::execute.
+// Each thread records into its own histograms (no shared cache lines or
+// contended locks on the hot path); snapshot() merges them, including
+// those of threads that have already exited.
+class CommandMetrics {
+public:
+    static void record(const std::string& command, uint64_t wall_us, uint64_t cpu_us, bool success);
+
+    // Sorted by command name
+    static std::vector<CommandStats> snapshot();
+
+    static void reset();
+
+    // CPU time consumed by the calling thread
+    static uint64_t thread_cpu_us();
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_COMMAND_METRICS_H
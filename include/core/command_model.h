@@ -0,0 +1,131 @@
+#ifndef CUSTOMOS_COMMAND_MODEL_H
+#define CUSTOMOS_COMMAND_MODEL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+
+namespace customos {
+namespace core {
+
+// Usage model behind learned completions.
+// Command names and argument strings are interned to 32-bit ids. The model
+// counts, per context, how often each id followed it: the previous one and
+// two commands (a Markov chain of order 1 and 2), the command whose
+// arguments are being typed, and the hour of day. Each context also keeps
+// its TOP_K items in count order, updated on every observation, so
+// learning costs a few hash lookups and a prediction is a table read.
+//
+// State lives in "<base>.bin", a binary snapshot that is memory-mapped and
+// decoded on open, and "<base>.log", to which every learned command is
+// appended. The log is replayed on open and folded into a new snapshot on
+// close, or once it holds COMPACT_THRESHOLD records. Shells share both
+// files: appends hold a shared flock on the log, and compaction holds it
+// exclusively and starts from the files rather than from memory, so it
+// never drops what another shell appended. Compaction also keeps only the
+// MAX_ARGUMENTS most used argument strings per command.
+// Not thread-safe; TabCompletion serializes access.
+class CommandModel {
+public:
+    static constexpr size_t TOP_K = 8;
+    static constexpr size_t COMPACT_THRESHOLD = 4096;
+    static constexpr size_t MAX_ARGUMENTS = 64;
+
+    struct Prediction {
+        std::string text;
+        uint32_t count;
+    };
+
+    CommandModel();
+    ~CommandModel();
+    CommandModel(const CommandModel&) = delete;
+    CommandModel& operator=(const CommandModel&) = delete;
+
+    // Load "<base>.bin" and replay "<base>.log"; missing files mean an empty
+    // model. False only if the log cannot be opened for appending.
+    bool open(const std::string& base_path);
+
+    // Write a snapshot if anything was learned, and close the log
+    void close();
+
+    // Record a command run after `previous_command` at local hour `hour`
+    void learn(const std::string& command, const std::string& previous_command, int hour);
+
+    // Commands likely to follow the last ones learned, starting with `prefix`;
+    // falls back from two commands of context to one to overall frequency
+    std::vector<Prediction> predict_next(const std::string& prefix, size_t limit) const;
+
+    // Argument strings used with `command` that contain `partial`
+    std::vector<Prediction> predict_arguments(const std::string& command, const std::string& partial,
+                                              size_t limit) const;
+
+    // Commands most used at `hour` that start with `prefix`
+    std::vector<Prediction> predict_for_hour(int hour, const std::string& prefix, size_t limit) const;
+
+    uint32_t frequency(const std::string& command) const;
+
+    // Most used commands overall (at most TOP_K)
+    std::vector<Prediction> top_commands(size_t limit) const;
+
+    // Fold the log into a new snapshot and empty it
+    bool save();
+
+private:
+    enum Kind : uint64_t { GLOBAL = 0, AFTER_ONE = 1, AFTER_TWO = 2, ARGUMENTS = 3, HOUR = 4 };
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    struct Ranked {
+        uint32_t id;
+        uint32_t count;
+    };
+
+    struct CountKey {
+        uint64_t context;
+        uint32_t item;
+        bool operator==(const CountKey& other) const { return context == other.context && item == other.item; }
+    };
+    struct CountKeyHash {
+        size_t operator()(const CountKey& key) const {
+            return std::hash<uint64_t>()(key.context * 0x9E3779B97F4A7C15ULL ^ key.item);
+        }
+    };
+
+    static uint64_t context_of(Kind kind, uint32_t a, uint32_t b = 0) {
+        return (static_cast<uint64_t>(kind) << 60) | (static_cast<uint64_t>(a & 0x3FFFFFFF) << 30) | (b & 0x3FFFFFFF);
+    }
+
+    uint32_t intern(std::string_view text);
+    uint32_t find_id(std::string_view text) const;
+    void count(uint64_t context, uint32_t item, uint32_t by = 1);
+    void observe(const std::string& command, const std::string& previous_command, int hour);
+    void append_log(const std::string& command, const std::string& previous_command, int hour);
+    void reset();
+    bool load_snapshot();
+    size_t replay_log();
+    void prune_arguments();
+    bool compact();  // caller holds the log exclusively
+
+    template <typename Accept>
+    void collect(uint64_t context, Accept accept, size_t limit, std::vector<Prediction>& out,
+                 std::vector<uint32_t>& seen) const;
+
+    std::deque<std::string> strings_;                     // stable addresses for ids_'s views
+    std::unordered_map<std::string_view, uint32_t> ids_;
+    std::unordered_map<CountKey, uint32_t, CountKeyHash> counts_;
+    std::unordered_map<uint64_t, std::vector<Ranked>> top_;
+    uint32_t last_;    // most recent command
+    uint32_t before_;  // the one before it
+
+    std::string base_path_;
+    int log_fd_;
+    size_t log_records_;
+    bool dirty_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_COMMAND_MODEL_H
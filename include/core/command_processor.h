@@ -4,7 +4,9 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <map>
 #include "command_registry.h"
+#include "output_sink.h"
 
 namespace customos {
 namespace core {
@@ -23,9 +25,28 @@ public:
     // Initialize processor and register built-in commands
     bool initialize();
 
-    // Process and execute a command line
+    // Process and execute a command line for the interactive shell, writing
+    // output to the caller's stdout
     CommandResult process(const std::string& command_line);
 
+    // Per-call overrides for commands run on behalf of another process
+    // (daemon clients): stdin, environment and working directory
+    struct Invocation {
+        std::shared_ptr<CommandStream> input;
+        std::map<std::string, std::string> environment;
+        std::string working_directory;
+        bool run_programs = false;  // fall back to programs on PATH; the shell and the local daemon only
+        bool interactive = false;   // the shell's own terminal: programs inherit its stdin and Ctrl-C
+    };
+
+    // Process a command line with all output written into the given sink
+    CommandResult process(const std::string& command_line, OutputSink& sink);
+    CommandResult process(const std::string& command_line, OutputSink& sink, const Invocation& invocation);
+
+    // Process a command line and return its output in CommandResult::output.
+    // For remote callers: built-in commands only, no terminal.
+    CommandResult capture(const std::string& command_line);
+
     // Get command registry
     CommandRegistry* get_registry();
 
@@ -39,9 +60,19 @@ private:
         bool background;
     };
 
-    ParsedCommand parse_command(const std::string& command_line);
-    CommandResult execute_parsed_command(const ParsedCommand& cmd);
+    bool parse_pipeline(const std::string& command_line, const Invocation& invocation,
+                        std::vector<ParsedCommand>& stages, std::string& error);
+    CommandResult execute_parsed_command(const ParsedCommand& cmd, OutputSink& sink, const Invocation& invocation);
+    CommandResult execute_pipeline(const std::vector<ParsedCommand>& stages, OutputSink& sink, const Invocation& invocation);
+    CommandContext make_context(const ParsedCommand& cmd, const Invocation& invocation);
+    std::string find_program(const std::string& name, const Invocation& invocation);
+    std::string not_found_message(const std::string& name) const;
+    int run_program(const std::string& program, const ParsedCommand& cmd,
+                    const CommandContext& context, const Invocation& invocation);
     void register_builtin_commands();
+    void register_stream_commands();
+    void register_job_commands();
+    void register_path_commands();
     void register_scheduler_commands();
     void register_ai_commands();
     void register_plugin_commands();
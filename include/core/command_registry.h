@@ -7,16 +7,37 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <atomic>
+#include "command_stream.h"
+#include "command_trie.h"
 
 namespace customos {
 namespace core {
 
+class OutputSink;
+
 // Command execution context
 struct CommandContext {
     std::vector<std::string> args;
     std::string current_user;
     std::string working_directory;
     std::map<std::string, std::string> environment;
+
+    // Pipeline streams; null when the command is not part of a pipeline
+    std::shared_ptr<CommandStream> input;
+    std::shared_ptr<CommandStream> output;
+
+    // Buffered output for this command (std::cout is routed here as well)
+    OutputSink* sink = nullptr;
+
+    // Set when the background job running this command is killed;
+    // long-running handlers should poll cancelled()
+    std::shared_ptr<std::atomic<bool>> cancel_flag;
+
+    // Run by the interactive shell itself, not for a daemon or remote client
+    bool interactive = false;
+
+    bool cancelled() const { return cancel_flag && cancel_flag->load(); }
 };
 
 // Command handler function type
@@ -29,8 +50,21 @@ struct CommandInfo {
     std::string usage;
     std::vector<std::string> required_permissions;
     CommandHandler handler;
+
+    // Lazily initialized subsystem the handler needs (see LazySubsystems);
+    // empty for commands that need nothing beyond the shell itself
+    std::string subsystem;
+
+    // For built-ins named like a common program: when set and false for the
+    // arguments, the program on PATH runs instead (kill 1234 is /bin/kill)
+    std::function<bool(const std::vector<std::string>& args)> handles;
 };
 
+// Command table with snapshot (RCU-style) publication.
+// Lookups read the current immutable snapshot without taking a lock and
+// handlers run outside the registry entirely, so a long-running command in
+// one session never blocks dispatch in another. Writers copy the table,
+// apply their change and atomically publish the new snapshot.
 class CommandRegistry {
 public:
     CommandRegistry();
@@ -45,7 +79,11 @@ public:
     // Check if command exists
     bool has_command(const std::string& name) const;
 
-    // Get command information
+    // True if a registered command takes these arguments itself rather than
+    // deferring to the program it shadows (see CommandInfo::handles)
+    bool handles(const std::string& name, const std::vector<std::string>& args) const;
+
+    // Get command information (valid until the command is unregistered)
     const CommandInfo* get_command(const std::string& name) const;
 
     // Execute a command
@@ -54,12 +92,63 @@ public:
     // List all registered commands
     std::vector<std::string> list_commands() const;
 
-    // Get command suggestions (for autocomplete)
-    std::vector<std::string> suggest_commands(const std::string& prefix) const;
+    // Commands starting with prefix, sorted (for autocomplete)
+    std::vector<std::string> suggest_commands(const std::string& prefix, size_t limit = SIZE_MAX) const;
+
+    // Commands within a few edits of a mistyped name, closest first
+    std::vector<std::string> suggest_similar(const std::string& name, size_t limit = 3) const;
+
+    // Commands registered later whose name starts with prefix (and that do
+    // not name a subsystem themselves) depend on the given lazy subsystem
+    void bind_subsystem(const std::string& prefix, const std::string& subsystem);
+
+    // Collects registrations into one snapshot, published when the outermost
+    // batch ends, so bulk registration at startup copies the table once
+    // instead of once per command
+    class Batch {
+    public:
+        explicit Batch(CommandRegistry& registry);
+        ~Batch();
+
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+    private:
+        CommandRegistry& registry_;
+    };
 
 private:
-    std::map<std::string, CommandInfo> commands_;
-    mutable std::mutex mutex_;
+    // One snapshot: the commands and a name index over the same set
+    struct CommandTable {
+        std::map<std::string, std::shared_ptr<const CommandInfo>> commands;
+        CommandTrie names;
+    };
+
+    // Marks the calling thread as reading the current snapshot
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const CommandRegistry& registry);
+        ~ReadGuard();
+        const CommandTable& table() const { return *table_; }
+
+    private:
+        const CommandRegistry& registry_;
+        const CommandTable* table_;
+    };
+
+    std::shared_ptr<const CommandInfo> lookup(const std::string& name) const;
+    void publish(std::unique_ptr<const CommandTable> table);
+
+    std::atomic<const CommandTable*> table_;
+    mutable std::atomic<int> active_readers_;
+
+    // Writers only: serializes updates and holds replaced snapshots until
+    // no reader can still see them
+    std::mutex write_mutex_;
+    std::vector<std::unique_ptr<const CommandTable>> retired_;
+    std::unique_ptr<CommandTable> pending_;   // open batch, not yet visible
+    int batch_depth_;
+    std::vector<std::pair<std::string, std::string>> subsystem_bindings_;
 };
 
 } // namespace core
@@ -0,0 +1,82 @@
+#ifndef CUSTOMOS_COMMAND_STREAM_H
+#define CUSTOMOS_COMMAND_STREAM_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <streambuf>
+#include <cstddef>
+
+namespace customos {
+namespace core {
+
+// Bounded in-memory byte pipe connecting two pipeline stages.
+// The writer blocks while the buffer is full, so a fast producer feeding a
+// slow consumer runs in constant memory.
+class CommandStream {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+    explicit CommandStream(size_t capacity = DEFAULT_CAPACITY);
+    ~CommandStream();
+
+    CommandStream(const CommandStream&) = delete;
+    CommandStream& operator=(const CommandStream&) = delete;
+
+    // Writer side. Returns false once the reader has gone away (broken pipe).
+    bool write(const char* data, size_t size);
+    bool write(const std::string& data);
+    void close_write();
+
+    // Reader side. read() returns 0 at end of stream.
+    size_t read(char* buffer, size_t size);
+    bool read_line(std::string& line);
+    void close_read();
+
+    bool is_reader_closed() const;
+    bool is_writer_closed() const;
+
+private:
+    std::vector<char> buffer_;
+    size_t head_;
+    size_t size_;
+    bool write_closed_;
+    bool read_closed_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// Routes std::cout through a per-thread target.
+// Handlers keep writing to std::cout; each pipeline stage (or capture scope)
+// redirects its own thread without affecting concurrently running commands.
+class OutputRouter {
+public:
+    // Install the router on std::cout. Safe to call more than once.
+    static void install();
+
+    // Target for the calling thread (the original stdout buffer by default)
+    static std::streambuf* current();
+
+    // True while a Scope is active on the calling thread
+    static bool redirected();
+
+    // While alive, std::cout writes on this thread go to target
+    class Scope {
+    public:
+        explicit Scope(std::streambuf* target);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        std::streambuf* previous_;
+    };
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_COMMAND_STREAM_H
@@ -0,0 +1,62 @@
+#ifndef CUSTOMOS_COMMAND_TRIE_H
+#define CUSTOMOS_COMMAND_TRIE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <utility>
+
+namespace customos {
+namespace core {
+
+// Radix trie of command names.
+// Nodes are immutable and shared: insert and erase copy only the path to
+// the changed node, so copying a trie is O(1) and a registry snapshot can
+// carry its own trie cheaply. Prefix queries cost the prefix length plus
+// the names returned; "did you mean" walks the trie with one edit-distance
+// row per character and prunes branches that are already too far away.
+class CommandTrie {
+public:
+    CommandTrie();
+
+    // False if already present / not present
+    bool insert(const std::string& name);
+    bool erase(const std::string& name);
+
+    bool contains(const std::string& name) const;
+    size_t size() const { return size_; }
+
+    // Names starting with `prefix`, in lexicographic order
+    std::vector<std::string> with_prefix(const std::string& prefix, size_t limit = SIZE_MAX) const;
+
+    // Names within `max_distance` edits of `name`, closest first
+    std::vector<std::string> similar(const std::string& name, size_t max_distance, size_t limit) const;
+
+private:
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct Node {
+        std::string edge;               // label on the edge from the parent
+        bool terminal = false;          // a name ends here
+        std::vector<NodePtr> children;  // ordered by first byte of edge
+    };
+
+    static size_t child_index(const Node& node, char first);
+    static NodePtr insert_at(const Node& node, std::string_view rest);
+    static NodePtr erase_at(const Node& node, std::string_view rest, bool is_root);
+    static void collect(const Node& node, std::string& path, size_t limit, std::vector<std::string>& out);
+    static void walk_similar(const Node& node, std::string& path, std::string_view target,
+                             const std::vector<size_t>& row, size_t max_distance,
+                             std::vector<std::pair<size_t, std::string>>& out);
+
+    NodePtr root_;
+    size_t size_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_COMMAND_TRIE_H
@@ -0,0 +1,41 @@
+#ifndef CUSTOMOS_DAEMON_H
+#define CUSTOMOS_DAEMON_H
+
+#include <string>
+#include <memory>
+#include "command_processor.h"
+
+namespace customos {
+namespace core {
+
+// Keeps one initialized CommandProcessor warm and serves command
+// invocations from customos-client over a Unix domain socket, so scripted
+// use pays process startup and database setup once instead of per command.
+// Each connection runs one command line; connections are served
+// concurrently. Only clients running as the daemon's own user are accepted.
+class DaemonServer {
+public:
+    explicit DaemonServer(CommandProcessor& processor);
+    ~DaemonServer();
+
+    DaemonServer(const DaemonServer&) = delete;
+    DaemonServer& operator=(const DaemonServer&) = delete;
+
+    // Bind and listen; fails if another daemon already serves the path
+    bool start(const std::string& socket_path, std::string& error);
+
+    // Accept and serve clients until stop() is called
+    void run();
+
+    // Async-signal-safe: makes run() return
+    void stop();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> pimpl_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_DAEMON_H
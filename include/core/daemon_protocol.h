@@ -0,0 +1,197 @@
+#ifndef CUSTOMOS_DAEMON_PROTOCOL_H
+#define CUSTOMOS_DAEMON_PROTOCOL_H
+
+// Wire format shared by the daemon (customos-shell --daemon) and the thin
+// client (customos-client). Header-only so the client stays dependency free.
+//
+// Every message is a frame: 1 byte type, 4 byte big-endian length, payload.
+//   client -> daemon: ARG* ENV* CWD? RUN, then STDIN* STDIN_EOF
+//   daemon -> client: OUTPUT* EXIT (payload: 4 byte big-endian exit code)
+
+#ifndef _WIN32
+
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace customos {
+namespace core {
+namespace daemon_protocol {
+
+enum FrameType : char {
+    FRAME_ARG = 'A',
+    FRAME_ENV = 'E',
+    FRAME_CWD = 'C',
+    FRAME_RUN = 'R',
+    FRAME_STDIN = 'I',
+    FRAME_STDIN_EOF = 'Z',
+    FRAME_OUTPUT = 'O',
+    FRAME_EXIT = 'X'
+};
+
+// Upper bound on a single frame; larger payloads are split by the sender
+constexpr uint32_t MAX_FRAME_SIZE = 1024 * 1024;
+
+// Socket path used when none is given: per-user, inside XDG_RUNTIME_DIR
+// when available. The /tmp fallback can be bound by anyone first, so both
+// ends check who is on the other side (peer_is_same_user).
+inline std::string default_socket_path() {
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && *runtime_dir) {
+        return std::string(runtime_dir) + "/novashell.sock";
+    }
+    return "/tmp/novashell-" + std::to_string(getuid()) + ".sock";
+}
+
+// Whether the process at the other end of a connected Unix socket runs as
+// our own user
+inline bool peer_is_same_user(int fd) {
+#if defined(SO_PEERCRED)
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) {
+        return false;
+    }
+    return cred.uid == getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    if (getpeereid(fd, &uid, &gid) != 0) {
+        return false;
+    }
+    return uid == getuid();
+#endif
+}
+
+// Unix stream socket that programs the daemon spawns do not inherit
+inline int open_socket() {
+#ifdef SOCK_CLOEXEC
+    return ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+#else
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+#endif
+}
+
+// accept() with close-on-exec set
+inline int accept_client(int listen_fd) {
+#if defined(__linux__)
+    return ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+#else
+    int fd = ::accept(listen_fd, nullptr, nullptr);
+    if (fd >= 0) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+#endif
+}
+
+inline bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+#else
+        ssize_t n = ::send(fd, data, size, 0);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool read_all(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::recv(fd, data, size, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) {
+            return false;  // peer closed
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+inline bool send_frame(int fd, char type, const char* data, size_t size) {
+    while (true) {
+        uint32_t chunk = static_cast<uint32_t>(size < MAX_FRAME_SIZE ? size : MAX_FRAME_SIZE);
+        char header[5] = {
+            type,
+            static_cast<char>((chunk >> 24) & 0xff),
+            static_cast<char>((chunk >> 16) & 0xff),
+            static_cast<char>((chunk >> 8) & 0xff),
+            static_cast<char>(chunk & 0xff)
+        };
+        if (!write_all(fd, header, sizeof(header)) || !write_all(fd, data, chunk)) {
+            return false;
+        }
+        data += chunk;
+        size -= chunk;
+        if (size == 0) {
+            return true;
+        }
+    }
+}
+
+inline bool send_frame(int fd, char type, const std::string& payload) {
+    return send_frame(fd, type, payload.data(), payload.size());
+}
+
+inline bool recv_frame(int fd, char& type, std::string& payload) {
+    unsigned char header[5];
+    if (!read_all(fd, reinterpret_cast<char*>(header), sizeof(header))) {
+        return false;
+    }
+    uint32_t size = (static_cast<uint32_t>(header[1]) << 24) | (static_cast<uint32_t>(header[2]) << 16) |
+                    (static_cast<uint32_t>(header[3]) << 8) | static_cast<uint32_t>(header[4]);
+    if (size > MAX_FRAME_SIZE) {
+        return false;
+    }
+    type = static_cast<char>(header[0]);
+    payload.resize(size);
+    return size == 0 || read_all(fd, &payload[0], size);
+}
+
+inline std::string encode_exit_code(int code) {
+    uint32_t value = static_cast<uint32_t>(code);
+    return std::string{
+        static_cast<char>((value >> 24) & 0xff),
+        static_cast<char>((value >> 16) & 0xff),
+        static_cast<char>((value >> 8) & 0xff),
+        static_cast<char>(value & 0xff)
+    };
+}
+
+inline int decode_exit_code(const std::string& payload) {
+    if (payload.size() != 4) {
+        return 1;
+    }
+    uint32_t value = 0;
+    for (char c : payload) {
+        value = (value << 8) | static_cast<unsigned char>(c);
+    }
+    return static_cast<int>(value);
+}
+
+} // namespace daemon_protocol
+} // namespace core
+} // namespace customos
+
+#endif // _WIN32
+
+#endif // CUSTOMOS_DAEMON_PROTOCOL_H
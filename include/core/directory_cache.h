@@ -0,0 +1,92 @@
+#ifndef CUSTOMOS_DIRECTORY_CACHE_H
+#define CUSTOMOS_DIRECTORY_CACHE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+namespace customos {
+namespace core {
+
+// One directory's entries, sorted case-insensitively (ties by exact name)
+// so both kinds of prefix lookup are a binary search. Immutable once built.
+struct DirectoryListing {
+    std::vector<std::string> names;
+    std::vector<bool> is_directory;
+    std::vector<uint64_t> masks;  // FuzzyMatcher::char_mask of each name
+
+    // [first, last) of names starting with `prefix` ignoring case; callers
+    // wanting an exact-case match filter this range
+    std::pair<size_t, size_t> prefix_range(const std::string& prefix) const;
+};
+
+// Directory listings for file completion, keyed by absolute path.
+// A listing is read once and reused until the directory changes: on Linux
+// an inotify watch per cached directory marks it stale (pending events are
+// read, without blocking, on the next lookup); elsewhere, or when a watch
+// cannot be added, a listing is trusted for REVALIDATE_INTERVAL and then
+// checked against the directory's modification time. `cd` records the new
+// working directory here and reads its listing on a pool worker, so the
+// first Tab after it is already warm.
+class DirectoryCache {
+public:
+    static constexpr size_t MAX_DIRECTORIES = 64;
+    static constexpr std::chrono::milliseconds REVALIDATE_INTERVAL{2000};
+
+    static DirectoryCache& instance();
+
+    // Listing of `path` (relative to the working directory), or null if it
+    // cannot be read
+    std::shared_ptr<const DirectoryListing> get(const std::string& path);
+
+    // Read a listing in the background
+    void prefetch(const std::string& path);
+
+    // Working directory as last set through change_directory(); read from
+    // the process once, not on every keystroke
+    std::string current_directory();
+
+    // chdir the whole process and prefetch the new directory; false if it
+    // cannot be entered. For the interactive shell only.
+    bool change_directory(const std::string& path);
+
+    void clear();
+
+private:
+    DirectoryCache();
+    ~DirectoryCache();
+    DirectoryCache(const DirectoryCache&) = delete;
+    DirectoryCache& operator=(const DirectoryCache&) = delete;
+
+    struct Slot {
+        std::shared_ptr<const DirectoryListing> listing;
+        int watch = -1;  // inotify watch descriptor, -1 if unwatched
+        int64_t modified = 0;
+        std::chrono::steady_clock::time_point checked;
+        uint64_t last_used = 0;
+        uint64_t epoch = 0;  // bumped whenever the listing is invalidated
+    };
+
+    std::string absolute(const std::string& path);
+    static std::shared_ptr<const DirectoryListing> read_listing(const std::string& path);
+    static int64_t modified_time(const std::string& path);
+    void drain_events();  // mutex_ held
+    void evict();         // mutex_ held
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, Slot> slots_;
+    std::unordered_map<int, std::string> watched_;  // watch descriptor -> path
+    std::string cwd_;
+    uint64_t clock_;
+    int inotify_fd_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_DIRECTORY_CACHE_H
@@ -0,0 +1,86 @@
+#ifndef CUSTOMOS_EXTERNAL_COMMAND_H
+#define CUSTOMOS_EXTERNAL_COMMAND_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "command_registry.h"
+
+namespace customos {
+namespace core {
+
+// Name -> executable table for $PATH.
+// Built by listing each PATH directory once and rebuilt when PATH changes
+// or one of its directories is modified, so a lookup costs one stat() per
+// PATH entry plus a hash probe, and unknown names never touch the disk
+// beyond that.
+class PathCache {
+public:
+    static PathCache& instance();
+
+    // Full path of the program `name` runs under the given PATH, or "".
+    // Names containing '/' are used as given.
+    std::string resolve(const std::string& name, const std::string& path_env);
+
+    // Forget the table; the next lookup rebuilds it
+    void invalidate();
+
+    size_t size() const;
+
+private:
+    PathCache() = default;
+    PathCache(const PathCache&) = delete;
+    PathCache& operator=(const PathCache&) = delete;
+
+    struct Directory {
+        std::string path;
+        int64_t mtime_ns;  // -1 if it did not exist
+    };
+
+    bool is_stale(const std::string& path_env) const;
+    void rebuild(const std::string& path_env);
+
+    mutable std::mutex mutex_;
+    bool valid_ = false;
+    std::string path_env_;
+    std::vector<Directory> directories_;
+    std::unordered_map<std::string, std::string> table_;  // first PATH match wins
+};
+
+// While alive, the interactive shell ignores Ctrl-C and Ctrl-\ so they
+// reach only the foreground programs, which share its process group.
+// Scopes nest: a pipeline holds one until its last stage has finished.
+class ForegroundSignals {
+public:
+    ForegroundSignals();
+    ~ForegroundSignals();
+    ForegroundSignals(const ForegroundSignals&) = delete;
+    ForegroundSignals& operator=(const ForegroundSignals&) = delete;
+};
+
+// Runs programs that are not registered commands
+class ExternalCommand {
+public:
+    // Spawn the program (posix_spawn, no intermediate /bin/sh) and wait.
+    //  stdin:  context.input when set, the shell's own stdin for a
+    //          foreground command of the interactive shell, else /dev/null
+    //  stdout: the sink's native fd when it has one (terminal, '>' file),
+    //          otherwise a pipe pumped into the sink
+    //  stderr: inherited
+    // When the program has the shell's stdin, the shell ignores Ctrl-C and
+    // Ctrl-\ while it runs (pipelines do so for all their stages). A killed
+    // job sends the program's process group SIGTERM, then SIGKILL after
+    // KILL_GRACE_MS. Returns its exit status, 128+N when it died from
+    // signal N, or 126/127 if it could not start.
+    static int run(const std::string& path, const std::vector<std::string>& argv,
+                   const CommandContext& context, const std::string& working_directory, bool interactive);
+
+    static constexpr int KILL_GRACE_MS = 1000;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_EXTERNAL_COMMAND_H
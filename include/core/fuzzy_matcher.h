@@ -0,0 +1,81 @@
+#ifndef CUSTOMOS_FUZZY_MATCHER_H
+#define CUSTOMOS_FUZZY_MATCHER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace customos {
+namespace core {
+
+// fzf-style subsequence matcher for completion candidates.
+// Candidates go through three stages, each cheaper than the next:
+//   1. a 64-bit character mask rejects text lacking any pattern character;
+//   2. an in-order scan (SSE2, 16 bytes per step) rejects text where the
+//      characters occur but not as a subsequence, and finds the end of the
+//      leftmost match;
+//   3. only real matches are scored, over the shortest window ending there.
+// Scores reward word boundaries, camelCase humps and consecutive runs and
+// penalize gaps, so "gst" ranks "git-status" above "gist-settings".
+class FuzzyMatcher {
+public:
+    static constexpr int SCORE_MATCH = 16;
+    static constexpr int SCORE_GAP_START = -3;
+    static constexpr int SCORE_GAP_EXTENSION = -1;
+    static constexpr int BONUS_BOUNDARY = 8;     // after '/', '-', '_', '.', ' ' or at the start
+    static constexpr int BONUS_CAMEL = 7;        // lower-to-upper transition
+    static constexpr int BONUS_CONSECUTIVE = 4;  // per character continuing a run
+    static constexpr int FIRST_CHAR_MULTIPLIER = 2;
+
+    struct Ranked {
+        size_t index;  // into the candidate list
+        int score;
+    };
+
+    explicit FuzzyMatcher(const std::string& pattern, bool case_sensitive = false);
+
+    // Case-folded presence mask of a text; cache it for candidates reused
+    // across keystrokes
+    static uint64_t char_mask(std::string_view text);
+
+    // Stage 1: true when the text cannot match
+    bool rejects(uint64_t text_mask) const { return (pattern_mask_ & ~text_mask) != 0; }
+
+    // Score, or -1 when the pattern is not a subsequence of the text.
+    // `positions`, when given, receives the matched byte offsets.
+    int score(std::string_view text, std::vector<size_t>* positions = nullptr) const;
+
+    // Best `limit` matches, highest score first (shorter text breaks ties)
+    std::vector<Ranked> rank(const std::vector<std::string>& candidates, size_t limit) const;
+
+    // Same, with char_mask() of each candidate precomputed by the caller
+    std::vector<Ranked> rank(const std::vector<std::string>& candidates, const std::vector<uint64_t>& masks,
+                             size_t limit) const;
+
+    // Highest score a text can get for this pattern; for normalizing
+    int max_score() const;
+
+    const std::string& pattern() const { return pattern_; }
+
+    // Edit distance (Myers' bit-parallel algorithm for patterns up to 64
+    // bytes, a two-row table beyond that)
+    static size_t levenshtein(std::string_view a, std::string_view b);
+
+    // Smallest edit distance between `pattern` and any prefix of `text`,
+    // for typo-tolerant completion ("gti-st" against "git-status")
+    static size_t prefix_distance(std::string_view pattern, std::string_view text);
+
+private:
+    size_t find_from(std::string_view text, size_t from, size_t pattern_index) const;
+
+    std::string pattern_;       // folded unless case-sensitive
+    std::string pattern_upper_; // the other case of each byte, or the same byte
+    uint64_t pattern_mask_;
+    bool case_sensitive_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_FUZZY_MATCHER_H
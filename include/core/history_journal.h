@@ -0,0 +1,103 @@
+#ifndef CUSTOMOS_HISTORY_JOURNAL_H
+#define CUSTOMOS_HISTORY_JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+
+namespace customos {
+namespace core {
+
+struct JournalEntry {
+    uint64_t sequence;  // global append order across sessions
+    int64_t timestamp;  // Unix seconds
+    std::string command;
+    std::string user;
+    std::string origin;  // "local", "daemon", "mobile", ...
+};
+
+// Process-wide history of commands from every session.
+// Each producing thread owns a lane: a chain of fixed-size segments it
+// fills and publishes with a release store, so appends never take a lock
+// or wait on another session. Lanes outlive their threads and are adopted
+// by new ones. Readers merge the lanes' published entries by sequence;
+// repeats are only collapsed when read or persisted. A single drain task
+// on the WorkerPool writes new entries to the SQLite history table in
+// groups. A batch the database rejects stays pending and is retried once
+// per GROUP_COMMIT_INTERVAL; a lane drops its oldest entries only past
+// MAX_SEGMENTS.
+class HistoryJournal {
+public:
+    static constexpr size_t SEGMENT_SIZE = 256;
+    static constexpr size_t RETAINED_SEGMENTS = 8;  // per lane, once persisted
+    static constexpr size_t MAX_SEGMENTS = 64;      // per lane, persisted or not
+    static constexpr size_t GROUP_COMMIT_SIZE = 64;
+    static constexpr std::chrono::seconds GROUP_COMMIT_INTERVAL{2};
+
+    static HistoryJournal& instance();
+
+    // Lock-free for the caller; may queue a drain on the WorkerPool
+    void append(const std::string& command, const std::string& user, const std::string& origin);
+
+    // The newest `count` entries across all sessions, oldest first. With
+    // `unique`, only the latest run of each command is kept.
+    std::vector<JournalEntry> merged(size_t count, bool unique = false) const;
+
+    // Persist everything appended so far
+    void flush();
+
+    // Called by the drain before each SQLite batch (e.g. to sync a log file)
+    void set_sync_hook(std::function<void()> hook);
+
+    // Entries not yet persisted
+    size_t pending() const;
+
+private:
+    struct Segment {
+        uint64_t base;  // lane index of entries[0]
+        JournalEntry entries[SEGMENT_SIZE];
+        std::shared_ptr<Segment> next;  // accessed with std::atomic_load/store
+    };
+
+    struct Lane {
+        std::shared_ptr<Segment> head;  // oldest retained; std::atomic_load/store
+        Segment* tail = nullptr;        // owner only
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> persisted{0};
+        std::atomic<bool> owned{false};
+        std::string last_persisted;     // drain only
+        Lane* next = nullptr;           // immutable once the lane is listed
+    };
+
+    HistoryJournal();
+    ~HistoryJournal();
+    HistoryJournal(const HistoryJournal&) = delete;
+    HistoryJournal& operator=(const HistoryJournal&) = delete;
+
+    Lane* acquire_lane();
+    void trim(Lane* lane);
+    void maybe_schedule_drain(const Lane* lane);
+    void drain();
+
+    template <typename Visit>
+    static void visit_range(const Lane* lane, uint64_t from, uint64_t to, Visit visit);
+
+    std::atomic<Lane*> lanes_;
+    std::atomic<uint64_t> next_sequence_;
+    std::atomic<int64_t> last_drain_ms_;
+    std::atomic<bool> drain_scheduled_;
+    std::atomic<bool> retrying_;  // the last batch failed
+
+    std::mutex drain_mutex_;  // drains only; appends never take it
+    std::function<void()> sync_hook_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_HISTORY_JOURNAL_H
@@ -0,0 +1,89 @@
+#ifndef CUSTOMOS_HISTORY_SEARCH_H
+#define CUSTOMOS_HISTORY_SEARCH_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <string_view>
+#include <mutex>
+#include <cstdint>
+
+namespace customos {
+namespace core {
+
+// Substring index over history for reverse-i-search (Ctrl-R).
+// Each distinct command is stored once, with the sequence number of its
+// latest run, in a recency list and in trigram posting lists. A query's
+// candidates come from the postings of its rarest trigram (two-character
+// queries use the trigrams that extend them), confirmed with a substring
+// check. When even the rarest trigram is common, matches are usually dense
+// and a bounded walk of the recency list finds one first. Characters that
+// occur in no line fail a query without any scan. A Cursor carries the
+// confirmed candidates between keystrokes, so typing another character
+// only filters the previous result.
+class HistorySearchIndex {
+public:
+    static constexpr uint64_t NEWEST = UINT64_MAX;
+
+    // Per-search state, reused across keystrokes and repeated Ctrl-R
+    struct Cursor {
+        std::string query;
+        std::vector<uint32_t> candidates;
+        bool has_candidates = false;
+        uint64_t generation = 0;
+    };
+
+    HistorySearchIndex();
+
+    // Record a run of `command` (the newest so far)
+    void add(const std::string& command);
+
+    // Newest command containing `query` whose latest run is older than
+    // `before` (NEWEST, or the sequence of the previous match to step
+    // further back). Returns false when there is none.
+    bool find(const std::string& query, uint64_t before, Cursor& cursor,
+              std::string& command, uint64_t& sequence) const;
+
+    size_t unique_count() const;
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Larger candidate sets are not built; the recency walk is used instead
+    static constexpr size_t MAX_CANDIDATES = 16384;
+
+    // Lines the recency walk checks before falling back to the postings
+    static constexpr size_t MAX_WALK = 4096;
+
+    struct Line {
+        std::string text;
+        uint64_t last_seq;
+        uint32_t newer;  // recency list
+        uint32_t older;
+    };
+
+    void unlink(uint32_t id);
+    void push_newest(uint32_t id);
+    bool collect_candidates(const std::string& query, std::vector<uint32_t>& candidates) const;
+    const std::vector<uint32_t>* rarest_postings(const std::string& query) const;  // null if a trigram is absent
+    void verify(const std::vector<uint32_t>& ids, const std::string& query, std::vector<uint32_t>& candidates) const;
+    bool walk_recency(std::string_view query, uint64_t before, uint32_t& best) const;
+
+    mutable std::mutex mutex_;
+    std::deque<Line> lines_;  // stable addresses: by_text_ keys view into them
+    std::unordered_map<std::string_view, uint32_t> by_text_;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> postings_;  // ascending ids
+    std::vector<uint32_t> char_lines_;    // distinct lines containing each byte
+    std::vector<uint32_t> bigram_lines_;  // ... and each byte pair
+    std::vector<uint32_t> char_stamp_;    // last line id + 1 counted in char_lines_
+    std::vector<uint32_t> bigram_stamp_;
+    uint32_t newest_;
+    uint64_t next_seq_;
+    uint64_t generation_;  // bumped on every add; invalidates cursors
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_HISTORY_SEARCH_H
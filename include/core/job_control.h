@@ -0,0 +1,133 @@
+#ifndef CUSTOMOS_JOB_CONTROL_H
+#define CUSTOMOS_JOB_CONTROL_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include "output_sink.h"
+
+namespace customos {
+namespace core {
+
+// Fixed-size pool of worker threads shared by background work
+class WorkerPool {
+public:
+    static WorkerPool& instance();
+
+    // Queue a task; threads are started on first use
+    void submit(std::function<void()> task);
+
+    size_t thread_count() const;
+
+private:
+    WorkerPool();
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void start_threads();
+    void worker_loop();
+
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> tasks_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_;
+    size_t size_;
+};
+
+enum class JobState {
+    QUEUED,
+    RUNNING,
+    DONE,
+    KILLED
+};
+
+// Point-in-time view of a job for display
+struct JobInfo {
+    int id;
+    std::string command;
+    JobState state;
+    int exit_code;
+    double wall_ms;   // time spent running (so far, if still running)
+    double cpu_ms;    // CPU time of the job's worker thread
+    size_t output_bytes;
+};
+
+// A finished job taken out of the table, with its captured output
+struct FinishedJob {
+    JobInfo info;
+    std::string output;
+};
+
+// Background job table used by '&', jobs, fg, wait and kill
+class JobTable {
+public:
+    using JobWork = std::function<int(OutputSink& output)>;
+
+    static JobTable& instance();
+
+    // Run work on the worker pool; its output is captured per job
+    int start(const std::string& command, JobWork work);
+
+    std::vector<JobInfo> list() const;
+    bool exists(int id) const;
+    int latest_id() const;
+
+    // Block until the job finishes; false if there is no such job
+    bool wait(int id, JobInfo& info);
+    void wait_all();
+
+    // kill_all, then wait up to STOP_GRACE_MS. False if some job ignored
+    // cancellation and still runs (a built-in that never polls cancelled())
+    bool stop_all();
+    static constexpr int STOP_GRACE_MS = 3000;
+
+    // Take the captured output of a finished job and forget the job
+    bool collect(int id, JobInfo& info, std::string& output);
+
+    // Request cancellation: queued jobs never start, running jobs see
+    // CommandContext::cancelled() turn true
+    bool kill(int id);
+    void kill_all();
+
+    // Take every finished job out of the table with its output, oldest
+    // first (for the prompt's notifications and jobs)
+    std::vector<FinishedJob> reap_finished();
+
+    // "[N] Done (exit 0)  command"
+    static std::string status_line(const JobInfo& info);
+
+    // Cancellation flag of the job running on the calling thread, if any
+    static std::shared_ptr<std::atomic<bool>> current_cancel_flag();
+
+    static std::string state_to_string(JobState state);
+
+private:
+    JobTable();
+    ~JobTable();
+    JobTable(const JobTable&) = delete;
+    JobTable& operator=(const JobTable&) = delete;
+
+    struct Job;
+    void run(const std::shared_ptr<Job>& job, const JobWork& work);
+    static JobInfo describe(const Job& job);
+    bool all_finished() const;
+
+    std::map<int, std::shared_ptr<Job>> jobs_;
+    mutable std::mutex mutex_;
+    std::condition_variable finished_cv_;
+    int next_id_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_JOB_CONTROL_H
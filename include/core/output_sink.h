@@ -0,0 +1,82 @@
+#ifndef CUSTOMOS_OUTPUT_SINK_H
+#define CUSTOMOS_OUTPUT_SINK_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <streambuf>
+#include <cstdio>
+#include "command_stream.h"
+
+namespace customos {
+namespace core {
+
+// Chunked, pre-sized output buffer for a single command.
+// Handlers write into it directly or through std::cout (see OutputRouter).
+// A sink with a drain hands each filled chunk to the drain in place and then
+// reuses it; a sink without a drain keeps every chunk for take().
+class OutputSink : public std::streambuf {
+public:
+    // Receives buffered bytes; returns false when the destination is gone
+    using Drain = std::function<bool(const char* data, size_t size)>;
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 16 * 1024;
+
+    // flush_on_sync: drain on std::flush/std::endl (needed for interactive
+    // prompts); otherwise only on explicit flush() or when a chunk fills up
+    explicit OutputSink(Drain drain = Drain(), size_t chunk_size = DEFAULT_CHUNK_SIZE,
+                        bool flush_on_sync = false);
+    ~OutputSink() override;
+
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+
+    // Append raw bytes
+    void write(const char* data, size_t size);
+    void write(const std::string& text);
+
+    // Explicit flush point: hand all buffered chunks to the drain
+    bool flush();
+
+    // Move the buffered output out (no copy when it fits in one chunk)
+    std::string take();
+
+    size_t buffered_bytes() const;
+    size_t total_bytes() const { return total_bytes_ + current_used(); }
+    bool broken() const { return broken_; }
+
+    // File descriptor the drain writes to unchanged (terminal, '>' file),
+    // or -1. After flush(), a child process may write to it directly.
+    void set_native_fd(int fd) { native_fd_ = fd; }
+    int native_fd() const { return native_fd_; }
+
+    // Drains for the common destinations
+    static Drain to_streambuf(std::streambuf* target);
+    static Drain to_file(std::FILE* file);
+    static Drain to_stream(std::shared_ptr<CommandStream> stream);
+
+protected:
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    int sync() override;
+
+private:
+    size_t current_used() const { return static_cast<size_t>(pptr() - pbase()); }
+    void seal_current();
+    void start_chunk();
+
+    Drain drain_;
+    size_t chunk_size_;
+    bool flush_on_sync_;
+    bool broken_;
+    std::vector<std::string> chunks_;  // sealed chunks, trimmed to their used size
+    std::string current_;              // chunk backing the put area
+    size_t total_bytes_;
+    int native_fd_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_OUTPUT_SINK_H
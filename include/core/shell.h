@@ -3,6 +3,7 @@
 
 #include <string>
 #include <memory>
+#include <istream>
 #include "command_processor.h"
 #include "../auth/authentication.h"
 #include "../logging/logger.h"
@@ -24,8 +25,20 @@ public:
     // Execute a single command
     bool execute_command(const std::string& command);
 
-    // Shutdown the shell
-    void shutdown();
+    // Non-interactive mode: run every line of a script or pipe without
+    // terminal setup, then print aggregate timings to stderr. Returns the
+    // process exit status (non-zero if any command failed).
+    int run_batch(std::istream& input, const std::string& source);
+
+    // Shutdown the shell. False if a background job ignored cancellation and
+    // still runs shell code; the caller should then leave with std::_Exit
+    // rather than run static destructors under it.
+    bool shutdown();
+
+    // Async-signal-safe, for SIGINT/SIGTERM handlers: puts the terminal
+    // back and makes run() and run_batch() return; the caller then calls
+    // shutdown() outside the handler
+    static void request_stop();
 
     // Get current prompt
     std::string get_prompt() const;
@@ -33,6 +46,9 @@ public:
     // Set custom prompt
     void set_prompt(const std::string& prompt);
 
+    // Command processor shared with the daemon server
+    CommandProcessor* get_command_processor();
+
 private:
     void display_welcome();
     void show_help();
@@ -40,6 +56,7 @@ private:
     void save_history();
     std::string read_input();
     std::string read_input_with_completion();
+    bool reverse_search(std::string& line);  // Ctrl-R; true if Enter accepted the match
     void handle_signal(int signal);
 
     std::unique_ptr<CommandProcessor> command_processor_;
@@ -47,8 +64,8 @@ private:
     std::string prompt_;
     bool running_;
     bool initialized_;
-    std::vector<std::string> command_history_;
-    int history_index_;
+    bool interactive_;   // in run(); only then does a command feed learning
+    int history_index_;  // position while browsing history with the arrow keys
 };
 
 } // namespace core
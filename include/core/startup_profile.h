@@ -0,0 +1,94 @@
+#ifndef CUSTOMOS_STARTUP_PROFILE_H
+#define CUSTOMOS_STARTUP_PROFILE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <chrono>
+#include <ostream>
+
+namespace customos {
+namespace core {
+
+// Per-phase timing of shell startup and of subsystems initialized later on
+// first use. Always recorded (a few clock reads); printed by --startup-profile.
+class StartupProfile {
+public:
+    struct Entry {
+        std::string phase;
+        double start_ms;     // offset from process start
+        double duration_ms;
+    };
+
+    static StartupProfile& instance();
+
+    void set_enabled(bool enabled);
+    bool is_enabled() const;
+
+    void record(const std::string& phase, std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end);
+    std::vector<Entry> entries() const;
+
+    // Print the breakdown (no-op unless enabled)
+    void report(std::ostream& out) const;
+
+    // Times the enclosing scope as one phase
+    class Phase {
+    public:
+        explicit Phase(const std::string& name);
+        ~Phase();
+
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+
+    private:
+        std::string name_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+private:
+    StartupProfile();
+    StartupProfile(const StartupProfile&) = delete;
+    StartupProfile& operator=(const StartupProfile&) = delete;
+
+    std::chrono::steady_clock::time_point origin_;
+    std::vector<Entry> entries_;
+    bool enabled_;
+    mutable std::mutex mutex_;
+};
+
+// Subsystems whose singletons, database tables or threads are set up on
+// first use instead of during Shell::initialize. Commands name the
+// subsystem they need (CommandInfo::subsystem) and the registry calls
+// ensure() before dispatching to them.
+class LazySubsystems {
+public:
+    using Initializer = std::function<bool()>;
+
+    static LazySubsystems& instance();
+
+    // Register how to bring a subsystem up; cheap, nothing runs yet
+    void add(const std::string& name, Initializer init);
+
+    // Run the initializer exactly once; later calls return its result
+    bool ensure(const std::string& name);
+
+    bool is_ready(const std::string& name) const;
+
+private:
+    LazySubsystems() = default;
+    LazySubsystems(const LazySubsystems&) = delete;
+    LazySubsystems& operator=(const LazySubsystems&) = delete;
+
+    struct Subsystem;
+    std::map<std::string, std::shared_ptr<Subsystem>> subsystems_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_STARTUP_PROFILE_H
@@ -0,0 +1,90 @@
+#ifndef CUSTOMOS_SUGGESTION_CACHE_H
+#define CUSTOMOS_SUGGESTION_CACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+
+namespace customos {
+namespace core {
+
+// Cache of AI completion suggestions.
+// Entries are keyed by a 64-bit hash of the normalized request (the typed
+// text with whitespace collapsed, plus the working directory). A bounded
+// LRU of MEMORY_ENTRIES sits in front of an append-only file that keeps up
+// to DISK_ENTRIES more across sessions; the file is compacted on open.
+// A miss on "git ch" falls back to the longest cached prefix ("git c",
+// "git ") whose suggestions still start with the typed text.
+// Thread-safe.
+class SuggestionCache {
+public:
+    static constexpr size_t MEMORY_ENTRIES = 256;
+    static constexpr size_t DISK_ENTRIES = 4096;
+    static constexpr std::chrono::hours TTL{24};
+
+    struct Stats {
+        uint64_t hits = 0;         // exact, in memory
+        uint64_t disk_hits = 0;    // exact, read back from the file
+        uint64_t prefix_hits = 0;  // answered from a shorter prefix
+        uint64_t misses = 0;
+        uint64_t evictions = 0;    // dropped from memory by the LRU
+        size_t memory_entries = 0;
+        size_t disk_entries = 0;
+    };
+
+    SuggestionCache();
+    ~SuggestionCache();
+    SuggestionCache(const SuggestionCache&) = delete;
+    SuggestionCache& operator=(const SuggestionCache&) = delete;
+
+    // Index (and compact) the cache file; without it the cache is memory-only
+    bool open(const std::string& path);
+
+    // Suggestions for `typed` in `directory`; false on a miss
+    bool find(const std::string& typed, const std::string& directory, std::vector<std::string>& suggestions);
+
+    void store(const std::string& typed, const std::string& directory, const std::vector<std::string>& suggestions);
+
+    Stats stats() const;
+
+    static std::string normalize(const std::string& typed);
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::string typed;  // normalized, to reject hash collisions
+        std::vector<std::string> suggestions;
+        int64_t created;    // Unix seconds
+    };
+
+    struct DiskRecord {
+        uint64_t offset;
+        uint32_t length;
+        int64_t created;
+    };
+
+    static uint64_t hash_key(const std::string& normalized, const std::string& directory);
+    static bool expired(int64_t created);
+
+    // mutex_ held
+    bool lookup(uint64_t key, const std::string& normalized, std::vector<std::string>& suggestions, bool& from_disk);
+    void insert_memory(Entry entry);
+    bool read_record(const DiskRecord& record, Entry& entry) const;
+    void append_record(const Entry& entry);
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_;  // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> memory_;
+    std::unordered_map<uint64_t, DiskRecord> disk_;
+    std::string path_;
+    Stats stats_;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_SUGGESTION_CACHE_H
@@ -5,16 +5,31 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include "suggestion_cache.h"
 
 namespace customos {
 namespace core {
 
+class CommandRegistry;
+
 // Completion match
 struct CompletionMatch {
     std::string text;
     std::string description;
     std::string display;
     int priority;  // Higher = shown first
+    int score = 0; // Fuzzy match quality; orders matches of equal priority
+};
+
+// Matching settings; each completion works from its own copy, so providers
+// still running when a setter is called see one consistent set
+struct CompletionSettings {
+    bool case_sensitive = false;
+    bool fuzzy_matching = false;
+    int max_suggestions = 20;
 };
 
 // Completion context
@@ -26,6 +41,8 @@ struct CompletionContext {
     std::string partial_word;
     std::string current_directory;
     std::string current_user;
+    std::function<bool()> is_stale;  // true once a newer completion has started
+    CompletionSettings settings;     // as of the complete() call
 };
 
 // Completion provider interface
@@ -34,11 +51,21 @@ public:
     virtual ~ICompletionProvider() = default;
     virtual std::vector<CompletionMatch> get_completions(const CompletionContext& context) = 0;
     virtual std::string get_name() const = 0;
+
+    // Providers that can wait on the network run on their own thread, one
+    // request at a time; a request still queued when a newer one arrives
+    // is dropped
+    virtual bool may_block() const { return false; }
 };
 
 // Tab Completion Engine
+// Providers run concurrently and complete() returns whatever has arrived
+// by the deadline. Results that arrive later are not lost: the AI provider
+// caches them, so the next Tab on the same line shows them at once.
 class TabCompletion {
 public:
+    static constexpr std::chrono::milliseconds DEFAULT_DEADLINE{30};
+
     static TabCompletion& instance();
 
     // Initialize completion system
@@ -50,25 +77,34 @@ public:
     // Get single best match
     std::string complete_single(const std::string& line, int cursor_position);
 
+    // Command names are completed from this registry's index
+    void set_command_registry(const CommandRegistry* registry);
+
+    // Drop queued provider requests and join the blocking providers'
+    // runner threads; call before the shell tears down what they use
+    void shutdown();
+
     // Register custom completion providers
     bool register_provider(std::shared_ptr<ICompletionProvider> provider);
     bool unregister_provider(const std::string& name);
 
-    // Built-in completers
-    std::vector<CompletionMatch> complete_commands(const std::string& prefix);
-    std::vector<CompletionMatch> complete_files(const std::string& prefix);
-    std::vector<CompletionMatch> complete_directories(const std::string& prefix);
+    // Built-in completers, matching with the settings of the calling context
+    std::vector<CompletionMatch> complete_commands(const std::string& prefix, const CompletionSettings& settings);
+    std::vector<CompletionMatch> complete_files(const std::string& prefix, const CompletionSettings& settings);
+    std::vector<CompletionMatch> complete_directories(const std::string& prefix, const CompletionSettings& settings);
     std::vector<CompletionMatch> complete_users(const std::string& prefix);
     std::vector<CompletionMatch> complete_environment_vars(const std::string& prefix);
-    std::vector<CompletionMatch> complete_git_branches(const std::string& prefix);
-    std::vector<CompletionMatch> complete_db_tables(const std::string& prefix);
-    std::vector<CompletionMatch> complete_db_columns(const std::string& table, const std::string& prefix);
+    std::vector<CompletionMatch> complete_git_branches(const std::string& prefix, const CompletionSettings& settings);
+    std::vector<CompletionMatch> complete_db_tables(const std::string& prefix, const CompletionSettings& settings);
+    std::vector<CompletionMatch> complete_db_columns(const std::string& table, const std::string& prefix,
+                                                     const CompletionSettings& settings);
     std::vector<CompletionMatch> complete_plugins(const std::string& prefix);
 
     // Configuration
     void set_case_sensitive(bool sensitive);
     void set_fuzzy_matching(bool enabled);
     void set_max_suggestions(int max);
+    void set_deadline(std::chrono::milliseconds deadline);
 
     // History-based completion
     void add_to_history(const std::string& command);
@@ -87,8 +123,14 @@ public:
 
     // Learning system
     void learn_from_command(const std::string& command, const std::string& previous_command = "");
+    void set_learning_path(const std::string& base_path);  // before initialize()
     void load_learning_data();
 
+    // Most used commands, for statistics
+    std::vector<std::pair<std::string, uint32_t>> learned_command_counts(size_t limit);
+
+    SuggestionCache::Stats ai_cache_stats() const;
+
 private:
     TabCompletion();
     ~TabCompletion();
@@ -129,6 +171,7 @@ class AICompletionProvider : public ICompletionProvider {
 public:
     std::vector<CompletionMatch> get_completions(const CompletionContext& context) override;
     std::string get_name() const override { return "ai"; }
+    bool may_block() const override { return true; }
 };
 
 class LearningCompletionProvider : public ICompletionProvider {
@@ -0,0 +1,71 @@
+#ifndef CUSTOMOS_TOKENIZER_H
+#define CUSTOMOS_TOKENIZER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+namespace customos {
+namespace core {
+
+enum class TokenType {
+    WORD,
+    PIPE,             // |
+    REDIRECT_IN,      // <
+    REDIRECT_OUT,     // >
+    REDIRECT_APPEND,  // >>
+    BACKGROUND        // &
+};
+
+struct Token {
+    TokenType type;
+    std::string_view text;
+};
+
+// Single-pass command-line tokenizer.
+// Handles 'single' and "double" quotes, backslash escapes, $VAR and ${VAR}
+// expansion (not inside single quotes) and the | < > >> & operators.
+// Word text is unescaped and expanded into one arena owned by the
+// tokenizer; tokens are views into it and stay valid until the next
+// tokenize() call. A tokenizer that is reused does not allocate once its
+// buffers have grown to the longest line seen.
+class Tokenizer {
+public:
+    // Resolve a variable name; return false if it is unset (expands to "")
+    using VariableLookup = std::function<bool(std::string_view name, std::string_view& value)>;
+
+    Tokenizer() = default;
+
+    // Tokenize a line. Returns false on a syntax error (see error()).
+    // A quote without a closing partner is taken literally, so free text
+    // such as "what's this" still works.
+    bool tokenize(std::string_view line, const VariableLookup& lookup = VariableLookup());
+
+    const std::vector<Token>& tokens() const { return tokens_; }
+    const std::string& error() const { return error_; }
+
+private:
+    struct Span {
+        TokenType type;
+        size_t offset;
+        size_t length;
+    };
+
+    void begin_word();
+    void end_word();
+    void push_operator(TokenType type);
+    size_t expand_variable(std::string_view line, size_t dollar, const VariableLookup& lookup);
+
+    std::string arena_;
+    std::vector<Span> spans_;
+    std::vector<Token> tokens_;
+    std::string error_;
+    bool in_word_ = false;
+    size_t word_start_ = 0;
+};
+
+} // namespace core
+} // namespace customos
+
+#endif // CUSTOMOS_TOKENIZER_H
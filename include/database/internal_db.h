@@ -6,10 +6,18 @@
 #include <memory>
 #include <map>
 #include <cstdint>
+#include "../logging/logger.h"
 
 namespace customos {
 namespace database {
 
+// One command for add_history_batch
+struct HistoryRow {
+    std::string command;
+    std::string user;
+    int64_t timestamp;  // Unix seconds
+};
+
 // Internal SQLite database for system metadata
 // Used for: logs, plugin index, config, user data, history, cache
 class InternalDB {
@@ -22,6 +30,7 @@ public:
 
     // Command history
     bool add_history(const std::string& command, const std::string& user);
+    bool add_history_batch(const std::vector<HistoryRow>& rows);  // one statement, one transaction
     std::vector<std::string> get_history(int limit = 100);
     std::vector<std::string> search_history(const std::string& query);
     bool clear_history();
@@ -138,10 +147,17 @@ public:
     bool end_session(const std::string& session_id);
     std::vector<std::string> get_active_sessions();
 
-    // Audit logging (internal)
-    bool log_audit(const std::string& user, const std::string& action, const std::string& details);
+    // Audit logging (internal), kept in the logger's audit journal. False
+    // when the journal is closed or has failed, so the entry is not durable.
+    bool log_audit(const std::string& user, const std::string& action, const std::string& details,
+                   logging::AuditEventType event_type, bool success);
     std::vector<std::string> get_audit_log(int limit = 100);
 
+    // Group many writes into one transaction (a single journal sync instead
+    // of one per statement). Calls nest; only the outermost commit writes.
+    bool begin_transaction();
+    bool commit_transaction();
+
     // Database maintenance
     bool vacuum();
     bool backup(const std::string& backup_path);
@@ -0,0 +1,109 @@
+#ifndef CUSTOMOS_AUDIT_TRAIL_H
+#define CUSTOMOS_AUDIT_TRAIL_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include "logger.h"
+
+namespace customos {
+namespace logging {
+
+// Durable, append-only audit journal.
+// The file starts with "NSAJ", a version byte and the hash algorithm, and
+// then holds records:
+//   u32 length | payload | 32-byte chain hash
+//   payload: u64 sequence | i64 timestamp | u8 event type | u8 success |
+//            u16 length + bytes for user, action, target and details
+// A record's chain hash is the hash of the previous record's chain hash (zeros
+// for the first record) followed by its payload. Editing, removing or
+// reordering records therefore breaks the chain from that record onward.
+// append() only queues the entry. A committer thread writes whatever has
+// built up in one write and one fsync, once GROUP_COMMIT_SIZE entries are
+// waiting or GROUP_COMMIT_INTERVAL has passed. Several processes may share
+// one journal: a committer holds an exclusive flock on the file (POSIX),
+// indexes what the others added since its last commit, and numbers and
+// chains its batch after that. An index of record offsets lets reads seek
+// straight to the newest records.
+class AuditJournal {
+public:
+    static constexpr size_t GROUP_COMMIT_SIZE = 256;
+    static constexpr std::chrono::milliseconds GROUP_COMMIT_INTERVAL{20};
+    static constexpr size_t HASH_SIZE = 32;
+
+    AuditJournal();
+    ~AuditJournal();
+    AuditJournal(const AuditJournal&) = delete;
+    AuditJournal& operator=(const AuditJournal&) = delete;
+
+    // Index an existing journal or start a new one, then start the
+    // committer. Only a crash's leftovers are cut off the end: less than
+    // one record, a last record that stops short but is consistent so far,
+    // or a last record whose hash does not match. False, with
+    // the file left alone, if it cannot be opened, was written with a
+    // different hash algorithm or is damaged elsewhere; verify() still
+    // reports where.
+    bool open(const std::string& path);
+    void close();  // commits what is pending first
+    bool is_open() const;
+
+    // Queue an entry; it gets its sequence number when committed. False
+    // when the journal is not open or a commit has failed.
+    bool append(const AuditEntry& entry);
+
+    // Wait until everything appended so far is on disk
+    bool sync();
+
+    // Newest committed records first
+    std::vector<AuditRecord> newest(size_t count);
+
+    // Recompute the chain over the whole file, records of every process
+    // included: the sequence of the first record that does not match, or 0
+    // when the journal is intact
+    uint64_t verify();
+
+    uint64_t size() const;  // records in the journal plus entries not yet committed
+
+private:
+    struct IndexEntry {
+        uint64_t offset;  // of the record's length field
+        uint32_t length;  // payload bytes
+    };
+
+    // How the file ends past the last complete record
+    enum class Tail { CLEAN, TORN, DAMAGED };
+
+    // The caller holds the file lock and mutex_, except in open()
+    bool load_index();
+    Tail index_new_records();   // from end_offset_ on; moves chain_ along
+    bool last_record_intact();
+    bool cut_tail();            // drop the file past end_offset_
+    void commit_loop();
+
+    std::string path_;
+    int fd_;
+    std::thread committer_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable committed_;
+    std::vector<AuditEntry> pending_; // not yet handed to the committer
+    uint64_t appended_;             // entries appended through this journal
+    uint64_t durable_;              // of those, the ones on disk
+    bool sync_requested_;
+    bool stopping_;
+    bool failed_;                   // a write failed or the file is damaged;
+                                    // appends are refused
+    uint64_t end_offset_;           // end of the last indexed record
+    std::string chain_;             // hash of the last indexed record
+    std::vector<IndexEntry> index_; // index_[sequence - 1], committed records
+};
+
+} // namespace logging
+} // namespace customos
+
+#endif // CUSTOMOS_AUDIT_TRAIL_H
@@ -0,0 +1,107 @@
+#ifndef CUSTOMOS_LOG_FILE_H
+#define CUSTOMOS_LOG_FILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <future>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include "logger.h"
+
+namespace customos {
+namespace logging {
+
+// Binary log segments, "log-<sequence>.nlog" in one directory.
+// A segment starts with "NSLG" and a version byte, followed by records:
+//   0x01 name:  varint id | varint length | bytes
+//   0x02 entry: level byte | zigzag varint microseconds since the previous
+//               entry (since the epoch for the first) | varint source id |
+//               varint category id | varint length | message
+// Source and category names are interned per segment, so each segment
+// decodes on its own. A record cut short by a crash ends the segment.
+
+// A decoded entry; the views point into the segment being read
+struct LogEntryView {
+    LogLevel level;
+    int64_t time_us;
+    std::string_view source;
+    std::string_view category;
+    std::string_view message;
+};
+
+// Appends entries to the current segment and starts a new one past
+// max_segment_bytes or max_segment_age. Closed segments are compressed
+// to ".nlog.gz" in the background when built with zlib (HAVE_ZLIB).
+// The current segment is held under flock, so processes sharing the
+// directory never compress or truncate each other's open segment.
+// Not thread-safe; Logger locks.
+class LogFileWriter {
+public:
+    struct Options {
+        std::string directory;
+        size_t max_segment_bytes = 8 * 1024 * 1024;
+        std::chrono::seconds max_segment_age{24 * 60 * 60};
+        bool compress = true;
+    };
+
+    LogFileWriter();
+    ~LogFileWriter();
+    LogFileWriter(const LogFileWriter&) = delete;
+    LogFileWriter& operator=(const LogFileWriter&) = delete;
+
+    // Creates the directory and starts a new segment after any existing ones
+    bool open(const Options& options);
+    void close();
+    bool is_open() const;
+
+    // Encode into the pending buffer; flush() writes it
+    void append(LogLevel level, int64_t time_us, std::string_view source, std::string_view category,
+                std::string_view message);
+
+    // One write for everything appended since the last flush
+    bool flush();
+
+    // Close the current segment now and start the next
+    bool rotate();
+
+    // Delete segments last written before `cutoff`
+    void remove_older_than(time_t cutoff);
+
+    const std::string& directory() const { return options_.directory; }
+
+private:
+    bool start_segment();
+    uint32_t intern(std::string_view name);
+    void compress_in_background(const std::string& path);
+
+    Options options_;
+    std::FILE* file_;  // unbuffered: one fwrite is one write
+    uint64_t sequence_;
+    size_t segment_bytes_;
+    std::chrono::steady_clock::time_point segment_started_;
+    int64_t last_time_us_;
+    std::unordered_map<std::string, uint32_t> names_;
+    std::string pending_;
+    std::vector<std::future<void>> compressions_;
+};
+
+class LogFileReader {
+public:
+    // Segment files in `directory`, oldest first
+    static std::vector<std::string> segments(const std::string& directory);
+
+    // Decode one segment, ".nlog" memory-mapped or ".nlog.gz" inflated,
+    // calling `visit` per entry until it returns false. False if the file
+    // cannot be read or is not a log segment.
+    static bool scan(const std::string& path, const std::function<bool(const LogEntryView&)>& visit);
+};
+
+} // namespace logging
+} // namespace customos
+
+#endif // CUSTOMOS_LOG_FILE_H
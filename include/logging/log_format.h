@@ -0,0 +1,146 @@
+#ifndef CUSTOMOS_LOG_FORMAT_H
+#define CUSTOMOS_LOG_FORMAT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace customos {
+namespace logging {
+namespace detail {
+
+// Deferred log formatting. A call's format string and arguments are
+// encoded into a byte buffer (the queued record's message) and only
+// expanded into text by whoever writes the record:
+//   u16 format length | format | each argument in order
+// Numbers are stored as raw bytes, text as u16 length + bytes.
+
+template <typename T, typename = void>
+struct LogArg {
+    static_assert(sizeof(T) == 0, "log arguments must be numbers, bool, char or text");
+};
+
+template <>
+struct LogArg<bool> {
+    static size_t size(bool) { return 1; }
+    static char* encode(char* out, bool value) {
+        *out = value ? 1 : 0;
+        return out + 1;
+    }
+    static const char* append(const char* in, std::string& out) {
+        out += *in ? "true" : "false";
+        return in + 1;
+    }
+};
+
+template <>
+struct LogArg<char> {
+    static size_t size(char) { return 1; }
+    static char* encode(char* out, char value) {
+        *out = value;
+        return out + 1;
+    }
+    static const char* append(const char* in, std::string& out) {
+        out += *in;
+        return in + 1;
+    }
+};
+
+template <typename T>
+struct LogArg<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>>> {
+    static size_t size(T) { return sizeof(T); }
+    static char* encode(char* out, T value) {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+    static const char* append(const char* in, std::string& out) {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        out += std::to_string(value);
+        return in + sizeof(T);
+    }
+};
+
+struct LogText {
+    static constexpr size_t MAX_LENGTH = 0xFFFF;
+
+    static size_t size(std::string_view text) { return sizeof(uint16_t) + std::min(text.size(), MAX_LENGTH); }
+    static char* encode(char* out, std::string_view text) {
+        uint16_t length = static_cast<uint16_t>(std::min(text.size(), MAX_LENGTH));
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), text.data(), length);
+        return out + sizeof(length) + length;
+    }
+    static const char* append(const char* in, std::string& out) {
+        uint16_t length;
+        std::memcpy(&length, in, sizeof(length));
+        out.append(in + sizeof(length), length);
+        return in + sizeof(length) + length;
+    }
+};
+
+template <>
+struct LogArg<std::string> : LogText {};
+template <>
+struct LogArg<std::string_view> : LogText {};
+template <>
+struct LogArg<const char*> : LogText {
+    static size_t size(const char* text) { return LogText::size(text ? text : ""); }
+    static char* encode(char* out, const char* text) { return LogText::encode(out, text ? text : ""); }
+};
+template <>
+struct LogArg<char*> : LogArg<const char*> {};
+
+// Arrays (string literals) are passed on as pointers
+template <typename T>
+using LogArgType = std::decay_t<T>;
+
+template <typename... Args>
+size_t encoded_size(std::string_view format, const Args&... args) {
+    return LogText::size(format) + (LogArg<LogArgType<Args>>::size(args) + ... + 0);
+}
+
+template <typename... Args>
+void encode(char* out, std::string_view format, const std::tuple<const Args&...>& args) {
+    out = LogText::encode(out, format);
+    std::apply([&out](const Args&... values) { ((out = LogArg<LogArgType<Args>>::encode(out, values)), ...); },
+               args);
+}
+
+// Copy `format` up to the next "{}" and put the argument there; with no
+// placeholder left, the argument is appended after a space
+template <typename T>
+const char* expand_next(std::string_view& format, const char* in, std::string& out) {
+    size_t slot = format.find("{}");
+    if (slot == std::string_view::npos) {
+        out.append(format);
+        format = std::string_view();
+        out += ' ';
+    }
+    else {
+        out.append(format.substr(0, slot));
+        format.remove_prefix(slot + 2);
+    }
+    return LogArg<T>::append(in, out);
+}
+
+template <typename... Args>
+void expand(const char* data, std::string& out) {
+    uint16_t length;
+    std::memcpy(&length, data, sizeof(length));
+    std::string_view format(data + sizeof(length), length);
+    const char* in = data + sizeof(length) + length;
+    ((in = expand_next<Args>(format, in, out)), ...);
+    (void)in;
+    out.append(format);
+}
+
+} // namespace detail
+} // namespace logging
+} // namespace customos
+
+#endif // CUSTOMOS_LOG_FORMAT_H
@@ -0,0 +1,94 @@
+#ifndef CUSTOMOS_LOG_RING_H
+#define CUSTOMOS_LOG_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "logger.h"
+
+namespace customos {
+namespace logging {
+
+// One log call, copied into the ring by the caller and formatted later by
+// the writer thread. Text that does not fit is cut and marked truncated.
+// For a deferred-format call, `message` holds the encoded format and
+// arguments and `expand` turns them into text.
+struct LogRecord {
+    static constexpr size_t SOURCE_BYTES = 40;
+    static constexpr size_t MESSAGE_BYTES = 448;
+
+    int64_t time_us;  // system clock, microseconds since the epoch
+    void (*expand)(const char* data, std::string& out);
+    LogLevel level;
+    uint16_t source_length;
+    uint16_t message_length;
+    bool truncated;
+    char source[SOURCE_BYTES];
+    char message[MESSAGE_BYTES];
+
+    void assign(LogLevel record_level, std::string_view text, std::string_view from, int64_t when_us);
+
+    // Message text, expanding a deferred format
+    void message_text(std::string& out) const;
+};
+
+// Bounded queue of LogRecords for many producers and one consumer.
+// Each cell carries a sequence number that says whose turn it is: a
+// producer claims a cell with one CAS on the enqueue position, fills it
+// in place and publishes it by bumping the sequence; the consumer reads
+// cells in order. No locks, and nothing is allocated after construction.
+class LogRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit LogRing(size_t capacity);
+    LogRing(const LogRing&) = delete;
+    LogRing& operator=(const LogRing&) = delete;
+
+    // Fill a free cell with `fill(record)`; false if the ring is full
+    template <typename Fill>
+    bool try_push(Fill&& fill) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    fill(cell.record);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;  // the consumer has not freed this cell yet
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer only. False if nothing is ready.
+    bool try_pop(LogRecord& record);
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct alignas(64) Cell {
+        std::atomic<size_t> sequence;
+        LogRecord record;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) size_t dequeue_pos_;
+};
+
+} // namespace logging
+} // namespace customos
+
+#endif // CUSTOMOS_LOG_RING_H
@@ -0,0 +1,72 @@
+#ifndef CUSTOMOS_LOG_STORE_H
+#define CUSTOMOS_LOG_STORE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <ctime>
+#include "logger.h"
+
+namespace customos {
+namespace logging {
+
+// In-memory history of log or audit entries with fixed memory.
+// Entries are appended to the newest of at most MAX_SEGMENTS segments; a
+// segment is sealed at SEGMENT_ENTRIES entries or SEGMENT_BYTES, and when
+// the ring is full the oldest segment is dropped whole. Each segment keeps
+// its time range, a bitmask of the entry kinds it holds (log level or audit
+// event type) and an inverted index from the words in its entries to their
+// positions, so a query only looks inside segments that can match.
+// Instantiated for LogEntry and AuditEntry. Not thread-safe; Logger locks.
+template <typename Entry>
+class LogStore {
+public:
+    static constexpr size_t SEGMENT_ENTRIES = 1024;
+    static constexpr size_t SEGMENT_BYTES = 256 * 1024;
+    static constexpr size_t MAX_SEGMENTS = 16;
+    static constexpr uint32_t ALL_KINDS = 0xFFFFFFFFu;
+
+    // Return false to stop a scan
+    using Visit = std::function<bool(const Entry&)>;
+
+    void append(Entry entry);
+
+    // Newest first, entries of the given kinds
+    void scan_newest(uint32_t kinds, const Visit& visit) const;
+
+    // Oldest first: entries in [start, end] (0 leaves that end open) of the
+    // given kinds whose text contains `text`, narrowed by the term index
+    // and then confirmed by `match`
+    void search(const std::string& text, time_t start, time_t end, uint32_t kinds,
+                const std::function<bool(const Entry&)>& match, const Visit& visit) const;
+
+    // Drop entries older than `cutoff`
+    void erase_before(time_t cutoff);
+
+    size_t size() const;
+    size_t bytes() const;  // approximate, including the indexes
+
+private:
+    struct Segment {
+        std::vector<Entry> entries;
+        std::unordered_map<std::string, std::vector<uint16_t>> terms;  // word -> entry positions
+        time_t first_time = 0;
+        time_t last_time = 0;
+        uint32_t kinds = 0;
+        size_t bytes = 0;
+    };
+
+    static void add_to_segment(Segment& segment, Entry entry);
+    static bool candidates(const Segment& segment, const std::string& text, std::vector<uint16_t>& out);
+
+    std::deque<Segment> segments_;  // oldest first
+    size_t bytes_ = 0;
+};
+
+} // namespace logging
+} // namespace customos
+
+#endif // CUSTOMOS_LOG_STORE_H
@@ -5,6 +5,12 @@
 #include <vector>
 #include <memory>
 #include <ctime>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <string_view>
+#include <tuple>
+#include "log_format.h"
 
 namespace customos {
 namespace logging {
@@ -19,6 +25,9 @@ enum class LogLevel {
     CRITICAL
 };
 
+// "TRACE" ... "CRITICAL"
+const char* log_level_name(LogLevel level);
+
 // Log entry
 struct LogEntry {
     LogLevel level;
@@ -55,13 +64,47 @@ struct AuditEntry {
     std::string details;
 };
 
+// An audit entry read back from the durable journal (see audit_trail.h)
+struct AuditRecord {
+    uint64_t sequence;  // 1 for the first entry ever written
+    AuditEntry entry;
+    std::string hash;   // hex chain hash up to and including this entry
+};
+
+// What an asynchronous log() does when the queue is full
+enum class OverflowPolicy {
+    DROP,   // discard the record and count it
+    BLOCK   // wait for the writer to make room
+};
+
 // Logger
+// Synchronous by default: log() formats and writes on the caller's thread.
+// In async mode log() only copies the call into a lock-free ring (messages
+// longer than LogRecord::MESSAGE_BYTES are cut) and a writer thread
+// formats, stores and writes records in batches, one write per batch.
 class Logger {
 public:
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+
     static Logger& instance();
 
+    // Cheap check for callers that want to skip building a message
+    bool enabled(LogLevel level) const { return level >= min_level_.load(std::memory_order_relaxed); }
+
     // Logging functions
     void log(LogLevel level, const std::string& message, const std::string& source = "");
+
+    // What the LOG_* macros call once the level check passed. With one
+    // argument the message is logged as is. With more, each "{}" in the
+    // format takes the next argument (numbers, bool, char or text); in
+    // async mode the arguments are copied into the queued record and only
+    // formatted on the writer thread.
+    void log_format(LogLevel level, const char* source, const std::string& message) {
+        log(level, message, source);
+    }
+    template <typename... Args>
+    void log_format(LogLevel level, const char* source, std::string_view format, const Args&... args);
+
     void trace(const std::string& message, const std::string& source = "");
     void debug(const std::string& message, const std::string& source = "");
     void info(const std::string& message, const std::string& source = "");
@@ -69,13 +112,16 @@ public:
     void error(const std::string& message, const std::string& source = "");
     void critical(const std::string& message, const std::string& source = "");
 
-    // Audit logging
-    void audit(const AuditEntry& entry);
+    // Audit logging. False when the audit journal is closed or has failed;
+    // the entry then only reaches the in-memory store.
+    bool audit(const AuditEntry& entry);
     void audit_command(const std::string& command, bool success);
     void audit_login(const std::string& user, bool success);
     void audit_file_access(const std::string& file, const std::string& action, bool success);
 
-    // Log retrieval
+    // Log retrieval, from bounded in-memory stores (see log_store.h): only
+    // the most recent entries are kept. Searches match message text; audit
+    // searches match the user (empty for any) and event type.
     std::vector<LogEntry> get_logs(size_t max_count = 100, LogLevel min_level = LogLevel::TRACE);
     std::vector<AuditEntry> get_audit_trail(size_t max_count = 100);
     std::vector<LogEntry> search_logs(const std::string& query, time_t start_time = 0, time_t end_time = 0);
@@ -88,10 +134,37 @@ public:
     void enable_console_output(bool enable);
     void enable_file_output(bool enable);
 
+    // Also write entries to binary log segments in `directory` (see
+    // log_file.h), starting a new segment past either limit; an empty
+    // directory turns it off
+    bool set_binary_log(const std::string& directory, size_t max_segment_bytes = 8 * 1024 * 1024,
+                        std::chrono::seconds max_segment_age = std::chrono::hours(24));
+
+    // Most recent entries from the binary log on disk, newest first
+    std::vector<LogEntry> read_binary_logs(size_t max_count = 100);
+
+    // Also append audit entries to a durable, hash-chained journal at
+    // `path` (see audit_trail.h); an empty path turns it off
+    bool set_audit_journal(const std::string& path);
+
+    // Newest journal entries first; empty when no journal is open
+    std::vector<AuditRecord> read_audit_journal(size_t max_count = 100);
+
+    // Sequence of the first journal entry whose hash chain does not
+    // match, 0 when intact. Also checks a journal that failed to open.
+    uint64_t verify_audit_journal();
+
+    // Switch the writer thread on or off; turning it off drains the queue.
+    // Meant for startup and shutdown, not while other threads are logging.
+    void set_async(bool enable, size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+    bool is_async() const;
+    void set_overflow_policy(OverflowPolicy policy);
+    uint64_t dropped_records() const;  // under OverflowPolicy::DROP
+
     // Maintenance
-    void flush();
-    void rotate_logs();
-    void clear_old_logs(int days);
+    void flush();  // in async mode, waits until the writer has drained; commits the audit journal
+    void rotate_logs();  // start new log files; closed binary segments are compressed
+    void clear_old_logs(int days);  // from memory and the binary log directory
 
 private:
     Logger();
@@ -99,17 +172,70 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
+    using Encoder = void (*)(char* out, const void* context);
+    using Expander = void (*)(const char* data, std::string& out);
+
+    // Queue a deferred-format record of `size` bytes written by `encode`;
+    // false when not in async mode or it does not fit a record
+    bool enqueue_encoded(LogLevel level, const char* source, size_t size, Encoder encode, const void* context,
+                         Expander expand);
+
+    std::atomic<LogLevel> min_level_;
+
     struct Impl;
     std::unique_ptr<Impl> pimpl_;
 };
 
+template <typename... Args>
+void Logger::log_format(LogLevel level, const char* source, std::string_view format, const Args&... args) {
+    struct Context {
+        std::string_view format;
+        std::tuple<const Args&...> args;
+    };
+    Context context{format, std::tuple<const Args&...>(args...)};
+    Encoder encode = [](char* out, const void* pointer) {
+        const auto& call = *static_cast<const Context*>(pointer);
+        detail::encode<Args...>(out, call.format, call.args);
+    };
+    Expander expand = &detail::expand<detail::LogArgType<Args>...>;
+
+    size_t size = detail::encoded_size(format, args...);
+    if (enqueue_encoded(level, source, size, encode, &context, expand)) {
+        return;
+    }
+
+    // Synchronous, or too large to queue: format here
+    std::string encoded(size, '\0');
+    encode(&encoded[0], &context);
+    std::string message;
+    expand(encoded.data(), message);
+    log(level, message, source);
+}
+
+// Compile-time floor for the LOG_* macros: 0 = TRACE ... 5 = CRITICAL.
+// Calls below it compile to nothing (STRIP_DEBUG_LOGS in CMake sets 2).
+#ifndef NOVASHELL_LOG_MIN_LEVEL
+#define NOVASHELL_LOG_MIN_LEVEL 0
+#endif
+
+// Arguments are only evaluated when the level is enabled, e.g.
+//   LOG_INFO("Loaded " + std::to_string(count) + " tasks");
+//   LOG_INFO("Loaded {} tasks from {}", count, path);  // formatted by the writer
+#define NOVASHELL_LOG(level, ...)                                                               \
+    do {                                                                                        \
+        if (static_cast<int>(level) >= NOVASHELL_LOG_MIN_LEVEL &&                               \
+            customos::logging::Logger::instance().enabled(level)) {                             \
+            customos::logging::Logger::instance().log_format(level, __FUNCTION__, __VA_ARGS__); \
+        }                                                                                       \
+    } while (0)
+
 // Convenience macros
-#define LOG_TRACE(msg) customos::logging::Logger::instance().trace(msg, __FUNCTION__)
-#define LOG_DEBUG(msg) customos::logging::Logger::instance().debug(msg, __FUNCTION__)
-#define LOG_INFO(msg) customos::logging::Logger::instance().info(msg, __FUNCTION__)
-#define LOG_WARNING(msg) customos::logging::Logger::instance().warning(msg, __FUNCTION__)
-#define LOG_ERROR(msg) customos::logging::Logger::instance().error(msg, __FUNCTION__)
-#define LOG_CRITICAL(msg) customos::logging::Logger::instance().critical(msg, __FUNCTION__)
+#define LOG_TRACE(...) NOVASHELL_LOG(customos::logging::LogLevel::TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) NOVASHELL_LOG(customos::logging::LogLevel::DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) NOVASHELL_LOG(customos::logging::LogLevel::INFO, __VA_ARGS__)
+#define LOG_WARNING(...) NOVASHELL_LOG(customos::logging::LogLevel::WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) NOVASHELL_LOG(customos::logging::LogLevel::ERROR, __VA_ARGS__)
+#define LOG_CRITICAL(...) NOVASHELL_LOG(customos::logging::LogLevel::CRITICAL, __VA_ARGS__)
 
 } // namespace logging
 } // namespace customos
@@ -0,0 +1,174 @@
+// customos-client: forwards one command to a running `customos-shell --daemon`
+// and streams its output back. Deliberately links nothing from the shell so
+// each invocation costs a process spawn and one socket round trip.
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include "core/daemon_protocol.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0  // SIGPIPE is ignored instead
+#endif
+
+extern char** environ;
+
+using namespace customos::core;
+namespace proto = daemon_protocol;
+
+namespace {
+
+int connect_to_daemon(const std::string& path) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return -1;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = proto::open_socket();
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::string frame(char type, const char* data, size_t size) {
+    std::string out;
+    out.reserve(5 + size);
+    out += type;
+    out += static_cast<char>((size >> 24) & 0xff);
+    out += static_cast<char>((size >> 16) & 0xff);
+    out += static_cast<char>((size >> 8) & 0xff);
+    out += static_cast<char>(size & 0xff);
+    out.append(data, size);
+    return out;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    std::string socket_path = proto::default_socket_path();
+    int first_arg = 1;
+    if (argc > 2 && std::string(argv[1]) == "--socket") {
+        socket_path = argv[2];
+        first_arg = 3;
+    }
+
+    if (first_arg >= argc) {
+        std::cerr << "Usage: customos-client [--socket path] <command> [args...]\n";
+        return 2;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int fd = connect_to_daemon(socket_path);
+    if (fd < 0) {
+        std::cerr << "customos-client: no daemon at " << socket_path
+                  << " (start one with 'customos-shell --daemon')\n";
+        return 2;
+    }
+
+    // The request carries the whole environment; never hand it to a
+    // server another user started on our socket path
+    if (!proto::peer_is_same_user(fd)) {
+        std::cerr << "customos-client: " << socket_path << " is served by another user; not sending the command\n";
+        ::close(fd);
+        return 2;
+    }
+
+    // Request header
+    std::string request;
+    for (int i = first_arg; i < argc; ++i) {
+        request += frame(proto::FRAME_ARG, argv[i], std::strlen(argv[i]));
+    }
+    for (char** env = environ; env && *env; ++env) {
+        request += frame(proto::FRAME_ENV, *env, std::strlen(*env));
+    }
+    char cwd[4096];
+    if (::getcwd(cwd, sizeof(cwd))) {
+        request += frame(proto::FRAME_CWD, cwd, std::strlen(cwd));
+    }
+    request += frame(proto::FRAME_RUN, "", 0);
+
+    // A terminal is not forwarded; commands see an empty stdin
+    bool stdin_open = !::isatty(STDIN_FILENO);
+    if (!stdin_open) {
+        request += frame(proto::FRAME_STDIN_EOF, "", 0);
+    }
+
+    // Stdin is sent without blocking so a command that writes a lot of
+    // output before reading its input cannot deadlock against us
+    std::string pending = std::move(request);
+    int exit_code = 1;
+    bool done = false;
+
+    while (!done) {
+        pollfd fds[2];
+        nfds_t count = 0;
+        fds[count++] = {fd, static_cast<short>(POLLIN | (pending.empty() ? 0 : POLLOUT)), 0};
+        if (stdin_open && pending.empty()) {
+            fds[count++] = {STDIN_FILENO, POLLIN, 0};
+        }
+
+        if (::poll(fds, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (fds[0].revents & POLLOUT) {
+            ssize_t n = ::send(fd, pending.data(), pending.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n > 0) {
+                pending.erase(0, static_cast<size_t>(n));
+            }
+            else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                pending.clear();
+                stdin_open = false;  // daemon stopped reading; keep draining output
+            }
+        }
+
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            char type = 0;
+            std::string payload;
+            if (!proto::recv_frame(fd, type, payload)) {
+                std::cerr << "customos-client: connection to daemon lost\n";
+                break;
+            }
+            if (type == proto::FRAME_OUTPUT) {
+                std::cout.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+                std::cout.flush();
+            }
+            else if (type == proto::FRAME_EXIT) {
+                exit_code = proto::decode_exit_code(payload);
+                done = true;
+            }
+        }
+
+        if (count > 1 && (fds[1].revents & (POLLIN | POLLHUP))) {
+            char buffer[64 * 1024];
+            ssize_t n = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (n > 0) {
+                pending = frame(proto::FRAME_STDIN, buffer, static_cast<size_t>(n));
+            }
+            else if (n == 0 || errno != EINTR) {
+                pending = frame(proto::FRAME_STDIN_EOF, "", 0);
+                stdin_open = false;
+            }
+        }
+    }
+
+    ::close(fd);
+    return exit_code == 0 ? 0 : (exit_code > 0 && exit_code < 256 ? exit_code : 1);
+}
@@ -0,0 +1,377 @@
+#include "core/command_history.h"
+#include "core/history_journal.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace customos {
+namespace core {
+
+namespace {
+
+// "<digits>;<command>"; lines without the prefix (hand edits) keep their text
+HistoryEntry parse_record(const char* line, size_t length) {
+    HistoryEntry entry{0, std::string()};
+    size_t i = 0;
+    int64_t timestamp = 0;
+    while (i < length && line[i] >= '0' && line[i] <= '9') {
+        timestamp = timestamp * 10 + (line[i] - '0');
+        ++i;
+    }
+    if (i > 0 && i < length && line[i] == ';') {
+        entry.timestamp = timestamp;
+        entry.command.assign(line + i + 1, length - i - 1);
+    }
+    else {
+        entry.command.assign(line, length);
+    }
+    return entry;
+}
+
+std::string format_record(int64_t timestamp, const std::string& command) {
+    std::string record = std::to_string(timestamp);
+    record += ';';
+    record += command;
+    std::replace(record.begin(), record.end(), '\n', ' ');  // one record per line
+    record += '\n';
+    return record;
+}
+
+} // anonymous namespace
+
+CommandHistory& CommandHistory::instance() {
+    static CommandHistory history;
+    return history;
+}
+
+CommandHistory::CommandHistory()
+    : capacity_(DEFAULT_CAPACITY)
+    , head_(0)
+    , index_built_(false)
+    , fd_(-1)
+    , sync_in_flight_(false) {
+}
+
+CommandHistory::~CommandHistory() {
+    // The journal is a static built after this one, so it is already gone;
+    // Shell::shutdown flushed it and detached the hook through close()
+    std::lock_guard<std::mutex> lock(mutex_);
+    close_log();
+}
+
+bool CommandHistory::open(const std::string& path, size_t capacity) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd_ >= 0) {
+        return true;
+    }
+
+    path_ = path;
+    capacity_ = std::max<size_t>(1, capacity);
+    ring_.clear();
+    head_ = 0;
+
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path_).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, ec);
+    }
+    if (!open_log()) {
+        return false;
+    }
+
+    size_t total = 0;
+    size_t keep_from = 0;
+#ifdef _WIN32
+    std::string contents;
+    {
+        std::ifstream in(path_, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    total = contents.size();
+    keep_from = load_tail(contents.data(), total);
+#else
+    // Map the file read-only just long enough to parse its tail
+    struct stat st;
+    if (fstat(fd_, &st) == 0 && st.st_size > 0) {
+        int read_fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        total = static_cast<size_t>(st.st_size);
+        void* map = read_fd >= 0 ? mmap(nullptr, total, PROT_READ, MAP_PRIVATE, read_fd, 0) : MAP_FAILED;
+        if (map != MAP_FAILED) {
+            keep_from = load_tail(static_cast<const char*>(map), total);
+            munmap(map, total);
+        }
+        if (read_fd >= 0) {
+            ::close(read_fd);
+        }
+    }
+#endif
+
+    // Once entries that no longer fit the ring make up most of the file,
+    // rewrite it with just the ring's contents
+    if (keep_from > total / 2) {
+        rewrite_log();
+    }
+
+    // Lock order is the journal's drain lock, then mutex_: the drain calls
+    // sync_log while holding its lock, so register without mutex_ held
+    lock.unlock();
+    HistoryJournal::instance().set_sync_hook([this] { sync_log(); });
+    return true;
+}
+
+void CommandHistory::close() {
+    HistoryJournal::instance().set_sync_hook(nullptr);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    sync_done_.wait(lock, [this] { return !sync_in_flight_; });
+    close_log();
+}
+
+bool CommandHistory::record(const std::string& command, const std::string& user) {
+    // Repeats are collapsed lazily by the journal, off this path
+    HistoryJournal::instance().append(command, user, "local");
+
+    int64_t timestamp = static_cast<int64_t>(std::time(nullptr));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ring_.empty() && ring_[(head_ + ring_.size() - 1) % ring_.size()].command == command) {
+        return false;
+    }
+
+    push_ring(timestamp, command);
+    if (index_built_) {
+        search_index_.add(command);
+    }
+    if (fd_ >= 0) {
+        append_to_log(format_record(timestamp, command));
+    }
+    return true;
+}
+
+size_t CommandHistory::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ring_.size();
+}
+
+std::string CommandHistory::at(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= ring_.size()) {
+        return "";
+    }
+    return ring_[(head_ + index) % ring_.size()].command;
+}
+
+std::vector<HistoryEntry> CommandHistory::recent(size_t count) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    count = std::min(count, ring_.size());
+
+    std::vector<HistoryEntry> entries;
+    entries.reserve(count);
+    for (size_t i = ring_.size() - count; i < ring_.size(); ++i) {
+        entries.push_back(ring_[(head_ + i) % ring_.size()]);
+    }
+    return entries;
+}
+
+const HistorySearchIndex& CommandHistory::search_index() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!index_built_) {
+        // Built lazily so startup only pays for loading the ring
+        for (size_t i = 0; i < ring_.size(); ++i) {
+            search_index_.add(ring_[(head_ + i) % ring_.size()].command);
+        }
+        index_built_ = true;
+    }
+    return search_index_;
+}
+
+void CommandHistory::push_ring(int64_t timestamp, std::string command) {
+    if (ring_.size() < capacity_) {
+        ring_.push_back({timestamp, std::move(command)});
+        return;
+    }
+    ring_[head_] = {timestamp, std::move(command)};
+    head_ = (head_ + 1) % capacity_;
+}
+
+size_t CommandHistory::load_tail(const char* data, size_t size) {
+    // Walk back from the end over at most capacity_ records, then parse
+    // them oldest first. Returns the offset where the loaded records start.
+    std::vector<std::pair<size_t, size_t>> lines;
+    size_t pos = size;
+    while (pos > 0 && lines.size() < capacity_) {
+        size_t line_end = pos;
+        if (data[line_end - 1] == '\n') {
+            --line_end;
+        }
+        size_t start = 0;
+#ifdef __GLIBC__
+        if (const void* newline = memrchr(data, '\n', line_end)) {
+            start = static_cast<size_t>(static_cast<const char*>(newline) - data) + 1;
+        }
+#else
+        start = line_end;
+        while (start > 0 && data[start - 1] != '\n') {
+            --start;
+        }
+#endif
+        // Zero padding left by older versions of the log precedes a record
+        size_t record = start;
+        while (record < line_end && data[record] == '\0') {
+            ++record;
+        }
+        if (line_end > record) {
+            lines.emplace_back(record, line_end - record);
+        }
+        pos = start;
+    }
+
+    ring_.reserve(std::min(capacity_, lines.size() + 1024));
+    for (auto it = lines.rbegin(); it != lines.rend(); ++it) {
+        HistoryEntry entry = parse_record(data + it->first, it->second);
+        push_ring(entry.timestamp, std::move(entry.command));
+    }
+    return pos;
+}
+
+bool CommandHistory::open_log() {
+#ifdef _WIN32
+    fd_ = _open(path_.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+    return fd_ >= 0;
+#else
+    // Every shell holds a shared lock while the file is open; rewrite_log()
+    // needs it exclusively. If a rewrite replaced the file while we waited
+    // for the lock, open the new one.
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+        if (fd_ < 0) {
+            return false;
+        }
+        flock(fd_, LOCK_SH);
+
+        struct stat opened;
+        struct stat current;
+        if (fstat(fd_, &opened) == 0 && stat(path_.c_str(), &current) == 0 && opened.st_ino == current.st_ino &&
+            opened.st_dev == current.st_dev) {
+            return true;
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+    return false;
+#endif
+}
+
+void CommandHistory::close_log() {
+    if (fd_ < 0) {
+        return;
+    }
+#ifdef _WIN32
+    _close(fd_);
+#else
+    ::close(fd_);  // releases the shared lock
+#endif
+    fd_ = -1;
+}
+
+bool CommandHistory::append_to_log(const std::string& record) {
+    // O_APPEND: each record lands whole at the current end of the file, even
+    // with other shells appending to it
+#ifdef _WIN32
+    return _write(fd_, record.data(), static_cast<unsigned int>(record.size())) ==
+           static_cast<int>(record.size());
+#else
+    const char* data = record.data();
+    size_t size = record.size();
+    while (size > 0) {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+#endif
+}
+
+bool CommandHistory::rewrite_log() {
+#ifdef _WIN32
+    close_log();
+#else
+    // Only when no other shell has the file open; otherwise it would keep
+    // appending to the replaced file. The next shell to open it alone
+    // compacts it.
+    if (flock(fd_, LOCK_EX | LOCK_NB) != 0) {
+        flock(fd_, LOCK_SH);  // a failed conversion may have dropped it
+        return true;
+    }
+#endif
+
+    std::string temp_path = path_ + ".tmp";
+    bool written;
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        for (size_t i = 0; i < ring_.size(); ++i) {
+            const HistoryEntry& entry = ring_[(head_ + i) % ring_.size()];
+            out << format_record(entry.timestamp, entry.command);
+        }
+        written = static_cast<bool>(out);
+    }
+
+    std::error_code ec;
+    if (written) {
+        std::filesystem::rename(temp_path, path_, ec);
+    }
+    close_log();
+    return open_log();
+}
+
+void CommandHistory::sync_log() {
+    // Called from the journal's drain, without mutex_ held
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0) {
+            return;
+        }
+        sync_in_flight_ = true;
+        fd = fd_;
+    }
+
+#ifdef _WIN32
+    _commit(fd);
+#elif defined(__APPLE__)
+    fsync(fd);
+#else
+    fdatasync(fd);
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sync_in_flight_ = false;
+    }
+    sync_done_.notify_all();
+}
+
+} // namespace core
+} // namespace customos
@@ -0,0 +1,236 @@
+#include "core/command_metrics.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace customos {
+namespace core {
+
+namespace {
+
+int highest_bit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+} // anonymous namespace
+
+// LatencyHistogram
+
+LatencyHistogram::LatencyHistogram()
+    : counts_(BUCKET_COUNT, 0)
+    , count_(0)
+    , sum_(0)
+    , max_(0) {
+}
+
+size_t LatencyHistogram::bucket_index(uint64_t value) {
+    const uint64_t limit = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+    value = std::min(value, limit);
+    if (value < 2 * SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    int shift = highest_bit(value) - SUB_BUCKET_BITS;
+    return static_cast<size_t>((shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS));
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+    uint64_t sub = index % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value_us) {
+    ++counts_[bucket_index(value_us)];
+    ++count_;
+    sum_ += value_us;
+    max_ = std::max(max_, value_us);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+}
+
+double LatencyHistogram::mean() const {
+    return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (count_ == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(count_) + 0.999999);
+    target = std::max<uint64_t>(1, std::min(target, count_));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts_[i];
+        if (seen >= target) {
+            return std::min(bucket_upper_bound(i), max_);
+        }
+    }
+    return max_;
+}
+
+// CommandMetrics
+
+namespace {
+
+// Histograms written by one thread. The owner takes the (uncontended)
+// mutex per record; snapshot() takes it to read consistently.
+struct ThreadStats {
+    std::mutex mutex;
+    std::unordered_map<std::string, CommandStats> commands;
+};
+
+struct MetricsRegistry {
+    std::mutex mutex;                                // lock before any ThreadStats::mutex
+    std::set<ThreadStats*> live;
+    std::map<std::string, CommandStats> retired;     // merged from exited threads
+};
+
+// Never destroyed: threads may still exit after static destruction starts
+MetricsRegistry& metrics_registry() {
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+}
+
+void merge_into(std::map<std::string, CommandStats>& target, const CommandStats& stats) {
+    auto it = target.find(stats.name);
+    if (it == target.end()) {
+        target.emplace(stats.name, stats);
+        return;
+    }
+    it->second.calls += stats.calls;
+    it->second.failures += stats.failures;
+    it->second.wall.merge(stats.wall);
+    it->second.cpu.merge(stats.cpu);
+}
+
+struct ThreadSlot {
+    ThreadStats stats;
+
+    ThreadSlot() {
+        auto& registry = metrics_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.live.insert(&stats);
+    }
+
+    ~ThreadSlot() {
+        auto& registry = metrics_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        std::lock_guard<std::mutex> stats_lock(stats.mutex);
+        for (const auto& pair : stats.commands) {
+            merge_into(registry.retired, pair.second);
+        }
+        registry.live.erase(&stats);
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+} // anonymous namespace
+
+void CommandMetrics::record(const std::string& command, uint64_t wall_us, uint64_t cpu_us, bool success) {
+    ThreadStats& stats = t_slot.stats;
+    std::lock_guard<std::mutex> lock(stats.mutex);
+
+    auto it = stats.commands.find(command);
+    if (it == stats.commands.end()) {
+        it = stats.commands.emplace(command, CommandStats{command, 0, 0, {}, {}}).first;
+    }
+
+    CommandStats& entry = it->second;
+    ++entry.calls;
+    if (!success) {
+        ++entry.failures;
+    }
+    entry.wall.record(wall_us);
+    entry.cpu.record(cpu_us);
+}
+
+std::vector<CommandStats> CommandMetrics::snapshot() {
+    auto& registry = metrics_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    std::map<std::string, CommandStats> merged = registry.retired;
+    for (ThreadStats* stats : registry.live) {
+        std::lock_guard<std::mutex> stats_lock(stats->mutex);
+        for (const auto& pair : stats->commands) {
+            merge_into(merged, pair.second);
+        }
+    }
+
+    std::vector<CommandStats> result;
+    result.reserve(merged.size());
+    for (auto& pair : merged) {
+        result.push_back(std::move(pair.second));
+    }
+    return result;
+}
+
+void CommandMetrics::reset() {
+    auto& registry = metrics_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    registry.retired.clear();
+    for (ThreadStats* stats : registry.live) {
+        std::lock_guard<std::mutex> stats_lock(stats->mutex);
+        stats->commands.clear();
+    }
+}
+
+uint64_t CommandMetrics::thread_cpu_us() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) / 10;  // 100ns units
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 + static_cast<uint64_t>(ts.tv_nsec) / 1000;
+#endif
+}
+
+} // namespace core
+} // namespace customos
@@ -0,0 +1,621 @@
+#include "core/command_model.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace customos {
+namespace core {
+
+namespace {
+
+// Snapshot layout, native byte order:
+//   header | string_count x (u32 length, bytes) | record_count x Record
+const char SNAPSHOT_MAGIC[4] = {'N', 'S', 'C', 'M'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t string_count;
+    uint32_t last;
+    uint32_t before;
+    uint32_t reserved;
+    uint64_t record_count;
+};
+
+struct Record {
+    uint64_t context;
+    uint32_t item;
+    uint32_t count;
+};
+
+// Log record: u32 command length, u32 previous length, i32 hour, then both strings
+const size_t LOG_HEADER = 3 * sizeof(uint32_t);
+
+// Bounds-checked reads over a mapped buffer
+struct Reader {
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+
+    template <typename T>
+    bool read(T& value) {
+        if (size - pos < sizeof(T)) return false;
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool read_string(std::string_view& text, size_t length) {
+        if (size - pos < length) return false;
+        text = std::string_view(data + pos, length);
+        pos += length;
+        return true;
+    }
+};
+
+// flock on the log for one call: shared to append a record, exclusive to
+// read the files and compact them. Nothing to hold on Windows.
+class LogLock {
+public:
+    LogLock(int fd, bool exclusive)
+        : fd_(fd) {
+#ifndef _WIN32
+        while (fd_ >= 0 && flock(fd_, exclusive ? LOCK_EX : LOCK_SH) != 0 && errno == EINTR) {
+        }
+#else
+        (void)exclusive;
+#endif
+    }
+
+    ~LogLock() {
+#ifndef _WIN32
+        if (fd_ >= 0) {
+            flock(fd_, LOCK_UN);
+        }
+#endif
+    }
+
+    LogLock(const LogLock&) = delete;
+    LogLock& operator=(const LogLock&) = delete;
+
+private:
+    int fd_;
+};
+
+std::string first_word(const std::string& line, size_t* end = nullptr) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos) {
+        if (end) *end = line.size();
+        return "";
+    }
+    size_t stop = line.find_first_of(" \t", start);
+    if (stop == std::string::npos) stop = line.size();
+    if (end) *end = stop;
+    return line.substr(start, stop - start);
+}
+
+} // anonymous namespace
+
+CommandModel::CommandModel()
+    : last_(NONE)
+    , before_(NONE)
+    , log_fd_(-1)
+    , log_records_(0)
+    , dirty_(false) {
+}
+
+CommandModel::~CommandModel() {
+    close();
+}
+
+bool CommandModel::open(const std::string& base_path) {
+    close();
+    reset();
+    base_path_ = base_path;
+    std::error_code ec;
+    fs::path parent = fs::path(base_path).parent_path();
+    if (!parent.empty()) {
+        fs::create_directories(parent, ec);
+    }
+
+    std::string log_path = base_path_ + ".log";
+#ifdef _WIN32
+    log_fd_ = _open(log_path.c_str(), _O_RDWR | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    log_fd_ = ::open(log_path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+#endif
+    if (log_fd_ < 0) {
+        load_snapshot();
+        return false;
+    }
+
+    // Snapshot and log are read together, so another shell's compaction
+    // cannot fall between them
+    LogLock lock(log_fd_, true);
+    load_snapshot();
+    log_records_ = replay_log();
+    if (log_records_ >= COMPACT_THRESHOLD) {
+        compact();
+    }
+    return true;
+}
+
+void CommandModel::close() {
+    if (dirty_ && !base_path_.empty()) {
+        save();
+    }
+    if (log_fd_ >= 0) {
+#ifdef _WIN32
+        _close(log_fd_);
+#else
+        ::close(log_fd_);
+#endif
+        log_fd_ = -1;
+    }
+}
+
+void CommandModel::learn(const std::string& command, const std::string& previous_command, int hour) {
+    observe(command, previous_command, hour);
+    append_log(command, previous_command, hour);
+    if (log_records_ >= COMPACT_THRESHOLD) {
+        save();
+    }
+}
+
+void CommandModel::observe(const std::string& command, const std::string& previous_command, int hour) {
+    size_t name_end = 0;
+    std::string name = first_word(command, &name_end);
+    if (name.empty()) {
+        return;
+    }
+    uint32_t id = intern(name);
+
+    // An empty previous command starts a new chain (a new session)
+    std::string previous = first_word(previous_command);
+    if (previous.empty()) {
+        last_ = NONE;
+        before_ = NONE;
+    }
+    else {
+        uint32_t previous_id = intern(previous);
+        if (previous_id != last_) {
+            before_ = NONE;
+            last_ = previous_id;
+        }
+    }
+
+    count(context_of(GLOBAL, 0), id);
+    if (last_ != NONE) {
+        count(context_of(AFTER_ONE, last_), id);
+        if (before_ != NONE) {
+            count(context_of(AFTER_TWO, before_, last_), id);
+        }
+    }
+
+    size_t args_start = command.find_first_not_of(" \t", name_end);
+    if (args_start != std::string::npos) {
+        count(context_of(ARGUMENTS, id), intern(std::string_view(command).substr(args_start)));
+    }
+    if (hour >= 0 && hour < 24) {
+        count(context_of(HOUR, static_cast<uint32_t>(hour)), id);
+    }
+
+    before_ = last_;
+    last_ = id;
+    dirty_ = true;
+}
+
+uint32_t CommandModel::intern(std::string_view text) {
+    auto it = ids_.find(text);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(strings_.size());
+    strings_.emplace_back(text);
+    ids_.emplace(std::string_view(strings_.back()), id);
+    return id;
+}
+
+uint32_t CommandModel::find_id(std::string_view text) const {
+    auto it = ids_.find(text);
+    return it == ids_.end() ? NONE : it->second;
+}
+
+void CommandModel::count(uint64_t context, uint32_t item, uint32_t by) {
+    uint32_t total = (counts_[{context, item}] += by);
+
+    // Keep the context's top list ordered; the item can only move up
+    std::vector<Ranked>& top = top_[context];
+    size_t i = 0;
+    while (i < top.size() && top[i].id != item) {
+        ++i;
+    }
+    if (i < top.size()) {
+        top[i].count = total;
+    }
+    else if (top.size() < TOP_K) {
+        top.push_back({item, total});
+    }
+    else if (total > top.back().count) {
+        i = top.size() - 1;
+        top[i] = {item, total};
+    }
+    else {
+        return;
+    }
+    while (i > 0 && top[i - 1].count < top[i].count) {
+        std::swap(top[i - 1], top[i]);
+        --i;
+    }
+}
+
+template <typename Accept>
+void CommandModel::collect(uint64_t context, Accept accept, size_t limit, std::vector<Prediction>& out,
+                           std::vector<uint32_t>& seen) const {
+    auto it = top_.find(context);
+    if (it == top_.end()) {
+        return;
+    }
+    for (const auto& ranked : it->second) {
+        if (out.size() >= limit) {
+            return;
+        }
+        if (std::find(seen.begin(), seen.end(), ranked.id) != seen.end() || !accept(strings_[ranked.id])) {
+            continue;
+        }
+        seen.push_back(ranked.id);
+        out.push_back({strings_[ranked.id], ranked.count});
+    }
+}
+
+std::vector<CommandModel::Prediction> CommandModel::predict_next(const std::string& prefix, size_t limit) const {
+    std::vector<Prediction> out;
+    std::vector<uint32_t> seen;
+    auto accept = [&prefix](const std::string& name) { return name.compare(0, prefix.size(), prefix) == 0; };
+    if (last_ != NONE) {
+        if (before_ != NONE) {
+            collect(context_of(AFTER_TWO, before_, last_), accept, limit, out, seen);
+        }
+        collect(context_of(AFTER_ONE, last_), accept, limit, out, seen);
+    }
+    collect(context_of(GLOBAL, 0), accept, limit, out, seen);
+    return out;
+}
+
+std::vector<CommandModel::Prediction> CommandModel::predict_arguments(const std::string& command,
+                                                                     const std::string& partial,
+                                                                     size_t limit) const {
+    std::vector<Prediction> out;
+    uint32_t id = find_id(command);
+    if (id == NONE) {
+        return out;
+    }
+    std::vector<uint32_t> seen;
+    collect(context_of(ARGUMENTS, id),
+            [&partial](const std::string& args) { return args.find(partial) != std::string::npos; },
+            limit, out, seen);
+    return out;
+}
+
+std::vector<CommandModel::Prediction> CommandModel::predict_for_hour(int hour, const std::string& prefix,
+                                                                    size_t limit) const {
+    std::vector<Prediction> out;
+    if (hour < 0 || hour >= 24) {
+        return out;
+    }
+    std::vector<uint32_t> seen;
+    collect(context_of(HOUR, static_cast<uint32_t>(hour)),
+            [&prefix](const std::string& name) { return name.compare(0, prefix.size(), prefix) == 0; },
+            limit, out, seen);
+    return out;
+}
+
+uint32_t CommandModel::frequency(const std::string& command) const {
+    uint32_t id = find_id(command);
+    if (id == NONE) {
+        return 0;
+    }
+    auto it = counts_.find({context_of(GLOBAL, 0), id});
+    return it == counts_.end() ? 0 : it->second;
+}
+
+std::vector<CommandModel::Prediction> CommandModel::top_commands(size_t limit) const {
+    std::vector<Prediction> out;
+    std::vector<uint32_t> seen;
+    collect(context_of(GLOBAL, 0), [](const std::string&) { return true; }, limit, out, seen);
+    return out;
+}
+
+bool CommandModel::save() {
+    if (base_path_.empty()) {
+        return false;
+    }
+    if (log_fd_ < 0) {
+        return compact();  // nothing shared to merge with
+    }
+
+    // Other shells append to the same log and may have compacted it since
+    // we opened it. The files hold everything we learned as well, so start
+    // from them; only this session's place in the command chain is ours.
+    LogLock lock(log_fd_, true);
+    std::string last = last_ == NONE ? "" : strings_[last_];
+    std::string before = before_ == NONE ? "" : strings_[before_];
+    reset();
+    load_snapshot();
+    log_records_ = replay_log();
+    last_ = last.empty() ? NONE : find_id(last);
+    before_ = last_ == NONE || before.empty() ? NONE : find_id(before);
+    return compact();
+}
+
+void CommandModel::reset() {
+    strings_.clear();
+    ids_.clear();
+    counts_.clear();
+    top_.clear();
+    last_ = NONE;
+    before_ = NONE;
+}
+
+void CommandModel::prune_arguments() {
+    // Per command, the MAX_ARGUMENTS most used argument strings survive
+    std::unordered_map<uint64_t, std::vector<Ranked>> arguments;
+    for (const auto& item : counts_) {
+        if ((item.first.context >> 60) == ARGUMENTS) {
+            arguments[item.first.context].push_back({item.first.item, item.second});
+        }
+    }
+    std::unordered_set<CountKey, CountKeyHash> dropped;
+    for (auto& pair : arguments) {
+        std::vector<Ranked>& ranked = pair.second;
+        if (ranked.size() <= MAX_ARGUMENTS) {
+            continue;
+        }
+        std::nth_element(ranked.begin(), ranked.begin() + MAX_ARGUMENTS, ranked.end(),
+                         [](const Ranked& a, const Ranked& b) { return a.count > b.count; });
+        for (auto it = ranked.begin() + MAX_ARGUMENTS; it != ranked.end(); ++it) {
+            dropped.insert({pair.first, it->id});
+        }
+    }
+    if (dropped.empty()) {
+        return;
+    }
+
+    // Re-intern what is left so dropped strings free their ids
+    std::deque<std::string> strings = std::move(strings_);
+    std::unordered_map<CountKey, uint32_t, CountKeyHash> counts = std::move(counts_);
+    uint32_t last = last_;
+    uint32_t before = before_;
+    reset();
+    auto remap = [&](uint32_t id) { return intern(strings[id]); };
+    for (const auto& item : counts) {
+        if (dropped.count(item.first)) {
+            continue;
+        }
+        uint64_t context = item.first.context;
+        uint32_t a = static_cast<uint32_t>(context >> 30) & 0x3FFFFFFF;
+        uint32_t b = static_cast<uint32_t>(context) & 0x3FFFFFFF;
+        switch (static_cast<Kind>(context >> 60)) {
+            case AFTER_ONE: context = context_of(AFTER_ONE, remap(a)); break;
+            case AFTER_TWO: context = context_of(AFTER_TWO, remap(a), remap(b)); break;
+            case ARGUMENTS: context = context_of(ARGUMENTS, remap(a)); break;
+            default: break;  // GLOBAL and HOUR carry no ids
+        }
+        count(context, remap(item.first.item), item.second);
+    }
+    last_ = last == NONE ? NONE : remap(last);
+    before_ = before == NONE ? NONE : remap(before);
+}
+
+bool CommandModel::compact() {
+    prune_arguments();
+
+    std::string snapshot_path = base_path_ + ".bin";
+    std::string temp_path = snapshot_path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return false;
+        }
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.string_count = static_cast<uint32_t>(strings_.size());
+        header.last = last_;
+        header.before = before_;
+        header.record_count = counts_.size();
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& text : strings_) {
+            uint32_t length = static_cast<uint32_t>(text.size());
+            out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+        }
+        for (const auto& item : counts_) {
+            Record record{item.first.context, item.first.item, item.second};
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        if (!out) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(temp_path, snapshot_path, ec);
+    if (ec) {
+        return false;
+    }
+
+    // The snapshot now holds everything the log did
+    if (log_fd_ >= 0) {
+#ifdef _WIN32
+        if (_chsize(log_fd_, 0) != 0) {
+            return false;
+        }
+#else
+        if (ftruncate(log_fd_, 0) != 0) {
+            return false;
+        }
+#endif
+    }
+    log_records_ = 0;
+    dirty_ = false;
+    return true;
+}
+
+void CommandModel::append_log(const std::string& command, const std::string& previous_command, int hour) {
+    if (log_fd_ < 0) {
+        return;
+    }
+    uint32_t lengths[2] = {static_cast<uint32_t>(command.size()), static_cast<uint32_t>(previous_command.size())};
+    int32_t stamp = hour;
+    std::string record(LOG_HEADER, '\0');
+    std::memcpy(&record[0], lengths, sizeof(lengths));
+    std::memcpy(&record[sizeof(lengths)], &stamp, sizeof(stamp));
+    record += command;
+    record += previous_command;
+
+    // One write per record, so a crash can only tear the last one
+    LogLock lock(log_fd_, false);
+#ifdef _WIN32
+    bool written = _write(log_fd_, record.data(), static_cast<unsigned>(record.size())) ==
+                   static_cast<int>(record.size());
+#else
+    bool written = ::write(log_fd_, record.data(), record.size()) == static_cast<ssize_t>(record.size());
+#endif
+    if (written) {
+        ++log_records_;
+    }
+}
+
+bool CommandModel::load_snapshot() {
+    std::string path = base_path_ + ".bin";
+    std::string buffer;
+    const char* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            return false;
+        }
+        buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    data = buffer.data();
+    size = buffer.size();
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        size = static_cast<size_t>(st.st_size);
+        map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    data = static_cast<const char*>(map);
+#endif
+
+    Reader reader{data, size};
+    SnapshotHeader header;
+    bool valid = reader.read(header) && std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == SNAPSHOT_VERSION;
+    for (uint32_t i = 0; valid && i < header.string_count; ++i) {
+        uint32_t length;
+        std::string_view text;
+        valid = reader.read(length) && reader.read_string(text, length);
+        if (valid) {
+            strings_.emplace_back(text);
+            ids_.emplace(std::string_view(strings_.back()), i);
+        }
+    }
+    for (uint64_t i = 0; valid && i < header.record_count; ++i) {
+        Record record;
+        valid = reader.read(record) && record.item < strings_.size();
+        if (valid) {
+            count(record.context, record.item, record.count);
+        }
+    }
+
+#ifndef _WIN32
+    munmap(map, size);
+#endif
+
+    if (!valid) {
+        // A damaged snapshot is dropped rather than half-loaded
+        strings_.clear();
+        ids_.clear();
+        counts_.clear();
+        top_.clear();
+        return false;
+    }
+    last_ = header.last < strings_.size() ? header.last : NONE;
+    before_ = header.before < strings_.size() ? header.before : NONE;
+    return true;
+}
+
+size_t CommandModel::replay_log() {
+    std::string contents;
+    {
+        std::ifstream in(base_path_ + ".log", std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    Reader reader{contents.data(), contents.size()};
+    size_t records = 0;
+    size_t valid_end = 0;
+    for (;;) {
+        uint32_t lengths[2];
+        int32_t hour;
+        std::string_view command;
+        std::string_view previous;
+        if (!reader.read(lengths) || !reader.read(hour) || !reader.read_string(command, lengths[0]) ||
+            !reader.read_string(previous, lengths[1])) {
+            break;
+        }
+        observe(std::string(command), std::string(previous), hour);
+        valid_end = reader.pos;
+        ++records;
+    }
+
+    if (valid_end < contents.size()) {
+        // Drop a record torn by a crash so later appends stay readable
+#ifdef _WIN32
+        _chsize(log_fd_, static_cast<long>(valid_end));
+#else
+        if (ftruncate(log_fd_, static_cast<off_t>(valid_end)) != 0) {
+            // Left in place; it is skipped again on the next open
+        }
+#endif
+    }
+    // Replayed records are already on disk
+    dirty_ = records > 0;
+    return records;
+}
+
+} // namespace core
+} // namespace customos
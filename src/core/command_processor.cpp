@@ -1,4 +1,14 @@
 #include "core/command_processor.h"
+#include "core/job_control.h"
+#include "core/startup_profile.h"
+#include "core/tokenizer.h"
+#include "core/command_metrics.h"
+#include "core/external_command.h"
+#include "core/command_history.h"
+#include "core/history_journal.h"
+#include "core/directory_cache.h"
+#include "core/tab_completion.h"
+#include "core/command_model.h"
 #include "auth/authentication.h"
 #include "database/internal_db.h"
 #include "database/db_manager.h"
@@ -30,10 +40,16 @@
 #include <filesystem>
 #include <iomanip>
 #include <fstream>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
 #ifdef _WIN32
 #include <conio.h> // For Windows password input
 #undef ERROR  // Avoid conflict with Windows ERROR macro
 #undef interface  // Avoid conflict with Windows interface macro
+#else
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 // Helper function to split strings
@@ -81,35 +97,209 @@ std::string get_hidden_password() {
 }
 #endif
 
+// Read one record from the command's pipeline input, falling back to stdin
+static bool read_input_line(const CommandContext& ctx, std::string& line) {
+    if (ctx.input) {
+        return ctx.input->read_line(line);
+    }
+    if (ctx.cancel_flag) {
+        return false;  // background jobs never read the terminal
+    }
+    return static_cast<bool>(std::getline(std::cin, line));
+}
+
+// True once the downstream stage has stopped reading
+static bool output_closed(const CommandContext& ctx) {
+    return ctx.output && ctx.output->is_reader_closed();
+}
+
+// Open a redirect target close-on-exec, so programs other sessions start
+// meanwhile do not inherit it. Relative paths are taken from the
+// invocation's working directory (a daemon client's, not the daemon's).
+static std::FILE* open_redirect(const std::string& path, const std::string& working_directory,
+                                bool write, bool append) {
+    std::string resolved = path;
+    if (!working_directory.empty() && std::filesystem::path(path).is_relative()) {
+        resolved = (std::filesystem::path(working_directory) / path).string();
+    }
+    const char* mode = write ? (append ? "ab" : "wb") : "rb";
+#ifdef _WIN32
+    return std::fopen(resolved.c_str(), mode);
+#else
+    int flags = write ? O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC) : O_RDONLY;
+    int fd = ::open(resolved.c_str(), flags | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::FILE* file = fdopen(fd, mode);
+    if (!file) {
+        ::close(fd);
+    }
+    return file;
+#endif
+}
+
+// Owns the files behind a stage's '<', '>' and '>>' redirects.
+// Input files are streamed by a feeder thread so large files never sit in memory.
+class StageRedirects {
+public:
+    StageRedirects() = default;
+    StageRedirects(const StageRedirects&) = delete;
+    StageRedirects& operator=(const StageRedirects&) = delete;
+
+    ~StageRedirects() {
+        output.reset();  // flush into the file before closing it
+        if (output_file_) {
+            std::fclose(output_file_);
+        }
+        if (input) {
+            input->close_read();
+        }
+        if (feeder_.joinable()) {
+            feeder_.join();
+        }
+    }
+
+    bool open(const std::string& input_path, const std::string& output_path, bool append,
+              const std::string& working_directory, std::string& error) {
+        if (!output_path.empty()) {
+            output_file_ = open_redirect(output_path, working_directory, true, append);
+            if (!output_file_) {
+                error = "Cannot open output file: " + output_path + "\n";
+                return false;
+            }
+            output = std::make_unique<OutputSink>(OutputSink::to_file(output_file_));
+#ifndef _WIN32
+            output->set_native_fd(fileno(output_file_));  // external programs write straight to the file
+#endif
+        }
+
+        if (!input_path.empty()) {
+            std::FILE* file = open_redirect(input_path, working_directory, false, false);
+            if (!file) {
+                error = "Cannot open input file: " + input_path + "\n";
+                return false;
+            }
+            input = std::make_shared<CommandStream>();
+            feeder_ = std::thread([file, stream = input]() {
+                char buffer[8192];
+                size_t count;
+                while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                    if (!stream->write(buffer, count)) break;
+                }
+                std::fclose(file);
+                stream->close_write();
+            });
+        }
+        return true;
+    }
+
+    std::shared_ptr<CommandStream> input;
+    std::unique_ptr<OutputSink> output;
+
+private:
+    std::FILE* output_file_ = nullptr;
+    std::thread feeder_;
+};
+
 CommandProcessor::CommandProcessor() {
     registry_ = std::make_unique<CommandRegistry>();
 }
 
-CommandProcessor::~CommandProcessor() = default;
+CommandProcessor::~CommandProcessor() {
+    // Background jobs run our handlers; stop them before the registry goes
+    // away, and leave it in place for any that ignore cancellation
+    if (!JobTable::instance().stop_all()) {
+        registry_.release();
+    }
+}
 
 bool CommandProcessor::initialize() {
+    // AI commands need the API key from the database and a configured
+    // client; only the first ai-* command pays for that
+    LazySubsystems::instance().add("ai", [] { return ai::initialize_ai_modules(); });
+    registry_->bind_subsystem("ai-", "ai");
+
+    CommandRegistry::Batch batch(*registry_);
     register_builtin_commands();
+    register_stream_commands();     // Pipeline filters (grep, head, wc)
+    register_job_commands();        // Background job control
+    register_path_commands();       // External program lookup
     register_scheduler_commands();  // Add scheduler commands
     register_ai_commands();         // Add AI commands
     return true;
 }
 
 CommandResult CommandProcessor::process(const std::string& command_line) {
+    // Default sink drains wherever the calling thread's std::cout points,
+    // flushing at std::flush/std::endl so interactive prompts still appear
+    OutputSink sink(OutputSink::to_streambuf(OutputRouter::current()),
+                    OutputSink::DEFAULT_CHUNK_SIZE, true);
+#ifndef _WIN32
+    if (!OutputRouter::redirected()) {
+        sink.set_native_fd(fileno(stdout));  // external programs get the terminal itself
+    }
+#endif
+    Invocation invocation;
+    invocation.run_programs = true;
+    invocation.interactive = true;
+    return process(command_line, sink, invocation);
+}
+
+CommandResult CommandProcessor::process(const std::string& command_line, OutputSink& sink) {
+    return process(command_line, sink, Invocation());
+}
+
+CommandResult CommandProcessor::process(const std::string& command_line, OutputSink& sink,
+                                        const Invocation& invocation) {
     CommandResult result;
     result.success = false;
     result.exit_code = 1;
 
     try {
-        // Parse the command
-        ParsedCommand cmd = parse_command(command_line);
+        // Parse the command line into one or more pipeline stages
+        std::vector<ParsedCommand> stages;
+        std::string parse_error;
+        if (!parse_pipeline(command_line, invocation, stages, parse_error)) {
+            result.output = "Syntax error: " + parse_error + "\n";
+            result.exit_code = 2;
+            return result;
+        }
 
-        if (cmd.name.empty()) {
+        if (stages.empty() || stages.front().name.empty()) {
             result.output = "Error: Empty command\n";
             return result;
         }
 
+        // A trailing '&' hands the whole pipeline to the worker pool
+        bool background = std::any_of(stages.begin(), stages.end(),
+                                      [](const ParsedCommand& stage) { return stage.background; });
+        if (background) {
+            std::string job_command = command_line;
+            size_t end = job_command.find_last_not_of(" \t&");
+            job_command.erase(end == std::string::npos ? 0 : end + 1);
+
+            int job_id = JobTable::instance().start(job_command,
+                [this, stages, invocation](OutputSink& output) {
+                    CommandResult job_result = stages.size() == 1
+                        ? execute_parsed_command(stages.front(), output, invocation)
+                        : execute_pipeline(stages, output, invocation);
+                    output.write(job_result.output);
+                    return job_result.exit_code;
+                });
+            result.output = "[" + std::to_string(job_id) + "] Started in background: " + job_command + "\n";
+            result.success = true;
+            result.exit_code = 0;
+            return result;
+        }
+
         // Execute the command
-        result = execute_parsed_command(cmd);
+        if (stages.size() == 1) {
+            result = execute_parsed_command(stages.front(), sink, invocation);
+        }
+        else {
+            result = execute_pipeline(stages, sink, invocation);
+        }
     }
     catch (const std::exception& e) {
         result.output = std::string("Command execution error: ") + e.what() + "\n";
@@ -117,6 +307,14 @@ CommandResult CommandProcessor::process(const std::string& command_line) {
         result.exit_code = 1;
     }
 
+    sink.flush();
+    return result;
+}
+
+CommandResult CommandProcessor::capture(const std::string& command_line) {
+    OutputSink sink;
+    CommandResult result = process(command_line, sink);
+    result.output = sink.take() + result.output;
     return result;
 }
 
@@ -124,65 +322,290 @@ CommandRegistry* CommandProcessor::get_registry() {
     return registry_.get();
 }
 
-CommandProcessor::ParsedCommand CommandProcessor::parse_command(const std::string& command_line) {
-    ParsedCommand cmd;
-    cmd.append_output = false;
-    cmd.background = false;
+CommandResult CommandProcessor::execute_parsed_command(const ParsedCommand& cmd, OutputSink& sink,
+                                                       const Invocation& invocation) {
+    CommandResult result;
+    result.success = false;
+    result.exit_code = 1;
 
-    std::istringstream iss(command_line);
-    std::string token;
+    // Registered commands first, then programs on PATH
+    std::string program;
+    if (invocation.run_programs && !registry_->handles(cmd.name, cmd.arguments)) {
+        program = find_program(cmd.name, invocation);
+    }
+    if (program.empty() && !registry_->has_command(cmd.name)) {
+        result.output = not_found_message(cmd.name);
+        result.success = false;
+        result.exit_code = 127;
+        return result;
+    }
+
+    // Open '<', '>' and '>>' targets
+    StageRedirects redirects;
+    if (!redirects.open(cmd.input_redirect, cmd.output_redirect, cmd.append_output,
+                        invocation.working_directory, result.output)) {
+        return result;
+    }
+
+    // Create command context
+    CommandContext context = make_context(cmd, invocation);
+    if (redirects.input) {
+        context.input = redirects.input;
+    }
+    context.sink = redirects.output ? redirects.output.get() : &sink;
+
+    // Execute the command; std::cout on this thread feeds the sink
+    {
+        OutputRouter::Scope scope(context.sink);
+        result.exit_code = program.empty()
+            ? registry_->execute(cmd.name, context)
+            : run_program(program, cmd, context, invocation);
+    }
+    context.sink->flush();
+    result.success = (result.exit_code == 0);
+
+    return result;
+}
+
+bool CommandProcessor::parse_pipeline(const std::string& command_line, const Invocation& invocation,
+                                      std::vector<ParsedCommand>& stages, std::string& error) {
+    // One tokenizer per thread: its arena is reused, so tokenizing does
+    // not allocate once warm. The stages below still copy each word.
+    thread_local Tokenizer tokenizer;
+
+    // Client environment (daemon mode) first, then our own
+    auto lookup = [&invocation](std::string_view name, std::string_view& value) {
+        if (!invocation.environment.empty()) {
+            auto it = invocation.environment.find(std::string(name));
+            if (it != invocation.environment.end()) {
+                value = it->second;
+                return true;
+            }
+            return false;
+        }
+        char buffer[256];
+        if (name.size() >= sizeof(buffer)) {
+            return false;
+        }
+        name.copy(buffer, name.size());
+        buffer[name.size()] = '\0';
+        const char* env = std::getenv(buffer);
+        if (!env) {
+            return false;
+        }
+        value = env;
+        return true;
+    };
+
+    if (!tokenizer.tokenize(command_line, lookup)) {
+        error = tokenizer.error();
+        return false;
+    }
+
+    stages.clear();
+    const auto& tokens = tokenizer.tokens();
+    if (tokens.empty()) {
+        return true;
+    }
 
-    // Extract command name
-    if (!(iss >> cmd.name)) {
+    auto new_stage = [&stages]() -> ParsedCommand& {
+        stages.emplace_back();
+        ParsedCommand& cmd = stages.back();
+        cmd.append_output = false;
+        cmd.background = false;
         return cmd;
+    };
+
+    ParsedCommand* cmd = &new_stage();
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const Token& token = tokens[i];
+        switch (token.type) {
+            case TokenType::WORD:
+                if (cmd->name.empty() && cmd->arguments.empty()) {
+                    cmd->name.assign(token.text);
+                }
+                else {
+                    cmd->arguments.emplace_back(token.text);
+                }
+                break;
+            case TokenType::PIPE:
+                cmd = &new_stage();
+                break;
+            case TokenType::REDIRECT_IN:
+                cmd->input_redirect.assign(tokens[++i].text);  // tokenizer checked a word follows
+                break;
+            case TokenType::REDIRECT_OUT:
+            case TokenType::REDIRECT_APPEND:
+                cmd->output_redirect.assign(tokens[++i].text);
+                cmd->append_output = (token.type == TokenType::REDIRECT_APPEND);
+                break;
+            case TokenType::BACKGROUND:
+                cmd->background = true;
+                break;
+        }
     }
 
-    // Parse arguments and special operators
-    while (iss >> token) {
-        if (token == ">") {
-            iss >> cmd.output_redirect;
-            cmd.append_output = false;
+    return true;
+}
+
+CommandResult CommandProcessor::execute_pipeline(const std::vector<ParsedCommand>& stages, OutputSink& sink,
+                                                 const Invocation& invocation) {
+    CommandResult result;
+    result.success = false;
+    result.exit_code = 1;
+
+    std::vector<StageRedirects> redirects(stages.size());
+    std::vector<std::string> programs(stages.size());
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (stages[i].name.empty()) {
+            result.output = "Error: Empty pipeline stage\n";
+            return result;
         }
-        else if (token == ">>") {
-            iss >> cmd.output_redirect;
-            cmd.append_output = true;
+        if (invocation.run_programs && !registry_->handles(stages[i].name, stages[i].arguments)) {
+            programs[i] = find_program(stages[i].name, invocation);
         }
-        else if (token == "<") {
-            iss >> cmd.input_redirect;
+        if (programs[i].empty() && !registry_->has_command(stages[i].name)) {
+            result.output = not_found_message(stages[i].name);
+            result.exit_code = 127;
+            return result;
         }
-        else if (token == "&") {
-            cmd.background = true;
+        const ParsedCommand& stage = stages[i];
+        if (!redirects[i].open(stage.input_redirect, stage.output_redirect, stage.append_output,
+                               invocation.working_directory, result.output)) {
+            return result;
         }
-        else {
-            cmd.arguments.push_back(token);
+    }
+
+    // Connect neighbouring stages with bounded in-memory streams
+    std::vector<std::shared_ptr<CommandStream>> streams;
+    for (size_t i = 0; i + 1 < stages.size(); ++i) {
+        streams.push_back(std::make_shared<CommandStream>());
+    }
+
+    std::vector<int> exit_codes(stages.size(), 1);
+    std::vector<std::thread> workers;
+    workers.reserve(stages.size());
+
+    // Ctrl-C is for the pipeline's programs until every stage is done, not
+    // only while the one reading the terminal runs
+    std::unique_ptr<ForegroundSignals> foreground;
+    if (invocation.interactive && !JobTable::current_cancel_flag() &&
+        std::any_of(programs.begin(), programs.end(), [](const std::string& program) { return !program.empty(); })) {
+        foreground = std::make_unique<ForegroundSignals>();
+    }
+
+    // Every stage runs on its own thread so producers and consumers overlap
+    for (size_t i = 0; i < stages.size(); ++i) {
+        CommandContext context = make_context(stages[i], invocation);
+        if (redirects[i].input) {
+            context.input = redirects[i].input;
+            if (i > 0) {
+                streams[i - 1]->close_read();  // nobody reads it; release the writer
+            }
+        }
+        else if (i > 0) {
+            context.input = streams[i - 1];
         }
+        if (i + 1 < stages.size()) {
+            if (redirects[i].output) {
+                streams[i]->close_write();  // output goes to the file; next stage sees EOF
+            }
+            else {
+                context.output = streams[i];
+            }
+        }
+
+        workers.emplace_back([this, &stages, &programs, &exit_codes, &redirects, &sink, &invocation,
+                              i, context]() mutable {
+            // Middle stages write into the next stream; the last stage writes
+            // into the caller's sink unless it redirects to a file
+            std::unique_ptr<OutputSink> pipe_sink;
+            if (redirects[i].output) {
+                context.sink = redirects[i].output.get();
+            }
+            else if (context.output) {
+                pipe_sink = std::make_unique<OutputSink>(OutputSink::to_stream(context.output));
+                context.sink = pipe_sink.get();
+            }
+            else {
+                context.sink = &sink;
+            }
+
+            {
+                OutputRouter::Scope scope(context.sink);
+                exit_codes[i] = programs[i].empty()
+                    ? registry_->execute(stages[i].name, context)
+                    : run_program(programs[i], stages[i], context, invocation);
+            }
+
+            // Flush what is left, then signal EOF downstream and release upstream
+            context.sink->flush();
+            if (context.output) {
+                context.output->close_write();
+            }
+            if (context.input) {
+                context.input->close_read();
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
     }
 
-    return cmd;
+    // Like POSIX shells, the pipeline reports the status of its last stage
+    result.exit_code = exit_codes.back();
+    result.success = (result.exit_code == 0);
+    return result;
 }
 
-CommandResult CommandProcessor::execute_parsed_command(const ParsedCommand& cmd) {
-    CommandResult result;
+std::string CommandProcessor::not_found_message(const std::string& name) const {
+    std::string message = "Command not found: " + name + "\n";
+    auto similar = registry_->suggest_similar(name);
+    if (!similar.empty()) {
+        message += "Did you mean: ";
+        for (size_t i = 0; i < similar.size(); ++i) {
+            message += (i > 0 ? ", " : "") + similar[i];
+        }
+        message += "?\n";
+    }
+    return message;
+}
 
-    // Check if command exists
-    if (!registry_->has_command(cmd.name)) {
-        result.output = "Command not found: " + cmd.name + "\n";
-        result.success = false;
-        result.exit_code = 127;
-        return result;
+std::string CommandProcessor::find_program(const std::string& name, const Invocation& invocation) {
+    // Daemon clients are resolved against their own PATH
+    std::string path_env;
+    auto it = invocation.environment.find("PATH");
+    if (it != invocation.environment.end()) {
+        path_env = it->second;
+    }
+    else if (const char* env = std::getenv("PATH")) {
+        path_env = env;
     }
+    return PathCache::instance().resolve(name, path_env);
+}
 
-    // Create command context
+int CommandProcessor::run_program(const std::string& program, const ParsedCommand& cmd,
+                                  const CommandContext& context, const Invocation& invocation) {
+    std::vector<std::string> argv;
+    argv.reserve(cmd.arguments.size() + 1);
+    argv.push_back(cmd.name);
+    argv.insert(argv.end(), cmd.arguments.begin(), cmd.arguments.end());
+    return ExternalCommand::run(program, argv, context, invocation.working_directory, invocation.interactive);
+}
+
+CommandContext CommandProcessor::make_context(const ParsedCommand& cmd, const Invocation& invocation) {
     CommandContext context;
     context.args = cmd.arguments;
     context.current_user = auth::Authentication::instance().get_current_user();
-    context.working_directory = "/"; // TODO: Implement working directory
-
-    // Execute the command
-    result.exit_code = registry_->execute(cmd.name, context);
-    result.success = (result.exit_code == 0);
-
-    return result;
+    context.working_directory = invocation.working_directory.empty()
+        ? "/"  // TODO: Implement working directory
+        : invocation.working_directory;
+    context.environment = invocation.environment;
+    context.input = invocation.input;  // null: handlers fall back to std::cin
+    context.cancel_flag = JobTable::current_cancel_flag();
+    context.interactive = invocation.interactive;
+    return context;
 }
 
 void CommandProcessor::register_builtin_commands() {
@@ -364,7 +787,8 @@ void CommandProcessor::register_builtin_commands() {
         else if (arg == "12" || arg == "analytics" || arg == "dashboard") {
             show_category_help("📊 Analytics", {
                 {"dashboard [name]", "Show analytics dashboard"},
-                {"analytics [metric]", "Show analytics metrics or overview"}
+                {"analytics [metric]", "Show analytics metrics or overview"},
+                {"perf-stats [command]", "Show per-command latency percentiles"}
             });
         }
         else if (arg == "13" || arg == "environment" || arg == "env") {
@@ -406,14 +830,28 @@ void CommandProcessor::register_builtin_commands() {
         }
         else if (arg == "20" || arg == "logging" || arg == "logs") {
             show_category_help("📋 Logging", {
-                {"log-show [count]", "Show recent system logs and audit entries"}
+                {"log-show [count] [--disk]", "Show recent system logs and audit entries"},
+                {"audit-verify", "Check the audit journal for tampering"}
             });
         }
         else if (arg == "21" || arg == "utilities" || arg == "util") {
             show_category_help("🛠️ Utilities", {
                 {"help [category|command]", "Show help for categories or specific commands"},
                 {"version", "Show NovaShell version information"},
-                {"echo <text>", "Display text or variables"}
+                {"echo <text>", "Display text or variables"},
+                {"cd [directory]", "Change the working directory"},
+                {"history [-a] [count]", "Show recent commands (-a: all sessions)"},
+                {"grep [-i] [-v] [-c] <pattern>", "Filter piped input lines containing a pattern"},
+                {"head [-n count]", "Show the first lines of piped input"},
+                {"wc [-l|-w|-c]", "Count lines, words and bytes of piped input"},
+                {"<cmd> | <cmd> ...", "Stream one command's output into the next"},
+                {"<cmd> &", "Run a command as a background job"},
+                {"jobs", "List background jobs with wall and CPU time"},
+                {"fg [%job]", "Wait for a job and show its output"},
+                {"wait [%job]", "Wait for one or all background jobs"},
+                {"kill %job", "Cancel a background job"},
+                {"which <name>...", "Show whether a name is a built-in or a program on PATH"},
+                {"rehash", "Forget cached PATH lookups"}
             });
         }
         else if (arg == "all") {
@@ -477,6 +915,68 @@ void CommandProcessor::register_builtin_commands() {
     };
     registry_->register_command(echo_cmd);
 
+    // Cd command
+    CommandInfo cd_cmd;
+    cd_cmd.name = "cd";
+    cd_cmd.description = "Change the working directory";
+    cd_cmd.usage = "cd [directory]";
+    cd_cmd.handler = [](const CommandContext& ctx) -> int {
+        // The working directory belongs to the whole process; clients of the
+        // daemon or a remote API pass their own with each request instead
+        if (!ctx.interactive) {
+            std::cout << "cd: only available in the interactive shell; run the command from the target directory\n";
+            return 1;
+        }
+        std::string target = ctx.args.empty() ? "" : ctx.args[0];
+        // Also starts reading the new directory for completion
+        if (!DirectoryCache::instance().change_directory(target)) {
+            std::cout << "cd: cannot enter " << (target.empty() ? "home directory" : target) << "\n";
+            return 1;
+        }
+        return 0;
+    };
+    registry_->register_command(cd_cmd);
+
+    // History command
+    CommandInfo history_cmd;
+    history_cmd.name = "history";
+    history_cmd.description = "Show recent commands";
+    history_cmd.usage = "history [-a] [count]";
+    history_cmd.handler = [](const CommandContext& ctx) -> int {
+        size_t count = 20;
+        bool all_sessions = false;
+        for (const auto& arg : ctx.args) {
+            if (arg == "-a") {
+                all_sessions = true;
+                continue;
+            }
+            try {
+                count = static_cast<size_t>(std::stoul(arg));
+            } catch (...) {
+                std::cout << "Usage: history [-a] [count]\n";
+                return 1;
+            }
+        }
+
+        if (all_sessions) {
+            // Commands from every session of this process, latest run of each
+            for (const auto& entry : HistoryJournal::instance().merged(count, true)) {
+                std::cout << std::setw(6) << entry.sequence << "  " << std::left << std::setw(7)
+                          << entry.origin << std::right << " " << entry.command << "\n";
+            }
+            return 0;
+        }
+
+        auto& history = CommandHistory::instance();
+        auto entries = history.recent(count);
+        size_t number = history.size() - entries.size() + 1;
+        for (const auto& entry : entries) {
+            std::cout << std::setw(6) << number++ << "  " << entry.command << "\n";
+        }
+        return 0;
+    };
+    registry_->register_command(history_cmd);
+
     // Whoami command
     CommandInfo whoami_cmd;
     whoami_cmd.name = "whoami";
@@ -2471,7 +2971,7 @@ void CommandProcessor::register_builtin_commands() {
     CommandInfo log_show_cmd;
     log_show_cmd.name = "log-show";
     log_show_cmd.description = "Show recent log entries";
-    log_show_cmd.usage = "log-show [count]";
+    log_show_cmd.usage = "log-show [count] [--disk]";
     log_show_cmd.handler = [](const CommandContext& ctx) -> int {
         if (!auth::Authentication::instance().is_logged_in()) {
             std::cout << "You must be logged in to view logs.\n";
@@ -2479,16 +2979,32 @@ void CommandProcessor::register_builtin_commands() {
         }
 
         size_t count = 10;
-        if (!ctx.args.empty()) {
+        bool from_disk = false;
+        for (const auto& arg : ctx.args) {
+            if (arg == "--disk") {
+                from_disk = true;
+                continue;
+            }
             try {
-                count = std::stoul(ctx.args[0]);
+                count = std::stoul(arg);
             } catch (...) {
                 count = 10;
             }
         }
 
-        auto logs = logging::Logger::instance().get_logs(count);
-        auto audit = logging::Logger::instance().get_audit_trail(count);
+        // --disk reads the binary log (started with --log-dir) and the audit
+        // journal, which outlive the in-memory history
+        auto logs = from_disk ? logging::Logger::instance().read_binary_logs(count)
+                              : logging::Logger::instance().get_logs(count);
+        std::vector<logging::AuditEntry> audit;
+        if (from_disk) {
+            for (auto& record : logging::Logger::instance().read_audit_journal(count)) {
+                audit.push_back(std::move(record.entry));
+            }
+        }
+        else {
+            audit = logging::Logger::instance().get_audit_trail(count);
+        }
 
         if (logs.empty() && audit.empty()) {
             std::cout << "No log entries found.\n";
@@ -2546,6 +3062,35 @@ void CommandProcessor::register_builtin_commands() {
     };
     registry_->register_command(log_show_cmd);
 
+    CommandInfo audit_verify_cmd;
+    audit_verify_cmd.name = "audit-verify";
+    audit_verify_cmd.description = "Check the audit journal's hash chain for tampering";
+    audit_verify_cmd.usage = "audit-verify";
+    audit_verify_cmd.handler = [](const CommandContext&) -> int {
+        if (!auth::Authentication::instance().is_logged_in()) {
+            std::cout << "You must be logged in to verify the audit journal.\n";
+            return 1;
+        }
+
+        // Checked first: a damaged journal is never opened, so it has no entries to show
+        auto& logger = logging::Logger::instance();
+        uint64_t broken = logger.verify_audit_journal();
+        if (broken != 0) {
+            std::cout << "Audit journal TAMPERED: hash chain breaks at entry #" << broken << "\n";
+            return 1;
+        }
+
+        auto newest = logger.read_audit_journal(1);
+        if (newest.empty()) {
+            std::cout << "The audit journal is empty or not open.\n";
+            return 1;
+        }
+        std::cout << "Audit journal intact: " << newest.front().sequence << " entries, head "
+                  << newest.front().hash.substr(0, 16) << "\n";
+        return 0;
+    };
+    registry_->register_command(audit_verify_cmd);
+
     // File utilities
     CommandInfo file_list_cmd;
     file_list_cmd.name = "file-list";
@@ -3621,22 +4166,40 @@ void CommandProcessor::register_builtin_commands() {
         std::cout << "🤖 AI Completion Learning Statistics\n";
         std::cout << "====================================\n\n";
 
-        // Get analytics summary from database
-        auto& db = database::InternalDB::instance();
-        auto analytics_summary = db.get_analytics_summary();
+        // Loads the learning model and the suggestion cache if Tab has not yet
+        LazySubsystems::instance().ensure("completion");
+        auto& completion = TabCompletion::instance();
 
-        if (analytics_summary.empty()) {
+        auto usage = completion.learned_command_counts(CommandModel::TOP_K);
+        if (usage.empty()) {
             std::cout << "No learning data available yet.\n";
-            std::cout << "Start using commands to build your personalized suggestions!\n";
-            return 0;
+            std::cout << "Start using commands to build your personalized suggestions!\n\n";
         }
-
-        std::cout << "📊 Command Usage Patterns:\n";
-        std::cout << "==========================\n";
-        for (const auto& pair : analytics_summary) {
-            std::cout << "  " << pair.first.substr(14) << ": " << pair.second << " times\n";
+        else {
+            std::cout << "📊 Command Usage Patterns:\n";
+            std::cout << "==========================\n";
+            for (const auto& pair : usage) {
+                std::cout << "  " << pair.first << ": " << pair.second << " times\n";
+            }
+            std::cout << "\n";
         }
-        std::cout << "\n";
+
+        auto cache = completion.ai_cache_stats();
+        uint64_t lookups = cache.hits + cache.disk_hits + cache.prefix_hits + cache.misses;
+        std::cout << "🗄️ AI Suggestion Cache:\n";
+        std::cout << "======================\n";
+        std::cout << "  Hits (memory):   " << cache.hits << "\n";
+        std::cout << "  Hits (disk):     " << cache.disk_hits << "\n";
+        std::cout << "  Hits (prefix):   " << cache.prefix_hits << "\n";
+        std::cout << "  Misses:          " << cache.misses << "\n";
+        if (lookups > 0) {
+            std::cout << "  Hit rate:        " << std::fixed << std::setprecision(1)
+                      << 100.0 * static_cast<double>(lookups - cache.misses) / static_cast<double>(lookups) << "%\n";
+        }
+        std::cout << "  Evictions:       " << cache.evictions << "\n";
+        std::cout << "  Entries:         " << cache.memory_entries << " in memory (max "
+                  << SuggestionCache::MEMORY_ENTRIES << "), " << cache.disk_entries << " on disk (max "
+                  << SuggestionCache::DISK_ENTRIES << ")\n\n";
 
         std::cout << "💡 How AI Completion Works:\n";
         std::cout << "===========================\n";
@@ -3657,7 +4220,7 @@ void CommandProcessor::register_builtin_commands() {
         std::cout << "====================\n";
         std::cout << "• Context-aware: Considers current directory and recent commands\n";
         std::cout << "• Multi-modal: Combines AI, learning, and traditional completion\n";
-        std::cout << "• Caching: Fast response with 5-minute AI suggestion cache\n";
+        std::cout << "• Caching: AI suggestions are kept for 24 hours, across sessions, and reused as you type on\n";
         std::cout << "• Persistent: Learning data survives shell restarts\n";
 
         return 0;
@@ -3917,6 +4480,65 @@ void CommandProcessor::register_builtin_commands() {
     };
     registry_->register_command(analytics_metrics_cmd);
 
+    // Per-command dispatch latency
+    CommandInfo perf_stats_cmd;
+    perf_stats_cmd.name = "perf-stats";
+    perf_stats_cmd.description = "Show per-command latency percentiles (wall and CPU time)";
+    perf_stats_cmd.usage = "perf-stats [command|--reset]";
+    perf_stats_cmd.handler = [](const CommandContext& ctx) -> int {
+        if (!ctx.args.empty() && ctx.args[0] == "--reset") {
+            CommandMetrics::reset();
+            std::cout << "Command timings cleared.\n";
+            return 0;
+        }
+
+        auto stats = CommandMetrics::snapshot();
+        if (!ctx.args.empty()) {
+            stats.erase(std::remove_if(stats.begin(), stats.end(),
+                [&ctx](const CommandStats& s) { return s.name != ctx.args[0]; }), stats.end());
+            if (stats.empty()) {
+                std::cout << "No timings recorded for '" << ctx.args[0] << "'.\n";
+                return 1;
+            }
+        }
+        if (stats.empty()) {
+            std::cout << "No commands timed yet.\n";
+            return 0;
+        }
+
+        // Slowest first by p99 wall time
+        std::sort(stats.begin(), stats.end(), [](const CommandStats& a, const CommandStats& b) {
+            return a.wall.percentile(0.99) > b.wall.percentile(0.99);
+        });
+
+        auto ms = [](uint64_t us) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(3) << us / 1000.0;
+            return out.str();
+        };
+
+        std::cout << "⏱️  Command Latency (ms)\n";
+        std::cout << "=======================\n\n";
+        std::cout << std::left << std::setw(22) << "COMMAND" << std::right
+                  << std::setw(8) << "CALLS" << std::setw(6) << "FAIL"
+                  << std::setw(10) << "p50" << std::setw(10) << "p90"
+                  << std::setw(10) << "p99" << std::setw(11) << "max"
+                  << std::setw(10) << "cpu p50" << std::setw(10) << "cpu p99" << "\n";
+        for (const auto& s : stats) {
+            std::cout << std::left << std::setw(22) << s.name << std::right
+                      << std::setw(8) << s.calls << std::setw(6) << s.failures
+                      << std::setw(10) << ms(s.wall.percentile(0.50))
+                      << std::setw(10) << ms(s.wall.percentile(0.90))
+                      << std::setw(10) << ms(s.wall.percentile(0.99))
+                      << std::setw(11) << ms(s.wall.max())
+                      << std::setw(10) << ms(s.cpu.percentile(0.50))
+                      << std::setw(10) << ms(s.cpu.percentile(0.99)) << "\n";
+        }
+        std::cout << std::left;
+        return 0;
+    };
+    registry_->register_command(perf_stats_cmd);
+
     // P2P File Sharing commands
     CommandInfo p2p_start_cmd;
     p2p_start_cmd.name = "p2p-start";
@@ -4684,6 +5306,356 @@ void CommandProcessor::register_builtin_commands() {
     registry_->register_command(env_create_cmd);
 }
 
+void CommandProcessor::register_stream_commands() {
+    // These filter their input only. File operands and options they do not
+    // implement go to the program of the same name on PATH; without one
+    // (remote callers) they are refused rather than ignored.
+
+    // Grep command
+    auto grep_handles = [](const std::vector<std::string>& args) {
+        size_t operands = 0;
+        for (const auto& arg : args) {
+            if (arg == "-i" || arg == "-v" || arg == "-c") continue;
+            if (arg.size() > 1 && arg[0] == '-') return false;
+            ++operands;
+        }
+        return operands <= 1;
+    };
+    CommandInfo grep_cmd;
+    grep_cmd.name = "grep";
+    grep_cmd.description = "Print input lines containing a pattern";
+    grep_cmd.usage = "grep [-i] [-v] [-c] <pattern>";
+    grep_cmd.handles = grep_handles;
+    grep_cmd.handler = [grep_handles](const CommandContext& ctx) -> int {
+        if (!grep_handles(ctx.args)) {
+            std::cout << "grep: built-in filters its input only: grep [-i] [-v] [-c] <pattern>\n";
+            return 2;
+        }
+
+        bool ignore_case = false;
+        bool invert = false;
+        bool count_only = false;
+        std::string pattern;
+        bool have_pattern = false;
+
+        for (const auto& arg : ctx.args) {
+            if (arg == "-i") ignore_case = true;
+            else if (arg == "-v") invert = true;
+            else if (arg == "-c") count_only = true;
+            else if (!have_pattern) {
+                pattern = arg;
+                have_pattern = true;
+            }
+        }
+
+        if (!have_pattern) {
+            std::cout << "Usage: grep [-i] [-v] [-c] <pattern>\n";
+            return 2;
+        }
+
+        auto fold = [](std::string text) {
+            std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+            return text;
+        };
+        if (ignore_case) {
+            pattern = fold(pattern);
+        }
+
+        size_t matches = 0;
+        std::string line;
+        while (!ctx.cancelled() && read_input_line(ctx, line)) {
+            bool found = (ignore_case ? fold(line) : line).find(pattern) != std::string::npos;
+            if (found == invert) {
+                continue;
+            }
+            ++matches;
+            if (!count_only) {
+                std::cout << line << '\n';
+                if (output_closed(ctx)) break;
+            }
+        }
+
+        if (count_only) {
+            std::cout << matches << '\n';
+        }
+        return matches > 0 ? 0 : 1;
+    };
+    registry_->register_command(grep_cmd);
+
+    // Head command: "-n N" or "-N"; false for anything else
+    auto head_count = [](const std::vector<std::string>& args, size_t& count) {
+        count = 10;
+        for (size_t i = 0; i < args.size(); ++i) {
+            std::string value;
+            if (args[i] == "-n" && i + 1 < args.size()) {
+                value = args[++i];
+            }
+            else if (args[i].size() > 1 && args[i][0] == '-') {
+                value = args[i].substr(1);
+            }
+            if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+                return false;
+            }
+            try {
+                count = std::stoul(value);
+            } catch (...) {
+                return false;
+            }
+        }
+        return true;
+    };
+    CommandInfo head_cmd;
+    head_cmd.name = "head";
+    head_cmd.description = "Print the first lines of input";
+    head_cmd.usage = "head [-n count]";
+    head_cmd.handles = [head_count](const std::vector<std::string>& args) {
+        size_t count;
+        return head_count(args, count);
+    };
+    head_cmd.handler = [head_count](const CommandContext& ctx) -> int {
+        size_t count;
+        if (!head_count(ctx.args, count)) {
+            std::cout << "head: built-in filters its input only: head [-n count]\n";
+            return 1;
+        }
+
+        // Returning early closes our input, which stops the upstream stage
+        std::string line;
+        for (size_t i = 0; i < count && !ctx.cancelled() && read_input_line(ctx, line); ++i) {
+            std::cout << line << '\n';
+        }
+        return 0;
+    };
+    registry_->register_command(head_cmd);
+
+    // Word count command
+    auto wc_handles = [](const std::vector<std::string>& args) {
+        return args.empty() || (args.size() == 1 && (args[0] == "-l" || args[0] == "-w" || args[0] == "-c"));
+    };
+    CommandInfo wc_cmd;
+    wc_cmd.name = "wc";
+    wc_cmd.description = "Count lines, words and bytes of input";
+    wc_cmd.usage = "wc [-l|-w|-c]";
+    wc_cmd.handles = wc_handles;
+    wc_cmd.handler = [wc_handles](const CommandContext& ctx) -> int {
+        if (!wc_handles(ctx.args)) {
+            std::cout << "wc: built-in filters its input only: wc [-l|-w|-c]\n";
+            return 1;
+        }
+
+        size_t lines = 0;
+        size_t words = 0;
+        size_t bytes = 0;
+
+        std::string line;
+        while (!ctx.cancelled() && read_input_line(ctx, line)) {
+            ++lines;
+            bytes += line.size() + 1;
+            std::istringstream iss(line);
+            std::string word;
+            while (iss >> word) {
+                ++words;
+            }
+        }
+
+        std::string mode = ctx.args.empty() ? "" : ctx.args[0];
+        if (mode == "-l") std::cout << lines << '\n';
+        else if (mode == "-w") std::cout << words << '\n';
+        else if (mode == "-c") std::cout << bytes << '\n';
+        else std::cout << lines << " " << words << " " << bytes << '\n';
+        return 0;
+    };
+    registry_->register_command(wc_cmd);
+}
+
+void CommandProcessor::register_job_commands() {
+    // Parse "%N" or "N"; no argument means the most recent job
+    auto parse_job_id = [](const CommandContext& ctx) -> int {
+        if (ctx.args.empty()) {
+            return JobTable::instance().latest_id();
+        }
+        std::string spec = ctx.args[0];
+        if (!spec.empty() && spec[0] == '%') {
+            spec = spec.substr(1);
+        }
+        try {
+            return std::stoi(spec);
+        } catch (...) {
+            return 0;
+        }
+    };
+
+    // Jobs command
+    CommandInfo jobs_cmd;
+    jobs_cmd.name = "jobs";
+    jobs_cmd.description = "List background jobs with their timing";
+    jobs_cmd.usage = "jobs";
+    jobs_cmd.handler = [](const CommandContext&) -> int {
+        // Finished jobs are reported once, with their output, and forgotten
+        auto finished = JobTable::instance().reap_finished();
+        for (const auto& job : finished) {
+            std::cout << job.output << JobTable::status_line(job.info) << "\n";
+        }
+
+        auto jobs = JobTable::instance().list();
+        if (jobs.empty()) {
+            if (finished.empty()) {
+                std::cout << "No background jobs.\n";
+            }
+            return 0;
+        }
+
+        std::cout << std::left << std::setw(6) << "JOB" << std::setw(12) << "STATE"
+                  << std::setw(10) << "WALL" << std::setw(10) << "CPU"
+                  << std::setw(10) << "OUTPUT" << "COMMAND\n";
+        for (const auto& job : jobs) {
+            std::string state = JobTable::state_to_string(job.state);
+            if (job.state == JobState::DONE) {
+                state += "(" + std::to_string(job.exit_code) + ")";
+            }
+            std::ostringstream wall, cpu;
+            wall << std::fixed << std::setprecision(2) << job.wall_ms / 1000.0 << "s";
+            cpu << std::fixed << std::setprecision(2) << job.cpu_ms / 1000.0 << "s";
+
+            std::cout << std::left << std::setw(6) << ("[" + std::to_string(job.id) + "]")
+                      << std::setw(12) << state << std::setw(10) << wall.str()
+                      << std::setw(10) << cpu.str() << std::setw(10) << job.output_bytes
+                      << job.command << "\n";
+        }
+        std::cout << std::right;
+        return 0;
+    };
+    registry_->register_command(jobs_cmd);
+
+    // Foreground command
+    CommandInfo fg_cmd;
+    fg_cmd.name = "fg";
+    fg_cmd.description = "Wait for a background job and show its output";
+    fg_cmd.usage = "fg [%job]";
+    fg_cmd.handler = [parse_job_id](const CommandContext& ctx) -> int {
+        if (ctx.cancel_flag) {
+            // A job waiting on jobs could wait on itself, or hold the
+            // worker the awaited job is queued behind
+            std::cout << "fg: not available in a background job\n";
+            return 1;
+        }
+
+        int id = parse_job_id(ctx);
+        JobInfo info;
+        std::string output;
+        if (id <= 0 || !JobTable::instance().collect(id, info, output)) {
+            std::cout << "fg: no such job\n";
+            return 1;
+        }
+
+        std::cout << output;
+        if (info.state == JobState::KILLED) {
+            std::cout << "[" << id << "] Killed\n";
+            return 1;
+        }
+        return info.exit_code;
+    };
+    registry_->register_command(fg_cmd);
+
+    // Wait command
+    CommandInfo wait_cmd;
+    wait_cmd.name = "wait";
+    wait_cmd.description = "Wait for background jobs to finish";
+    wait_cmd.usage = "wait [%job]";
+    wait_cmd.handler = [parse_job_id](const CommandContext& ctx) -> int {
+        if (ctx.cancel_flag) {
+            std::cout << "wait: not available in a background job\n";
+            return 1;
+        }
+
+        if (ctx.args.empty()) {
+            JobTable::instance().wait_all();
+            return 0;
+        }
+
+        JobInfo info;
+        if (!JobTable::instance().wait(parse_job_id(ctx), info)) {
+            std::cout << "wait: no such job\n";
+            return 1;
+        }
+        std::cout << "[" << info.id << "] " << JobTable::state_to_string(info.state)
+                  << " (exit " << info.exit_code << ")  " << info.command << "\n";
+        return info.state == JobState::DONE ? info.exit_code : 1;
+    };
+    registry_->register_command(wait_cmd);
+
+    // Kill command
+    CommandInfo kill_cmd;
+    kill_cmd.name = "kill";
+    kill_cmd.description = "Cancel a background job (other arguments go to kill on PATH)";
+    kill_cmd.usage = "kill %job";
+    kill_cmd.handles = [](const std::vector<std::string>& args) {
+        return args.empty() || (!args[0].empty() && args[0][0] == '%');
+    };
+    kill_cmd.handler = [parse_job_id](const CommandContext& ctx) -> int {
+        if (ctx.args.empty()) {
+            std::cout << "Usage: kill %job\n";
+            return 1;
+        }
+
+        int id = parse_job_id(ctx);
+        if (id <= 0 || !JobTable::instance().kill(id)) {
+            std::cout << "kill: no such job\n";
+            return 1;
+        }
+        std::cout << "[" << id << "] Termination requested\n";
+        return 0;
+    };
+    registry_->register_command(kill_cmd);
+}
+
+void CommandProcessor::register_path_commands() {
+    // Which command
+    CommandInfo which_cmd;
+    which_cmd.name = "which";
+    which_cmd.description = "Show whether a name runs a built-in or a program on PATH";
+    which_cmd.usage = "which <name>...";
+    which_cmd.handler = [this](const CommandContext& ctx) -> int {
+        if (ctx.args.empty()) {
+            std::cout << "Usage: which <name>...\n";
+            return 1;
+        }
+
+        Invocation invocation;
+        invocation.environment = ctx.environment;
+        int status = 0;
+        for (const auto& name : ctx.args) {
+            if (registry_->has_command(name)) {
+                std::cout << name << ": NovaShell built-in\n";
+                continue;
+            }
+            std::string program = find_program(name, invocation);
+            if (program.empty()) {
+                std::cout << name << " not found\n";
+                status = 1;
+            }
+            else {
+                std::cout << program << "\n";
+            }
+        }
+        return status;
+    };
+    registry_->register_command(which_cmd);
+
+    // Rehash command
+    CommandInfo rehash_cmd;
+    rehash_cmd.name = "rehash";
+    rehash_cmd.description = "Forget cached PATH lookups";
+    rehash_cmd.usage = "rehash";
+    rehash_cmd.handler = [](const CommandContext&) -> int {
+        size_t entries = PathCache::instance().size();
+        PathCache::instance().invalidate();
+        std::cout << "Dropped " << entries << " cached program locations\n";
+        return 0;
+    };
+    registry_->register_command(rehash_cmd);
+}
+
 void CommandProcessor::register_scheduler_commands() {
     // Task Scheduling commands
     CommandInfo task_schedule_cmd;
@@ -1,90 +1,197 @@
 #include "core/command_registry.h"
+#include "core/startup_profile.h"
+#include "core/command_metrics.h"
+#include <chrono>
 #include <algorithm>
 #include <mutex>
 
 namespace customos {
 namespace core {
 
-CommandRegistry::CommandRegistry() = default;
-CommandRegistry::~CommandRegistry() = default;
+CommandRegistry::ReadGuard::ReadGuard(const CommandRegistry& registry)
+    : registry_(registry) {
+    registry_.active_readers_.fetch_add(1, std::memory_order_seq_cst);
+    table_ = registry_.table_.load(std::memory_order_seq_cst);
+}
+
+CommandRegistry::ReadGuard::~ReadGuard() {
+    registry_.active_readers_.fetch_sub(1, std::memory_order_release);
+}
+
+CommandRegistry::CommandRegistry()
+    : table_(new CommandTable())
+    , active_readers_(0)
+    , batch_depth_(0) {
+}
+
+CommandRegistry::~CommandRegistry() {
+    delete table_.load();
+}
+
+void CommandRegistry::publish(std::unique_ptr<const CommandTable> table) {
+    // Caller holds write_mutex_
+    const CommandTable* previous = table_.exchange(table.release(), std::memory_order_seq_cst);
+    retired_.emplace_back(previous);
+
+    // Readers register before loading the table, so once the count drops to
+    // zero after the exchange nobody can still hold a retired snapshot.
+    // Otherwise they are reclaimed by a later update or the destructor.
+    if (active_readers_.load(std::memory_order_seq_cst) == 0) {
+        retired_.clear();
+    }
+}
 
 bool CommandRegistry::register_command(const CommandInfo& cmd_info) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     if (cmd_info.name.empty() || !cmd_info.handler) {
         return false;
     }
 
-    if (commands_.find(cmd_info.name) != commands_.end()) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    const CommandTable* current = pending_ ? pending_.get() : table_.load(std::memory_order_acquire);
+
+    if (current->commands.find(cmd_info.name) != current->commands.end()) {
         // Command already exists
         return false;
     }
 
-    commands_[cmd_info.name] = cmd_info;
+    auto info = std::make_shared<CommandInfo>(cmd_info);
+    if (info->subsystem.empty()) {
+        for (const auto& binding : subsystem_bindings_) {
+            if (info->name.compare(0, binding.first.size(), binding.first) == 0) {
+                info->subsystem = binding.second;
+                break;
+            }
+        }
+    }
+
+    if (pending_) {
+        pending_->commands[cmd_info.name] = std::move(info);
+        pending_->names.insert(cmd_info.name);
+        return true;
+    }
+
+    auto next = std::make_unique<CommandTable>(*current);
+    next->commands[cmd_info.name] = std::move(info);
+    next->names.insert(cmd_info.name);
+    publish(std::move(next));
     return true;
 }
 
+void CommandRegistry::bind_subsystem(const std::string& prefix, const std::string& subsystem) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    subsystem_bindings_.emplace_back(prefix, subsystem);
+}
+
+CommandRegistry::Batch::Batch(CommandRegistry& registry)
+    : registry_(registry) {
+    std::lock_guard<std::mutex> lock(registry_.write_mutex_);
+    if (registry_.batch_depth_++ == 0) {
+        registry_.pending_ = std::make_unique<CommandTable>(*registry_.table_.load(std::memory_order_acquire));
+    }
+}
+
+CommandRegistry::Batch::~Batch() {
+    std::lock_guard<std::mutex> lock(registry_.write_mutex_);
+    if (--registry_.batch_depth_ == 0) {
+        registry_.publish(std::move(registry_.pending_));
+    }
+}
+
 bool CommandRegistry::unregister_command(const std::string& name) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return commands_.erase(name) > 0;
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (pending_) {
+        pending_->names.erase(name);
+        return pending_->commands.erase(name) > 0;
+    }
+
+    const CommandTable* current = table_.load(std::memory_order_acquire);
+    if (current->commands.find(name) == current->commands.end()) {
+        return false;
+    }
+
+    auto next = std::make_unique<CommandTable>(*current);
+    next->commands.erase(name);
+    next->names.erase(name);
+    publish(std::move(next));
+    return true;
+}
+
+std::shared_ptr<const CommandInfo> CommandRegistry::lookup(const std::string& name) const {
+    ReadGuard guard(*this);
+    auto it = guard.table().commands.find(name);
+    if (it != guard.table().commands.end()) {
+        return it->second;
+    }
+    return nullptr;
 }
 
 bool CommandRegistry::has_command(const std::string& name) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return commands_.find(name) != commands_.end();
+    ReadGuard guard(*this);
+    return guard.table().commands.find(name) != guard.table().commands.end();
+}
+
+bool CommandRegistry::handles(const std::string& name, const std::vector<std::string>& args) const {
+    std::shared_ptr<const CommandInfo> info = lookup(name);
+    return info && (!info->handles || info->handles(args));
 }
 
 const CommandInfo* CommandRegistry::get_command(const std::string& name) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto it = commands_.find(name);
-    if (it != commands_.end()) {
-        return &it->second;
-    }
-    return nullptr;
+    return lookup(name).get();
 }
 
 int CommandRegistry::execute(const std::string& name, const CommandContext& context) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto it = commands_.find(name);
-    if (it == commands_.end()) {
+    // Holding the entry keeps the handler alive even if it is unregistered
+    // while running
+    std::shared_ptr<const CommandInfo> info = lookup(name);
+    if (!info) {
         return -1; // Command not found
     }
 
+    if (!info->subsystem.empty()) {
+        // Failure is left to the handler, which reports it in its own words
+        LazySubsystems::instance().ensure(info->subsystem);
+    }
+
+    auto wall_start = std::chrono::steady_clock::now();
+    uint64_t cpu_start = CommandMetrics::thread_cpu_us();
+
+    int exit_code;
     try {
-        return it->second.handler(context);
+        exit_code = info->handler(context);
     }
     catch (const std::exception&) {
-        return -1;
+        exit_code = -1;
     }
+
+    uint64_t wall_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - wall_start).count());
+    CommandMetrics::record(name, wall_us, CommandMetrics::thread_cpu_us() - cpu_start, exit_code == 0);
+    return exit_code;
 }
 
 std::vector<std::string> CommandRegistry::list_commands() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
+    ReadGuard guard(*this);
+
     std::vector<std::string> result;
-    result.reserve(commands_.size());
-    
-    for (const auto& pair : commands_) {
+    result.reserve(guard.table().commands.size());
+
+    for (const auto& pair : guard.table().commands) {
         result.push_back(pair.first);
     }
-    
+
     return result;
 }
 
-std::vector<std::string> CommandRegistry::suggest_commands(const std::string& prefix) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    std::vector<std::string> suggestions;
-    
-    for (const auto& pair : commands_) {
-        if (pair.first.find(prefix) == 0) {
-            suggestions.push_back(pair.first);
-        }
-    }
-    
-    std::sort(suggestions.begin(), suggestions.end());
-    return suggestions;
+std::vector<std::string> CommandRegistry::suggest_commands(const std::string& prefix, size_t limit) const {
+    ReadGuard guard(*this);
+    return guard.table().names.with_prefix(prefix, limit);
+}
+
+std::vector<std::string> CommandRegistry::suggest_similar(const std::string& name, size_t limit) const {
+    // One edit for short names, two from five characters on
+    size_t max_distance = name.size() < 5 ? 1 : 2;
+    ReadGuard guard(*this);
+    return guard.table().names.similar(name, max_distance, limit);
 }
 
 } // namespace core
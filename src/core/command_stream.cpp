@@ -0,0 +1,197 @@
+#include "core/command_stream.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+namespace customos {
+namespace core {
+
+// CommandStream
+
+CommandStream::CommandStream(size_t capacity)
+    : buffer_(capacity == 0 ? 1 : capacity)
+    , head_(0)
+    , size_(0)
+    , write_closed_(false)
+    , read_closed_(false) {
+}
+
+CommandStream::~CommandStream() = default;
+
+bool CommandStream::write(const char* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (size > 0) {
+        not_full_.wait(lock, [this] { return read_closed_ || size_ < buffer_.size(); });
+        if (read_closed_ || write_closed_) {
+            return false;
+        }
+
+        // Copy as much as fits, in at most two contiguous runs
+        size_t capacity = buffer_.size();
+        size_t tail = (head_ + size_) % capacity;
+        size_t chunk = std::min(size, capacity - size_);
+        size_t first = std::min(chunk, capacity - tail);
+        std::memcpy(buffer_.data() + tail, data, first);
+        std::memcpy(buffer_.data(), data + first, chunk - first);
+
+        size_ += chunk;
+        data += chunk;
+        size -= chunk;
+        not_empty_.notify_one();
+    }
+
+    return true;
+}
+
+bool CommandStream::write(const std::string& data) {
+    return write(data.data(), data.size());
+}
+
+void CommandStream::close_write() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_closed_ = true;
+    not_empty_.notify_all();
+}
+
+size_t CommandStream::read(char* buffer, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return size_ > 0 || write_closed_ || read_closed_; });
+
+    if (size_ == 0 || read_closed_) {
+        return 0;
+    }
+
+    size_t capacity = buffer_.size();
+    size_t chunk = std::min(size, size_);
+    size_t first = std::min(chunk, capacity - head_);
+    std::memcpy(buffer, buffer_.data() + head_, first);
+    std::memcpy(buffer + first, buffer_.data(), chunk - first);
+
+    head_ = (head_ + chunk) % capacity;
+    size_ -= chunk;
+    not_full_.notify_one();
+    return chunk;
+}
+
+bool CommandStream::read_line(std::string& line) {
+    line.clear();
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        not_empty_.wait(lock, [this] { return size_ > 0 || write_closed_ || read_closed_; });
+        if (read_closed_ || size_ == 0) {
+            // End of stream: hand back a trailing unterminated record
+            return !line.empty();
+        }
+
+        size_t capacity = buffer_.size();
+        while (size_ > 0) {
+            char ch = buffer_[head_];
+            head_ = (head_ + 1) % capacity;
+            --size_;
+            if (ch == '\n') {
+                not_full_.notify_one();
+                return true;
+            }
+            line.push_back(ch);
+        }
+        not_full_.notify_one();
+    }
+}
+
+void CommandStream::close_read() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    read_closed_ = true;
+    size_ = 0;
+    not_full_.notify_all();
+    not_empty_.notify_all();
+}
+
+bool CommandStream::is_reader_closed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return read_closed_;
+}
+
+bool CommandStream::is_writer_closed() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return write_closed_;
+}
+
+// OutputRouter
+
+namespace {
+
+std::atomic<std::streambuf*> g_original_stdout{nullptr};
+thread_local std::streambuf* t_target = nullptr;
+
+std::streambuf* resolve_target() {
+    return t_target ? t_target : g_original_stdout.load(std::memory_order_acquire);
+}
+
+// Unbuffered so every write is dispatched on the writing thread. Failures of
+// the per-thread target are swallowed: std::cout is shared, and a broken pipe
+// in one stage must not set badbit for every other thread.
+class RouterBuf : public std::streambuf {
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            if (std::streambuf* target = resolve_target()) {
+                target->sputc(traits_type::to_char_type(ch));
+            }
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (std::streambuf* target = resolve_target()) {
+            target->sputn(s, n);
+        }
+        return n;
+    }
+
+    int sync() override {
+        if (std::streambuf* target = resolve_target()) {
+            target->pubsync();
+        }
+        return 0;
+    }
+};
+
+RouterBuf g_router;
+std::once_flag g_install_once;
+
+} // anonymous namespace
+
+void OutputRouter::install() {
+    std::call_once(g_install_once, [] {
+        g_original_stdout.store(std::cout.rdbuf(), std::memory_order_release);
+        std::cout.rdbuf(&g_router);
+    });
+}
+
+std::streambuf* OutputRouter::current() {
+    std::streambuf* target = resolve_target();
+    return target ? target : std::cout.rdbuf();
+}
+
+bool OutputRouter::redirected() {
+    return t_target != nullptr;
+}
+
+OutputRouter::Scope::Scope(std::streambuf* target)
+    : previous_(t_target) {
+    install();
+    t_target = target;
+}
+
+OutputRouter::Scope::~Scope() {
+    if (t_target) {
+        t_target->pubsync();
+    }
+    t_target = previous_;
+}
+
+} // namespace core
+} // namespace customos
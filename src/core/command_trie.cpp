@@ -0,0 +1,255 @@
+#include "core/command_trie.h"
+#include <algorithm>
+
+namespace customos {
+namespace core {
+
+namespace {
+
+size_t common_prefix(std::string_view a, std::string_view b) {
+    size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) {
+        ++i;
+    }
+    return i;
+}
+
+} // anonymous namespace
+
+CommandTrie::CommandTrie()
+    : root_(std::make_shared<const Node>())
+    , size_(0) {
+}
+
+size_t CommandTrie::child_index(const Node& node, char first) {
+    // Children are few and sorted; returns children.size() when absent
+    auto it = std::lower_bound(node.children.begin(), node.children.end(), first,
+                               [](const NodePtr& child, char c) {
+                                   return static_cast<unsigned char>(child->edge[0]) < static_cast<unsigned char>(c);
+                               });
+    if (it != node.children.end() && (*it)->edge[0] == first) {
+        return static_cast<size_t>(it - node.children.begin());
+    }
+    return node.children.size();
+}
+
+bool CommandTrie::insert(const std::string& name) {
+    if (name.empty() || contains(name)) {
+        return false;
+    }
+    root_ = insert_at(*root_, name);
+    ++size_;
+    return true;
+}
+
+bool CommandTrie::erase(const std::string& name) {
+    if (name.empty() || !contains(name)) {
+        return false;
+    }
+    root_ = erase_at(*root_, name, true);
+    --size_;
+    return true;
+}
+
+bool CommandTrie::contains(const std::string& name) const {
+    const Node* node = root_.get();
+    std::string_view rest = name;
+    while (!rest.empty()) {
+        size_t i = child_index(*node, rest[0]);
+        if (i == node->children.size()) {
+            return false;
+        }
+        const Node& child = *node->children[i];
+        if (rest.compare(0, child.edge.size(), child.edge) != 0) {
+            return false;
+        }
+        rest.remove_prefix(child.edge.size());
+        node = &child;
+    }
+    return node->terminal;
+}
+
+CommandTrie::NodePtr CommandTrie::insert_at(const Node& node, std::string_view rest) {
+    // The name is known to be absent; copy this node and change one child
+    auto copy = std::make_shared<Node>(node);
+    if (rest.empty()) {
+        copy->terminal = true;
+        return copy;
+    }
+
+    size_t i = child_index(node, rest[0]);
+    if (i == node.children.size()) {
+        auto leaf = std::make_shared<Node>();
+        leaf->edge = std::string(rest);
+        leaf->terminal = true;
+        auto pos = std::lower_bound(copy->children.begin(), copy->children.end(), rest[0],
+                                    [](const NodePtr& child, char c) {
+                                        return static_cast<unsigned char>(child->edge[0]) <
+                                               static_cast<unsigned char>(c);
+                                    });
+        copy->children.insert(pos, std::move(leaf));
+        return copy;
+    }
+
+    const Node& child = *node.children[i];
+    size_t common = common_prefix(child.edge, rest);
+    if (common == child.edge.size()) {
+        copy->children[i] = insert_at(child, rest.substr(common));
+        return copy;
+    }
+
+    // The name leaves the child's edge part way: split it
+    auto middle = std::make_shared<Node>();
+    middle->edge = child.edge.substr(0, common);
+    auto tail = std::make_shared<Node>(child);
+    tail->edge = child.edge.substr(common);
+    middle->children.push_back(std::move(tail));
+    if (common == rest.size()) {
+        middle->terminal = true;
+    }
+    else {
+        auto leaf = std::make_shared<Node>();
+        leaf->edge = std::string(rest.substr(common));
+        leaf->terminal = true;
+        if (static_cast<unsigned char>(leaf->edge[0]) < static_cast<unsigned char>(middle->children[0]->edge[0])) {
+            middle->children.insert(middle->children.begin(), std::move(leaf));
+        }
+        else {
+            middle->children.push_back(std::move(leaf));
+        }
+    }
+    copy->children[i] = std::move(middle);
+    return copy;
+}
+
+CommandTrie::NodePtr CommandTrie::erase_at(const Node& node, std::string_view rest, bool is_root) {
+    // The name is known to be present. Returns the replacement for this
+    // node, or null when nothing is left under it.
+    auto copy = std::make_shared<Node>(node);
+    if (rest.empty()) {
+        copy->terminal = false;
+    }
+    else {
+        size_t i = child_index(node, rest[0]);
+        const Node& child = *node.children[i];
+        NodePtr replacement = erase_at(child, rest.substr(child.edge.size()), false);
+        if (replacement) {
+            copy->children[i] = std::move(replacement);
+        }
+        else {
+            copy->children.erase(copy->children.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+
+    if (is_root || copy->terminal) {
+        return copy;
+    }
+    if (copy->children.empty()) {
+        return nullptr;
+    }
+    if (copy->children.size() == 1) {
+        // Keep the trie compact: fold a lone child into this edge
+        auto merged = std::make_shared<Node>(*copy->children[0]);
+        merged->edge = copy->edge + merged->edge;
+        return merged;
+    }
+    return copy;
+}
+
+std::vector<std::string> CommandTrie::with_prefix(const std::string& prefix, size_t limit) const {
+    std::vector<std::string> out;
+    const Node* node = root_.get();
+    std::string path;
+    std::string_view rest = prefix;
+
+    while (!rest.empty()) {
+        size_t i = child_index(*node, rest[0]);
+        if (i == node->children.size()) {
+            return out;
+        }
+        const Node& child = *node->children[i];
+        size_t common = common_prefix(child.edge, rest);
+        if (common < rest.size() && common < child.edge.size()) {
+            return out;  // diverges inside the edge
+        }
+        path += child.edge;
+        rest.remove_prefix(std::min(common, rest.size()));
+        node = &child;
+    }
+
+    collect(*node, path, limit, out);
+    return out;
+}
+
+void CommandTrie::collect(const Node& node, std::string& path, size_t limit, std::vector<std::string>& out) {
+    if (out.size() >= limit) {
+        return;
+    }
+    if (node.terminal) {
+        out.push_back(path);
+    }
+    for (const auto& child : node.children) {
+        if (out.size() >= limit) {
+            return;
+        }
+        path += child->edge;
+        collect(*child, path, limit, out);
+        path.resize(path.size() - child->edge.size());
+    }
+}
+
+std::vector<std::string> CommandTrie::similar(const std::string& name, size_t max_distance, size_t limit) const {
+    // Row j holds the edit distance between the path so far and name[0, j)
+    std::vector<size_t> row(name.size() + 1);
+    for (size_t j = 0; j < row.size(); ++j) {
+        row[j] = j;
+    }
+
+    std::vector<std::pair<size_t, std::string>> found;
+    std::string path;
+    walk_similar(*root_, path, name, row, max_distance, found);
+
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> out;
+    for (size_t i = 0; i < found.size() && out.size() < limit; ++i) {
+        out.push_back(std::move(found[i].second));
+    }
+    return out;
+}
+
+void CommandTrie::walk_similar(const Node& node, std::string& path, std::string_view target,
+                               const std::vector<size_t>& row, size_t max_distance,
+                               std::vector<std::pair<size_t, std::string>>& out) {
+    if (node.terminal && row.back() <= max_distance) {
+        out.emplace_back(row.back(), path);
+    }
+
+    std::vector<size_t> current(row.size());
+    for (const auto& child : node.children) {
+        std::vector<size_t> previous = row;
+        bool reachable = true;
+        for (char c : child->edge) {
+            current[0] = previous[0] + 1;
+            size_t best = current[0];
+            for (size_t j = 1; j < current.size(); ++j) {
+                size_t substitute = previous[j - 1] + (target[j - 1] == c ? 0 : 1);
+                current[j] = std::min({previous[j] + 1, current[j - 1] + 1, substitute});
+                best = std::min(best, current[j]);
+            }
+            previous.swap(current);
+            if (best > max_distance) {
+                reachable = false;  // every extension is at least this far
+                break;
+            }
+        }
+        if (reachable) {
+            path += child->edge;
+            walk_similar(*child, path, target, previous, max_distance, out);
+            path.resize(path.size() - child->edge.size());
+        }
+    }
+}
+
+} // namespace core
+} // namespace customos
@@ -0,0 +1,254 @@
+#include "core/daemon.h"
+#include "core/daemon_protocol.h"
+#include "core/command_stream.h"
+#include "core/history_journal.h"
+#include "logging/logger.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace customos {
+namespace core {
+
+#ifndef _WIN32
+
+namespace proto = daemon_protocol;
+
+struct DaemonServer::Impl {
+    CommandProcessor& processor;
+    std::string socket_path;
+    int listen_fd = -1;
+    std::atomic<bool> stopping{false};
+
+    // Live connections, so shutdown can unblock and wait for them
+    std::mutex mutex;
+    std::condition_variable idle_cv;
+    std::set<int> client_fds;
+
+    explicit Impl(CommandProcessor& p) : processor(p) {}
+
+    void serve(int fd);
+};
+
+void DaemonServer::Impl::serve(int fd) {
+    // Request header: arguments, environment and working directory
+    std::vector<std::string> args;
+    CommandProcessor::Invocation invocation;
+    invocation.run_programs = true;  // only the owner can connect (socket is 0600)
+    char type = 0;
+    std::string payload;
+
+    while (proto::recv_frame(fd, type, payload) && type != proto::FRAME_RUN) {
+        if (type == proto::FRAME_ARG) {
+            args.push_back(payload);
+        }
+        else if (type == proto::FRAME_ENV) {
+            size_t eq = payload.find('=');
+            if (eq != std::string::npos) {
+                invocation.environment[payload.substr(0, eq)] = payload.substr(eq + 1);
+            }
+        }
+        else if (type == proto::FRAME_CWD) {
+            invocation.working_directory = payload;
+        }
+    }
+    if (type != proto::FRAME_RUN) {
+        return;  // client went away before sending a command
+    }
+
+    // Same joining rule as argv-style invocation of the shell itself
+    std::string command;
+    for (size_t i = 0; i < args.size(); ++i) {
+        command += args[i];
+        if (i + 1 < args.size()) command += " ";
+    }
+
+    // Client stdin is pumped into a stream while the command runs
+    invocation.input = std::make_shared<CommandStream>();
+    std::thread stdin_pump([fd, input = invocation.input]() {
+        char frame_type = 0;
+        std::string data;
+        while (proto::recv_frame(fd, frame_type, data) && frame_type == proto::FRAME_STDIN) {
+            if (!input->write(data)) {
+                break;  // command stopped reading
+            }
+        }
+        input->close_write();
+    });
+
+    int exit_code = 1;
+    {
+        OutputSink sink([fd](const char* data, size_t size) {
+            return proto::send_frame(fd, proto::FRAME_OUTPUT, data, size);
+        }, OutputSink::DEFAULT_CHUNK_SIZE, true);
+
+        if (!command.empty()) {
+            logging::Logger::instance().audit_command(command, true);
+            auto user = invocation.environment.find("USER");
+            HistoryJournal::instance().append(command, user != invocation.environment.end() ? user->second : "",
+                                              "daemon");
+            CommandResult result = processor.process(command, sink, invocation);
+            sink.write(result.output);
+            exit_code = result.exit_code;
+        }
+        sink.flush();
+    }
+    proto::send_frame(fd, proto::FRAME_EXIT, proto::encode_exit_code(exit_code));
+
+    // Unblock the pump whether it waits on the client or on the stream
+    invocation.input->close_read();
+    ::shutdown(fd, SHUT_RDWR);
+    stdin_pump.join();
+}
+
+DaemonServer::DaemonServer(CommandProcessor& processor)
+    : pimpl_(std::make_unique<Impl>(processor)) {
+}
+
+DaemonServer::~DaemonServer() {
+    stop();
+
+    // Drop clients still connected and wait for their handlers
+    std::unique_lock<std::mutex> lock(pimpl_->mutex);
+    for (int fd : pimpl_->client_fds) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+    pimpl_->idle_cv.wait(lock, [this] { return pimpl_->client_fds.empty(); });
+    lock.unlock();
+
+    if (pimpl_->listen_fd >= 0) {
+        ::close(pimpl_->listen_fd);
+        ::unlink(pimpl_->socket_path.c_str());
+    }
+}
+
+bool DaemonServer::start(const std::string& socket_path, std::string& error) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.empty() || socket_path.size() >= sizeof(addr.sun_path)) {
+        error = "Invalid socket path: " + socket_path;
+        return false;
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = proto::open_socket();
+    if (fd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    // A socket file nobody answers on is left over from a crashed daemon
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        ::close(fd);
+        error = "A daemon is already listening on " + socket_path;
+        return false;
+    }
+    ::close(fd);
+    ::unlink(socket_path.c_str());
+
+    fd = proto::open_socket();
+    if (fd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    // Create the socket owner-only; the peer uid check below is the real guard
+    mode_t old_mask = ::umask(0077);
+    int rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::umask(old_mask);
+    if (rc != 0 || ::listen(fd, 64) != 0) {
+        error = "Cannot listen on " + socket_path + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    pimpl_->socket_path = socket_path;
+    pimpl_->listen_fd = fd;
+    LOG_INFO("Daemon listening on {}", socket_path);
+    return true;
+}
+
+void DaemonServer::run() {
+    while (!pimpl_->stopping.load()) {
+        int client = proto::accept_client(pimpl_->listen_fd);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;  // listening socket shut down by stop()
+        }
+
+        if (!proto::peer_is_same_user(client)) {
+            LOG_WARNING("Daemon rejected a client running as another user");
+            ::close(client);
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pimpl_->mutex);
+            pimpl_->client_fds.insert(client);
+        }
+
+        // One thread per connection: commands may block on client stdin,
+        // which must not stall other clients
+        std::thread([impl = pimpl_.get(), client]() {
+            try {
+                impl->serve(client);
+            }
+            catch (...) {
+                // A failing request must not take the daemon down
+            }
+
+            std::lock_guard<std::mutex> lock(impl->mutex);
+            ::close(client);
+            impl->client_fds.erase(client);
+            impl->idle_cv.notify_all();
+        }).detach();
+    }
+}
+
+void DaemonServer::stop() {
+    pimpl_->stopping.store(true);
+    if (pimpl_->listen_fd >= 0) {
+        ::shutdown(pimpl_->listen_fd, SHUT_RDWR);
+    }
+}
+
+#else // _WIN32
+
+struct DaemonServer::Impl {
+    explicit Impl(CommandProcessor&) {}
+};
+
+DaemonServer::DaemonServer(CommandProcessor& processor)
+    : pimpl_(std::make_unique<Impl>(processor)) {
+}
+
+DaemonServer::~DaemonServer() = default;
+
+bool DaemonServer::start(const std::string&, std::string& error) {
+    error = "Daemon mode is not supported on Windows";
+    return false;
+}
+
+void DaemonServer::run() {
+}
+
+void DaemonServer::stop() {
+}
+
+#endif // _WIN32
+
+} // namespace core
+} // namespace customos
@@ -0,0 +1,329 @@
+#include "core/directory_cache.h"
+#include "core/fuzzy_matcher.h"
+#include "core/job_control.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <numeric>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace customos {
+namespace core {
+
+namespace {
+
+inline unsigned char fold(char c) {
+    return static_cast<unsigned char>(::tolower(static_cast<unsigned char>(c)));
+}
+
+// Case-insensitive order, exact order between names that fold equal
+bool listing_less(const std::string& a, const std::string& b) {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; ++i) {
+        if (fold(a[i]) != fold(b[i])) {
+            return fold(a[i]) < fold(b[i]);
+        }
+    }
+    if (a.size() != b.size()) {
+        return a.size() < b.size();
+    }
+    return a < b;
+}
+
+// Compares only the first `prefix.size()` bytes of `name`, ignoring case:
+// <0, 0 or >0 as the name's head sorts before, equal to or after the prefix
+int compare_head(const std::string& name, const std::string& prefix) {
+    size_t n = std::min(name.size(), prefix.size());
+    for (size_t i = 0; i < n; ++i) {
+        if (fold(name[i]) != fold(prefix[i])) {
+            return fold(name[i]) < fold(prefix[i]) ? -1 : 1;
+        }
+    }
+    return name.size() < prefix.size() ? -1 : 0;
+}
+
+#ifdef __linux__
+// Remote and FUSE file systems do not report other hosts' changes through
+// inotify, so listings there are revalidated by modification time instead
+bool events_reliable(const std::string& path) {
+    struct statfs info;
+    if (statfs(path.c_str(), &info) != 0) {
+        return false;
+    }
+    switch (static_cast<unsigned long>(info.f_type)) {
+        case 0x6969UL:      // NFS
+        case 0x517BUL:      // SMB
+        case 0xFF534D42UL:  // CIFS
+        case 0xFE534D42UL:  // SMB2
+        case 0x65735546UL:  // FUSE
+            return false;
+        default:
+            return true;
+    }
+}
+#endif
+
+} // anonymous namespace
+
+std::pair<size_t, size_t> DirectoryListing::prefix_range(const std::string& prefix) const {
+    auto first = std::partition_point(names.begin(), names.end(),
+                                      [&prefix](const std::string& name) { return compare_head(name, prefix) < 0; });
+    auto last = std::partition_point(first, names.end(),
+                                     [&prefix](const std::string& name) { return compare_head(name, prefix) == 0; });
+    return {static_cast<size_t>(first - names.begin()), static_cast<size_t>(last - names.begin())};
+}
+
+DirectoryCache& DirectoryCache::instance() {
+    static DirectoryCache cache;
+    return cache;
+}
+
+DirectoryCache::DirectoryCache()
+    : clock_(0)
+    , inotify_fd_(-1) {
+#ifdef __linux__
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+DirectoryCache::~DirectoryCache() {
+#ifdef __linux__
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+    }
+#endif
+}
+
+std::shared_ptr<const DirectoryListing> DirectoryCache::get(const std::string& path) {
+    std::string key = absolute(path);
+    uint64_t epoch = 0;
+    bool revalidate = false;
+    int64_t known_modified = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drain_events();
+        Slot& slot = slots_[key];
+        slot.last_used = ++clock_;
+        if (slot.listing) {
+            if (slot.watch >= 0 || std::chrono::steady_clock::now() - slot.checked < REVALIDATE_INTERVAL) {
+                return slot.listing;
+            }
+            revalidate = true;
+            known_modified = slot.modified;
+        }
+#ifdef __linux__
+        // Watch before reading so a change made during the read is not lost
+        if (slot.watch < 0 && inotify_fd_ >= 0 && events_reliable(key)) {
+            int watch = inotify_add_watch(inotify_fd_, key.c_str(),
+                                          IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                          IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+            if (watch >= 0) {
+                slot.watch = watch;
+                watched_[watch] = key;
+                revalidate = false;
+                slot.listing.reset();
+            }
+        }
+#endif
+        epoch = slot.epoch;
+        evict();
+    }
+
+    int64_t modified = modified_time(key);
+    std::shared_ptr<const DirectoryListing> listing;
+    if (revalidate && modified == known_modified) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = slots_.find(key);
+        if (it != slots_.end() && it->second.listing) {
+            it->second.checked = std::chrono::steady_clock::now();
+            return it->second.listing;
+        }
+    }
+
+    listing = read_listing(key);
+    std::lock_guard<std::mutex> lock(mutex_);
+    drain_events();
+    auto it = slots_.find(key);
+    // A listing raced by a change (or an eviction) is returned but not kept
+    if (listing && it != slots_.end() && it->second.epoch == epoch) {
+        it->second.listing = listing;
+        it->second.modified = modified;
+        it->second.checked = std::chrono::steady_clock::now();
+    }
+    return listing;
+}
+
+void DirectoryCache::prefetch(const std::string& path) {
+    std::string key = absolute(path);
+    WorkerPool::instance().submit([this, key] { get(key); });
+}
+
+std::string DirectoryCache::current_directory() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cwd_.empty()) {
+        std::error_code ec;
+        cwd_ = fs::current_path(ec).string();
+    }
+    return cwd_;
+}
+
+bool DirectoryCache::change_directory(const std::string& path) {
+    std::string target = path;
+    if (target.empty() || target == "~") {
+        const char* home = std::getenv("HOME");
+        if (!home) {
+            home = std::getenv("USERPROFILE");
+        }
+        if (!home) {
+            return false;
+        }
+        target = home;
+    }
+
+    std::error_code ec;
+    fs::current_path(absolute(target), ec);
+    if (ec) {
+        return false;
+    }
+    std::string cwd = fs::current_path(ec).string();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cwd_ = cwd;
+    }
+    prefetch(cwd);
+    return true;
+}
+
+void DirectoryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+#ifdef __linux__
+    for (const auto& item : watched_) {
+        inotify_rm_watch(inotify_fd_, item.first);
+    }
+#endif
+    watched_.clear();
+    slots_.clear();
+}
+
+std::string DirectoryCache::absolute(const std::string& path) {
+    fs::path p(path.empty() ? "." : path);
+    if (p.is_relative()) {
+        p = fs::path(current_directory()) / p;
+    }
+    std::string normal = p.lexically_normal().string();
+    while (normal.size() > 1 && (normal.back() == '/' || normal.back() == '\\')) {
+        normal.pop_back();
+    }
+    return normal;
+}
+
+std::shared_ptr<const DirectoryListing> DirectoryCache::read_listing(const std::string& path) {
+    std::error_code ec;
+    fs::directory_iterator it(path, ec);
+    if (ec) {
+        return nullptr;
+    }
+
+    std::vector<std::string> names;
+    std::vector<bool> dirs;
+    for (; it != fs::directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        std::error_code type_ec;
+        names.push_back(it->path().filename().string());
+        dirs.push_back(it->is_directory(type_ec));
+    }
+
+    std::vector<size_t> order(names.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::sort(order.begin(), order.end(), [&names](size_t a, size_t b) { return listing_less(names[a], names[b]); });
+
+    auto listing = std::make_shared<DirectoryListing>();
+    listing->names.reserve(names.size());
+    listing->is_directory.reserve(names.size());
+    listing->masks.reserve(names.size());
+    for (size_t i : order) {
+        listing->masks.push_back(FuzzyMatcher::char_mask(names[i]));
+        listing->is_directory.push_back(dirs[i]);
+        listing->names.push_back(std::move(names[i]));
+    }
+    return listing;
+}
+
+int64_t DirectoryCache::modified_time(const std::string& path) {
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+void DirectoryCache::drain_events() {
+#ifdef __linux__
+    if (inotify_fd_ < 0) {
+        return;
+    }
+    alignas(struct inotify_event) char buffer[4096];
+    for (;;) {
+        ssize_t length = ::read(inotify_fd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;  // EAGAIN: nothing pending
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were lost; nothing cached can be trusted
+                for (auto& item : slots_) {
+                    item.second.listing.reset();
+                    ++item.second.epoch;
+                }
+                continue;
+            }
+            auto watched = watched_.find(event->wd);
+            if (watched == watched_.end()) {
+                continue;
+            }
+            auto slot = slots_.find(watched->second);
+            if (slot != slots_.end()) {
+                slot->second.listing.reset();
+                ++slot->second.epoch;
+                if (event->mask & IN_IGNORED) {
+                    slot->second.watch = -1;  // the directory is gone
+                }
+            }
+            if (event->mask & IN_IGNORED) {
+                watched_.erase(watched);
+            }
+        }
+    }
+#endif
+}
+
+void DirectoryCache::evict() {
+    while (slots_.size() > MAX_DIRECTORIES) {
+        auto oldest = slots_.begin();
+        for (auto it = slots_.begin(); it != slots_.end(); ++it) {
+            if (it->second.last_used < oldest->second.last_used) {
+                oldest = it;
+            }
+        }
+#ifdef __linux__
+        if (oldest->second.watch >= 0) {
+            inotify_rm_watch(inotify_fd_, oldest->second.watch);
+            watched_.erase(oldest->second.watch);
+        }
+#endif
+        slots_.erase(oldest);
+    }
+}
+
+} // namespace core
+} // namespace customos
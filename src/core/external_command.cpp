@@ -0,0 +1,481 @@
+#include "core/external_command.h"
+#include "core/command_metrics.h"
+#include "core/output_sink.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace customos {
+namespace core {
+
+#ifndef _WIN32
+
+namespace {
+
+int64_t modification_time(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return -1;
+    }
+#ifdef __APPLE__
+    return static_cast<int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+}
+
+bool is_executable(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && access(path.c_str(), X_OK) == 0;
+}
+
+std::vector<std::string> split_path(const std::string& path_env) {
+    std::vector<std::string> directories;
+    size_t start = 0;
+    while (start <= path_env.size()) {
+        size_t end = path_env.find(':', start);
+        if (end == std::string::npos) {
+            end = path_env.size();
+        }
+        // Empty entries mean the current directory; never search it implicitly
+        if (end > start) {
+            directories.push_back(path_env.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return directories;
+}
+
+bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Writes to a pipe whose reader has exited must fail with EPIPE rather
+// than kill the shell; children get the default action back at spawn
+void ignore_sigpipe() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        struct sigaction current;
+        if (sigaction(SIGPIPE, nullptr, &current) == 0 && current.sa_handler == SIG_DFL) {
+            std::signal(SIGPIPE, SIG_IGN);
+        }
+    });
+}
+
+// ForegroundSignals state: how many scopes are open and what they replaced
+std::mutex foreground_mutex;
+int foreground_depth = 0;
+struct sigaction saved_int;
+struct sigaction saved_quit;
+
+// Both ends close-on-exec, so concurrently spawned programs never inherit
+// another command's pipe
+bool open_pipe(int fds[2]) {
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+
+uint64_t timeval_us(const timeval& tv) {
+    return static_cast<uint64_t>(tv.tv_sec) * 1000000 + static_cast<uint64_t>(tv.tv_usec);
+}
+
+} // anonymous namespace
+
+#endif // !_WIN32
+
+// ForegroundSignals
+
+ForegroundSignals::ForegroundSignals() {
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(foreground_mutex);
+    if (foreground_depth++ == 0) {
+        struct sigaction ignore;
+        std::memset(&ignore, 0, sizeof(ignore));
+        ignore.sa_handler = SIG_IGN;
+        sigaction(SIGINT, &ignore, &saved_int);
+        sigaction(SIGQUIT, &ignore, &saved_quit);
+    }
+#endif
+}
+
+ForegroundSignals::~ForegroundSignals() {
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(foreground_mutex);
+    if (--foreground_depth == 0) {
+        sigaction(SIGINT, &saved_int, nullptr);
+        sigaction(SIGQUIT, &saved_quit, nullptr);
+    }
+#endif
+}
+
+// PathCache
+
+PathCache& PathCache::instance() {
+    static PathCache cache;
+    return cache;
+}
+
+std::string PathCache::resolve(const std::string& name, const std::string& path_env) {
+#ifdef _WIN32
+    (void)name;
+    (void)path_env;
+    return "";  // external programs are not supported on Windows yet
+#else
+    if (name.empty()) {
+        return "";
+    }
+    if (name.find('/') != std::string::npos) {
+        return is_executable(name) ? name : "";
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_stale(path_env)) {
+        rebuild(path_env);
+    }
+
+    auto it = table_.find(name);
+    if (it == table_.end()) {
+        return "";
+    }
+    if (is_executable(it->second)) {
+        return it->second;
+    }
+
+    // The first match is not runnable (no x bit, or a directory); a later
+    // PATH entry may still provide the program
+    for (const auto& directory : directories_) {
+        std::string candidate = directory.path + "/" + name;
+        if (candidate != it->second && is_executable(candidate)) {
+            return candidate;
+        }
+    }
+    return "";
+#endif
+}
+
+void PathCache::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    valid_ = false;
+    table_.clear();
+}
+
+size_t PathCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return table_.size();
+}
+
+bool PathCache::is_stale(const std::string& path_env) const {
+#ifdef _WIN32
+    (void)path_env;
+    return true;
+#else
+    if (!valid_ || path_env != path_env_) {
+        return true;
+    }
+    // Adding or removing a program changes its directory's mtime
+    for (const auto& directory : directories_) {
+        if (modification_time(directory.path) != directory.mtime_ns) {
+            return true;
+        }
+    }
+    return false;
+#endif
+}
+
+void PathCache::rebuild(const std::string& path_env) {
+#ifdef _WIN32
+    (void)path_env;
+#else
+    table_.clear();
+    directories_.clear();
+
+    for (const auto& path : split_path(path_env)) {
+        // Record the mtime before listing so a change made during the scan
+        // is caught by the next lookup
+        directories_.push_back({path, modification_time(path)});
+
+        DIR* dir = opendir(path.c_str());
+        if (!dir) {
+            continue;
+        }
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.' &&
+                (entry->d_name[1] == '\0' || (entry->d_name[1] == '.' && entry->d_name[2] == '\0'))) {
+                continue;
+            }
+#ifdef DT_DIR
+            if (entry->d_type == DT_DIR) {
+                continue;
+            }
+#endif
+            // Executability is checked at lookup, for the one entry asked for
+            table_.emplace(entry->d_name, path + "/" + entry->d_name);
+        }
+        closedir(dir);
+    }
+
+    path_env_ = path_env;
+    valid_ = true;
+#endif
+}
+
+// ExternalCommand
+
+int ExternalCommand::run(const std::string& path, const std::vector<std::string>& argv,
+                         const CommandContext& context, const std::string& working_directory, bool interactive) {
+#ifdef _WIN32
+    (void)path;
+    (void)argv;
+    (void)context;
+    (void)working_directory;
+    (void)interactive;
+    std::cout << "External programs are not supported on this platform\n";
+    return 127;
+#else
+    ignore_sigpipe();
+    auto start = std::chrono::steady_clock::now();
+
+    OutputSink* sink = context.sink;
+    int native_out = sink ? sink->native_fd() : STDOUT_FILENO;
+    bool feed_input = static_cast<bool>(context.input);
+    bool background = !feed_input && context.cancel_flag;
+    bool on_terminal = interactive && !feed_input && !background;  // has the shell's stdin
+
+    int in_pipe[2] = {-1, -1};
+    int out_pipe[2] = {-1, -1};
+    if ((feed_input && !open_pipe(in_pipe)) || (native_out < 0 && !open_pipe(out_pipe))) {
+        std::cout << argv[0] << ": " << std::strerror(errno) << "\n";
+        for (int fd : {in_pipe[0], in_pipe[1]}) {
+            if (fd >= 0) close(fd);
+        }
+        return 126;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (feed_input) {
+        posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO);
+    }
+    else if (!on_terminal) {
+        // Background jobs must not compete with the prompt for the terminal,
+        // and remote callers never get it
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    }
+    if (native_out >= 0) {
+        // Everything the command printed so far must land before the child's output
+        if (sink) {
+            sink->flush();
+        }
+        std::fflush(stdout);
+        if (native_out != STDOUT_FILENO) {
+            posix_spawn_file_actions_adddup2(&actions, native_out, STDOUT_FILENO);
+        }
+    }
+    else {
+        posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO);
+    }
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+    if (!working_directory.empty()) {
+        posix_spawn_file_actions_addchdir_np(&actions, working_directory.c_str());
+    }
+#else
+    (void)working_directory;
+#endif
+
+    // Signals the shell ignores or handles go back to their defaults
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    for (int sig : {SIGPIPE, SIGINT, SIGQUIT, SIGTERM}) {
+        sigaddset(&defaults, sig);
+    }
+    sigset_t no_mask;
+    sigemptyset(&no_mask);
+    posix_spawnattr_setsigdefault(&attributes, &defaults);
+    posix_spawnattr_setsigmask(&attributes, &no_mask);
+    short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+    if (context.cancel_flag) {
+        // Inside a job the program leads its own process group, so killing
+        // the job also reaches whatever the program started
+        posix_spawnattr_setpgroup(&attributes, 0);
+        flags |= POSIX_SPAWN_SETPGROUP;
+    }
+    posix_spawnattr_setflags(&attributes, flags);
+
+    std::vector<char*> args;
+    args.reserve(argv.size() + 1);
+    for (const auto& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+
+    // Daemon clients bring their own environment
+    std::vector<std::string> env_storage;
+    std::vector<char*> env;
+    char** envp = environ;
+    if (!context.environment.empty()) {
+        env_storage.reserve(context.environment.size());
+        for (const auto& pair : context.environment) {
+            env_storage.push_back(pair.first + "=" + pair.second);
+        }
+        for (auto& entry : env_storage) {
+            env.push_back(&entry[0]);
+        }
+        env.push_back(nullptr);
+        envp = env.data();
+    }
+
+    std::unique_ptr<ForegroundSignals> foreground;
+    if (on_terminal) {
+        foreground = std::make_unique<ForegroundSignals>();
+    }
+
+    // glibc and the BSDs implement this with vfork/CLONE_VFORK semantics:
+    // no copy of the shell's address space is made
+    pid_t pid = -1;
+    int spawn_error = posix_spawn(&pid, path.c_str(), &actions, &attributes, args.data(), envp);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attributes);
+
+    if (in_pipe[0] >= 0) close(in_pipe[0]);
+    if (out_pipe[1] >= 0) close(out_pipe[1]);
+
+    if (spawn_error != 0) {
+        if (in_pipe[1] >= 0) close(in_pipe[1]);
+        if (out_pipe[0] >= 0) close(out_pipe[0]);
+        std::cout << argv[0] << ": " << std::strerror(spawn_error) << "\n";
+        return spawn_error == ENOENT ? 127 : 126;
+    }
+
+    std::thread feeder;
+    if (feed_input) {
+        feeder = std::thread([fd = in_pipe[1], input = context.input]() {
+            char buffer[16 * 1024];
+            size_t count;
+            while ((count = input->read(buffer, sizeof(buffer))) > 0) {
+                if (!write_all(fd, buffer, count)) break;
+            }
+            close(fd);
+        });
+    }
+
+    // SIGTERM first; SIGKILL if the program is still there KILL_GRACE_MS later
+    int sent = 0;
+    std::chrono::steady_clock::time_point term_sent;
+    auto check_cancel = [&]() {
+        if (sent == SIGKILL || !context.cancelled()) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (sent == 0) {
+            sent = SIGTERM;
+            term_sent = now;
+        }
+        else if (now - term_sent >= std::chrono::milliseconds(KILL_GRACE_MS)) {
+            sent = SIGKILL;
+        }
+        else {
+            return;
+        }
+        kill(-pid, sent);
+    };
+
+    // Pump the child's stdout into the sink until it closes
+    if (out_pipe[0] >= 0) {
+        char buffer[64 * 1024];
+        int timeout_ms = context.cancel_flag ? 100 : -1;
+        while (true) {
+            pollfd pfd{out_pipe[0], POLLIN, 0};
+            int ready = poll(&pfd, 1, timeout_ms);
+            if (ready < 0 && errno != EINTR) break;
+            check_cancel();
+            if (ready <= 0) continue;
+
+            ssize_t n = read(out_pipe[0], buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+
+            sink->write(buffer, static_cast<size_t>(n));
+            // Stream to the next stage as output arrives; stop reading once it
+            // has gone away so the child sees EPIPE like in a real pipe
+            if (!sink->flush() || (context.output && context.output->is_reader_closed())) {
+                break;
+            }
+        }
+        close(out_pipe[0]);
+    }
+
+    int status = 0;
+    rusage usage;
+    std::memset(&usage, 0, sizeof(usage));
+    if (context.cancel_flag) {
+        pid_t done;
+        while ((done = wait4(pid, &status, WNOHANG, &usage)) == 0) {
+            check_cancel();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+    else {
+        while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+        }
+    }
+    foreground.reset();
+
+    // Unblock the feeder if the program exited without reading all its input
+    if (feeder.joinable()) {
+        context.input->close_read();
+        feeder.join();
+    }
+
+    int exit_code = WIFEXITED(status) ? WEXITSTATUS(status)
+                  : WIFSIGNALED(status) ? 128 + WTERMSIG(status)
+                  : 1;
+
+    // The registry times built-ins; programs are timed here with the
+    // child's own CPU usage
+    uint64_t wall_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    CommandMetrics::record(argv[0], wall_us, timeval_us(usage.ru_utime) + timeval_us(usage.ru_stime),
+                           exit_code == 0);
+    return exit_code;
+#endif
+}
+
+} // namespace core
+} // namespace customos
@@ -0,0 +1,319 @@
+#include "core/fuzzy_matcher.h"
+#include <algorithm>
+#include <array>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CUSTOMOS_FUZZY_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace customos {
+namespace core {
+
+namespace {
+
+enum CharClass { BOUNDARY, LOWER, UPPER, DIGIT, OTHER };
+
+// Letters fold onto bits 0-25, digits take 26-35 and every other byte
+// shares the remaining 28 bits
+const std::array<uint64_t, 256> MASK_BITS = [] {
+    std::array<uint64_t, 256> bits{};
+    for (int c = 0; c < 256; ++c) {
+        int bit;
+        if (c >= 'a' && c <= 'z') bit = c - 'a';
+        else if (c >= 'A' && c <= 'Z') bit = c - 'A';
+        else if (c >= '0' && c <= '9') bit = 26 + (c - '0');
+        else bit = 36 + c % 28;
+        bits[c] = uint64_t{1} << bit;
+    }
+    return bits;
+}();
+
+inline char other_case(char c) {
+    if (c >= 'a' && c <= 'z') return static_cast<char>(c - 'a' + 'A');
+    if (c >= 'A' && c <= 'Z') return static_cast<char>(c - 'A' + 'a');
+    return c;
+}
+
+inline char fold(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline CharClass class_of(char c) {
+    if (c >= 'a' && c <= 'z') return LOWER;
+    if (c >= 'A' && c <= 'Z') return UPPER;
+    if (c >= '0' && c <= '9') return DIGIT;
+    if (c == '/' || c == '-' || c == '_' || c == '.' || c == ' ' || c == '\t' || c == '\\' || c == ':') {
+        return BOUNDARY;
+    }
+    return OTHER;
+}
+
+inline int bonus_for(CharClass previous, CharClass current) {
+    if (current == BOUNDARY) {
+        return 0;
+    }
+    if (previous == BOUNDARY) {
+        return FuzzyMatcher::BONUS_BOUNDARY;
+    }
+    if ((previous == LOWER && current == UPPER) || (previous != DIGIT && current == DIGIT)) {
+        return FuzzyMatcher::BONUS_CAMEL;
+    }
+    return 0;
+}
+
+#ifdef CUSTOMOS_FUZZY_SSE2
+inline unsigned lowest_bit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+#endif
+
+// Column-by-column edit distance table; used when the pattern does not
+// fit a 64-bit word. Returns the last row's final value, or its minimum.
+size_t table_distance(std::string_view pattern, std::string_view text, bool best_prefix) {
+    std::vector<size_t> column(pattern.size() + 1);
+    for (size_t i = 0; i < column.size(); ++i) {
+        column[i] = i;
+    }
+    size_t best = column.back();
+    for (size_t j = 0; j < text.size(); ++j) {
+        size_t diagonal = column[0];
+        column[0] = j + 1;
+        for (size_t i = 1; i < column.size(); ++i) {
+            size_t above = column[i];
+            column[i] = std::min({above + 1, column[i - 1] + 1, diagonal + (pattern[i - 1] == text[j] ? 0 : 1)});
+            diagonal = above;
+        }
+        best = std::min(best, column.back());
+    }
+    return best_prefix ? best : column.back();
+}
+
+// Myers / Hyyrö bit-vector edit distance; pattern length 1..64
+size_t myers_distance(std::string_view pattern, std::string_view text, bool best_prefix) {
+    std::array<uint64_t, 256> peq{};
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        peq[static_cast<unsigned char>(pattern[i])] |= uint64_t{1} << i;
+    }
+
+    size_t m = pattern.size();
+    uint64_t high = uint64_t{1} << (m - 1);
+    uint64_t pv = m == 64 ? ~uint64_t{0} : (uint64_t{1} << m) - 1;
+    uint64_t mv = 0;
+    size_t score = m;
+    size_t best = m;
+
+    for (char c : text) {
+        uint64_t eq = peq[static_cast<unsigned char>(c)];
+        uint64_t xv = eq | mv;
+        uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t ph = mv | ~(xh | pv);
+        uint64_t mh = pv & xh;
+        if (ph & high) {
+            ++score;
+        }
+        else if (mh & high) {
+            --score;
+        }
+        // Row 0 grows by one per text character
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+        best = std::min(best, score);
+    }
+    return best_prefix ? best : score;
+}
+
+} // anonymous namespace
+
+FuzzyMatcher::FuzzyMatcher(const std::string& pattern, bool case_sensitive)
+    : pattern_mask_(char_mask(pattern))
+    , case_sensitive_(case_sensitive) {
+    pattern_.reserve(pattern.size());
+    pattern_upper_.reserve(pattern.size());
+    for (char c : pattern) {
+        char folded = case_sensitive ? c : fold(c);
+        pattern_ += folded;
+        pattern_upper_ += case_sensitive ? c : other_case(folded);
+    }
+}
+
+uint64_t FuzzyMatcher::char_mask(std::string_view text) {
+    uint64_t mask = 0;
+    for (char c : text) {
+        mask |= MASK_BITS[static_cast<unsigned char>(c)];
+    }
+    return mask;
+}
+
+size_t FuzzyMatcher::find_from(std::string_view text, size_t from, size_t pattern_index) const {
+    char a = pattern_[pattern_index];
+    char b = pattern_upper_[pattern_index];
+    size_t p = from;
+#ifdef CUSTOMOS_FUZZY_SSE2
+    __m128i va = _mm_set1_epi8(a);
+    __m128i vb = _mm_set1_epi8(b);
+    for (; p + 16 <= text.size(); p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + p));
+        unsigned hits = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb))));
+        if (hits) {
+            return p + lowest_bit(hits);
+        }
+    }
+#endif
+    for (; p < text.size(); ++p) {
+        if (text[p] == a || text[p] == b) {
+            return p;
+        }
+    }
+    return std::string_view::npos;
+}
+
+int FuzzyMatcher::score(std::string_view text, std::vector<size_t>* positions) const {
+    if (pattern_.empty()) {
+        return 0;
+    }
+
+    // Leftmost in-order match gives the end of the window...
+    size_t end = 0;
+    for (size_t i = 0; i < pattern_.size(); ++i) {
+        size_t p = find_from(text, end, i);
+        if (p == std::string_view::npos) {
+            return -1;
+        }
+        end = p + 1;
+    }
+
+    // ...and matching backwards from there gives the tightest start
+    size_t start = end;
+    size_t remaining = pattern_.size();
+    while (remaining > 0) {
+        --start;
+        char c = text[start];
+        if (c == pattern_[remaining - 1] || c == pattern_upper_[remaining - 1]) {
+            --remaining;
+        }
+    }
+
+    if (positions) {
+        positions->clear();
+    }
+    int total = 0;
+    int first_bonus = 0;
+    size_t consecutive = 0;
+    size_t matched = 0;
+    bool in_gap = false;
+    CharClass previous = start > 0 ? class_of(text[start - 1]) : BOUNDARY;
+    for (size_t i = start; i < end; ++i) {
+        char c = text[i];
+        CharClass current = class_of(c);
+        if (matched < pattern_.size() && (c == pattern_[matched] || c == pattern_upper_[matched])) {
+            int bonus = bonus_for(previous, current);
+            if (consecutive == 0) {
+                first_bonus = bonus;
+            }
+            else {
+                // A run keeps the bonus of its first character
+                if (bonus >= BONUS_BOUNDARY && bonus > first_bonus) {
+                    first_bonus = bonus;
+                }
+                bonus = std::max({bonus, first_bonus, BONUS_CONSECUTIVE});
+            }
+            total += SCORE_MATCH + (matched == 0 ? bonus * FIRST_CHAR_MULTIPLIER : bonus);
+            if (positions) {
+                positions->push_back(i);
+            }
+            ++matched;
+            ++consecutive;
+            in_gap = false;
+        }
+        else {
+            total += in_gap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+            in_gap = true;
+            consecutive = 0;
+            first_bonus = 0;
+        }
+        previous = current;
+    }
+    return std::max(total, 0);
+}
+
+std::vector<FuzzyMatcher::Ranked> FuzzyMatcher::rank(const std::vector<std::string>& candidates, size_t limit) const {
+    std::vector<uint64_t> masks;
+    masks.reserve(candidates.size());
+    for (const auto& candidate : candidates) {
+        masks.push_back(char_mask(candidate));
+    }
+    return rank(candidates, masks, limit);
+}
+
+std::vector<FuzzyMatcher::Ranked> FuzzyMatcher::rank(const std::vector<std::string>& candidates,
+                                                     const std::vector<uint64_t>& masks, size_t limit) const {
+    std::vector<Ranked> ranked;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (rejects(masks[i])) {
+            continue;
+        }
+        int s = score(candidates[i]);
+        if (s >= 0) {
+            ranked.push_back({i, s});
+        }
+    }
+
+    auto better = [&candidates](const Ranked& a, const Ranked& b) {
+        if (a.score != b.score) return a.score > b.score;
+        if (candidates[a.index].size() != candidates[b.index].size()) {
+            return candidates[a.index].size() < candidates[b.index].size();
+        }
+        return a.index < b.index;
+    };
+    if (ranked.size() > limit) {
+        std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(limit), ranked.end(), better);
+        ranked.resize(limit);
+    }
+    else {
+        std::sort(ranked.begin(), ranked.end(), better);
+    }
+    return ranked;
+}
+
+int FuzzyMatcher::max_score() const {
+    if (pattern_.empty()) {
+        return 0;
+    }
+    int n = static_cast<int>(pattern_.size());
+    return n * SCORE_MATCH + BONUS_BOUNDARY * FIRST_CHAR_MULTIPLIER + (n - 1) * BONUS_BOUNDARY;
+}
+
+size_t FuzzyMatcher::levenshtein(std::string_view a, std::string_view b) {
+    // Distance is symmetric; the shorter string is the bit-vector pattern
+    if (a.size() > b.size()) {
+        std::swap(a, b);
+    }
+    if (a.empty()) {
+        return b.size();
+    }
+    return a.size() <= 64 ? myers_distance(a, b, false) : table_distance(a, b, false);
+}
+
+size_t FuzzyMatcher::prefix_distance(std::string_view pattern, std::string_view text) {
+    if (pattern.empty()) {
+        return 0;
+    }
+    return pattern.size() <= 64 ? myers_distance(pattern, text, true) : table_distance(pattern, text, true);
+}
+
+} // namespace core
+} // namespace customos
@@ -0,0 +1,263 @@
+#include "core/history_journal.h"
+#include "core/job_control.h"
+#include "database/internal_db.h"
+#include <algorithm>
+#include <ctime>
+#include <unordered_set>
+
+namespace customos {
+namespace core {
+
+namespace {
+
+int64_t steady_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+HistoryJournal& HistoryJournal::instance() {
+    static HistoryJournal journal;
+    return journal;
+}
+
+HistoryJournal::HistoryJournal()
+    : lanes_(nullptr)
+    , next_sequence_(1)
+    , last_drain_ms_(steady_ms())
+    , drain_scheduled_(false)
+    , retrying_(false) {
+}
+
+HistoryJournal::~HistoryJournal() {
+    // Lanes are left for the process to reclaim: thread-local owners on
+    // other threads may still release theirs during shutdown
+}
+
+void HistoryJournal::append(const std::string& command, const std::string& user, const std::string& origin) {
+    if (command.empty()) {
+        return;
+    }
+
+    // Hands the lane back when the thread exits
+    struct LaneOwner {
+        Lane* lane = nullptr;
+        ~LaneOwner() {
+            if (lane) {
+                lane->owned.store(false, std::memory_order_release);
+            }
+        }
+    };
+    thread_local LaneOwner owner;
+    if (!owner.lane) {
+        owner.lane = acquire_lane();
+    }
+    Lane* lane = owner.lane;
+
+    uint64_t index = lane->published.load(std::memory_order_relaxed);
+    if (!lane->tail || index == lane->tail->base + SEGMENT_SIZE) {
+        auto segment = std::make_shared<Segment>();
+        segment->base = index;
+        if (lane->tail) {
+            std::atomic_store(&lane->tail->next, segment);
+        }
+        else {
+            std::atomic_store(&lane->head, segment);
+        }
+        lane->tail = segment.get();
+    }
+
+    JournalEntry& entry = lane->tail->entries[index - lane->tail->base];
+    entry.sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed);
+    entry.timestamp = static_cast<int64_t>(std::time(nullptr));
+    entry.command = command;
+    entry.user = user;
+    entry.origin = origin;
+    lane->published.store(index + 1, std::memory_order_release);
+
+    trim(lane);
+    maybe_schedule_drain(lane);
+}
+
+std::vector<JournalEntry> HistoryJournal::merged(size_t count, bool unique) const {
+    std::vector<JournalEntry> entries;
+    for (const Lane* lane = lanes_.load(std::memory_order_acquire); lane; lane = lane->next) {
+        uint64_t to = lane->published.load(std::memory_order_acquire);
+        // Without dedup no lane can contribute more than `count`
+        uint64_t from = (!unique && to > count) ? to - count : 0;
+        visit_range(lane, from, to, [&entries](const JournalEntry& entry) { entries.push_back(entry); });
+    }
+
+    // Lanes are each in sequence order; the merged view is too
+    std::sort(entries.begin(), entries.end(),
+              [](const JournalEntry& a, const JournalEntry& b) { return a.sequence < b.sequence; });
+
+    if (unique) {
+        // Keep the latest run of each command
+        std::unordered_set<std::string> seen;
+        std::vector<JournalEntry> latest;
+        for (auto it = entries.rbegin(); it != entries.rend() && latest.size() < count; ++it) {
+            if (seen.insert(it->command).second) {
+                latest.push_back(std::move(*it));
+            }
+        }
+        std::reverse(latest.begin(), latest.end());
+        return latest;
+    }
+
+    if (entries.size() > count) {
+        entries.erase(entries.begin(), entries.end() - static_cast<std::ptrdiff_t>(count));
+    }
+    return entries;
+}
+
+void HistoryJournal::flush() {
+    drain();
+}
+
+void HistoryJournal::set_sync_hook(std::function<void()> hook) {
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    sync_hook_ = std::move(hook);
+}
+
+size_t HistoryJournal::pending() const {
+    size_t total = 0;
+    for (const Lane* lane = lanes_.load(std::memory_order_acquire); lane; lane = lane->next) {
+        total += static_cast<size_t>(lane->published.load(std::memory_order_acquire) -
+                                     lane->persisted.load(std::memory_order_acquire));
+    }
+    return total;
+}
+
+HistoryJournal::Lane* HistoryJournal::acquire_lane() {
+    // Adopt a lane whose thread has exited before adding a new one
+    for (Lane* lane = lanes_.load(std::memory_order_acquire); lane; lane = lane->next) {
+        bool expected = false;
+        if (lane->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return lane;
+        }
+    }
+
+    Lane* lane = new Lane();
+    lane->owned.store(true, std::memory_order_relaxed);
+    Lane* head = lanes_.load(std::memory_order_relaxed);
+    do {
+        lane->next = head;
+    } while (!lanes_.compare_exchange_weak(head, lane, std::memory_order_release, std::memory_order_relaxed));
+    return lane;
+}
+
+void HistoryJournal::trim(Lane* lane) {
+    // Owner only. Drop persisted segments beyond the retained window, and
+    // unpersisted ones past MAX_SEGMENTS while the database keeps failing;
+    // readers still walking one keep it alive through their shared_ptr.
+    uint64_t persisted = lane->persisted.load(std::memory_order_acquire);
+    std::shared_ptr<Segment> head = std::atomic_load(&lane->head);
+    while (head.get() != lane->tail &&
+           (((lane->tail->base - head->base) / SEGMENT_SIZE >= RETAINED_SEGMENTS &&
+             head->base + SEGMENT_SIZE <= persisted) ||
+            (lane->tail->base - head->base) / SEGMENT_SIZE >= MAX_SEGMENTS)) {
+        head = std::atomic_load(&head->next);
+        std::atomic_store(&lane->head, head);
+    }
+}
+
+void HistoryJournal::maybe_schedule_drain(const Lane* lane) {
+    uint64_t backlog = lane->published.load(std::memory_order_relaxed) -
+                       lane->persisted.load(std::memory_order_relaxed);
+    int64_t interval_ms = std::chrono::duration_cast<std::chrono::milliseconds>(GROUP_COMMIT_INTERVAL).count();
+    // After a failed batch only the interval triggers the retry
+    bool full = backlog >= GROUP_COMMIT_SIZE && !retrying_.load(std::memory_order_relaxed);
+    if (!full && steady_ms() - last_drain_ms_.load(std::memory_order_relaxed) < interval_ms) {
+        return;
+    }
+    if (!drain_scheduled_.exchange(true, std::memory_order_acq_rel)) {
+        WorkerPool::instance().submit([this] { drain(); });
+    }
+}
+
+void HistoryJournal::drain() {
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    // Appends from here on may schedule the next drain
+    drain_scheduled_.store(false, std::memory_order_release);
+
+    if (sync_hook_) {
+        sync_hook_();
+    }
+
+    struct Mark {
+        Lane* lane;
+        uint64_t to;
+        std::string last_persisted;  // restored if the batch fails
+    };
+    std::vector<std::pair<uint64_t, database::HistoryRow>> batch;
+    std::vector<Mark> marks;
+    for (Lane* lane = lanes_.load(std::memory_order_acquire); lane; lane = lane->next) {
+        uint64_t from = lane->persisted.load(std::memory_order_relaxed);
+        uint64_t to = lane->published.load(std::memory_order_acquire);
+        if (to == from) {
+            continue;
+        }
+        marks.push_back(Mark{lane, to, lane->last_persisted});
+        // Consecutive repeats within a session are stored once
+        std::string& previous = lane->last_persisted;
+        visit_range(lane, from, to, [&](const JournalEntry& entry) {
+            if (entry.command == previous) {
+                return;
+            }
+            previous = entry.command;
+            batch.push_back({entry.sequence, {entry.command, entry.user, entry.timestamp}});
+        });
+    }
+
+    bool stored = true;
+    if (!batch.empty()) {
+        // Insert in global order so the table's rowids follow it
+        std::sort(batch.begin(), batch.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<database::HistoryRow> rows;
+        rows.reserve(batch.size());
+        for (auto& item : batch) {
+            rows.push_back(std::move(item.second));
+        }
+        stored = database::InternalDB::instance().add_history_batch(rows);
+    }
+
+    // A failed batch stays pending for the next drain: daemon and mobile
+    // entries have no other record
+    for (auto& mark : marks) {
+        if (stored) {
+            mark.lane->persisted.store(mark.to, std::memory_order_release);
+        }
+        else {
+            mark.lane->last_persisted = std::move(mark.last_persisted);
+        }
+    }
+    retrying_.store(!stored, std::memory_order_relaxed);
+    last_drain_ms_.store(steady_ms(), std::memory_order_relaxed);
+}
+
+template <typename Visit>
+void HistoryJournal::visit_range(const Lane* lane, uint64_t from, uint64_t to, Visit visit) {
+    std::shared_ptr<Segment> segment = std::atomic_load(&lane->head);
+    if (!segment) {
+        return;
+    }
+    from = std::max(from, segment->base);  // older entries were trimmed
+    while (segment && from >= segment->base + SEGMENT_SIZE) {
+        segment = std::atomic_load(&segment->next);
+    }
+    for (uint64_t i = from; i < to && segment; ++i) {
+        if (i == segment->base + SEGMENT_SIZE) {
+            segment = std::atomic_load(&segment->next);
+            if (!segment) {
+                break;
+            }
+        }
+        visit(segment->entries[i - segment->base]);
+    }
+}
+
+} // namespace core
+} // namespace customos
@@ -0,0 +1,264 @@
+#include "core/history_search.h"
+#include <algorithm>
+
+namespace customos {
+namespace core {
+
+namespace {
+
+inline uint32_t trigram_at(std::string_view text, size_t i) {
+    return (static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16) |
+           (static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8) |
+           static_cast<uint32_t>(static_cast<unsigned char>(text[i + 2]));
+}
+
+inline bool contains(const std::string& text, std::string_view query) {
+    return std::string_view(text).find(query) != std::string_view::npos;
+}
+
+} // anonymous namespace
+
+HistorySearchIndex::HistorySearchIndex()
+    : char_lines_(256, 0)
+    , bigram_lines_(65536, 0)
+    , char_stamp_(256, 0)
+    , bigram_stamp_(65536, 0)
+    , newest_(NONE)
+    , next_seq_(1)
+    , generation_(1) {
+}
+
+void HistorySearchIndex::add(const std::string& command) {
+    if (command.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t seq = next_seq_++;
+    ++generation_;
+
+    auto it = by_text_.find(command);
+    if (it != by_text_.end()) {
+        // Seen before: only its recency changes
+        uint32_t id = it->second;
+        lines_[id].last_seq = seq;
+        unlink(id);
+        push_newest(id);
+        return;
+    }
+
+    uint32_t id = static_cast<uint32_t>(lines_.size());
+    lines_.push_back({command, seq, NONE, NONE});
+    const std::string& text = lines_.back().text;
+    by_text_.emplace(std::string_view(text), id);
+    push_newest(id);
+
+    // Ids only grow, so appending keeps each posting list sorted; a
+    // trigram repeated within the line is posted once
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        auto& list = postings_[trigram_at(text, i)];
+        if (list.empty() || list.back() != id) {
+            list.push_back(id);
+        }
+    }
+
+    // Per-line presence of single bytes and byte pairs; the stamp arrays
+    // remember the last line counted so repeats within a line count once
+    uint32_t stamp = id + 1;
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t c = static_cast<unsigned char>(text[i]);
+        if (char_stamp_[c] != stamp) {
+            char_stamp_[c] = stamp;
+            ++char_lines_[c];
+        }
+        if (i + 1 < text.size()) {
+            uint32_t pair = (c << 8) | static_cast<unsigned char>(text[i + 1]);
+            if (bigram_stamp_[pair] != stamp) {
+                bigram_stamp_[pair] = stamp;
+                ++bigram_lines_[pair];
+            }
+        }
+    }
+}
+
+bool HistorySearchIndex::find(const std::string& query, uint64_t before, Cursor& cursor,
+                              std::string& command, uint64_t& sequence) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (query.empty()) {
+        return false;
+    }
+
+    // Candidates stay valid while the query only grows and nothing was added
+    bool narrowing = cursor.has_candidates && cursor.generation == generation_ &&
+                     query.compare(0, cursor.query.size(), cursor.query) == 0;
+    bool extended = query.size() != cursor.query.size();
+    cursor.query = query;
+    cursor.generation = generation_;
+
+    if (narrowing) {
+        if (extended) {
+            auto end = std::remove_if(cursor.candidates.begin(), cursor.candidates.end(),
+                                      [this, &query](uint32_t id) { return !contains(lines_[id].text, query); });
+            cursor.candidates.erase(end, cursor.candidates.end());
+        }
+    }
+    else {
+        cursor.candidates.clear();
+        cursor.has_candidates = collect_candidates(query, cursor.candidates);
+    }
+
+    uint32_t best = NONE;
+    if (cursor.has_candidates) {
+        for (uint32_t id : cursor.candidates) {
+            uint64_t seq = lines_[id].last_seq;
+            if (seq < before && (best == NONE || seq > lines_[best].last_seq)) {
+                best = id;
+            }
+        }
+    }
+    else if (!walk_recency(query, before, best)) {
+        // Not among the most recent lines after all: fall back to the
+        // exact set (kept in the cursor for the next keystroke)
+        const std::vector<uint32_t>* rarest = query.size() >= 3 ? rarest_postings(query) : nullptr;
+        if (!rarest) {
+            return false;
+        }
+        verify(*rarest, query, cursor.candidates);
+        cursor.has_candidates = true;
+        for (uint32_t id : cursor.candidates) {
+            uint64_t seq = lines_[id].last_seq;
+            if (seq < before && (best == NONE || seq > lines_[best].last_seq)) {
+                best = id;
+            }
+        }
+    }
+
+    if (best == NONE) {
+        return false;
+    }
+    command = lines_[best].text;
+    sequence = lines_[best].last_seq;
+    return true;
+}
+
+size_t HistorySearchIndex::unique_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lines_.size();
+}
+
+bool HistorySearchIndex::collect_candidates(const std::string& query, std::vector<uint32_t>& candidates) const {
+    // Returns false when the candidate set would be too large to be worth
+    // building; matches are then dense and the recency walk finds one fast
+    if (query.size() == 1) {
+        return char_lines_[static_cast<unsigned char>(query[0])] == 0;  // empty set, or walk
+    }
+
+    if (query.size() == 2) {
+        uint32_t pair = (static_cast<uint32_t>(static_cast<unsigned char>(query[0])) << 8) |
+                        static_cast<unsigned char>(query[1]);
+        uint32_t count = bigram_lines_[pair];
+        if (count == 0) {
+            return true;
+        }
+        if (count > MAX_CANDIDATES) {
+            return false;
+        }
+        // A line containing the pair either is the pair or has a trigram
+        // that starts or ends with it
+        for (uint32_t c = 0; c < 256; ++c) {
+            for (uint32_t key : {(pair << 8) | c, (c << 16) | pair}) {
+                auto it = postings_.find(key);
+                if (it != postings_.end()) {
+                    candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+                }
+            }
+        }
+        auto exact = by_text_.find(query);
+        if (exact != by_text_.end()) {
+            candidates.push_back(exact->second);
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        return true;
+    }
+
+    const std::vector<uint32_t>* rarest = rarest_postings(query);
+    if (!rarest) {
+        return true;  // a trigram no line has: no match
+    }
+    if (rarest->size() > MAX_CANDIDATES) {
+        return false;
+    }
+    verify(*rarest, query, candidates);
+    return true;
+}
+
+const std::vector<uint32_t>* HistorySearchIndex::rarest_postings(const std::string& query) const {
+    const std::vector<uint32_t>* rarest = nullptr;
+    for (size_t i = 0; i + 3 <= query.size(); ++i) {
+        auto it = postings_.find(trigram_at(query, i));
+        if (it == postings_.end()) {
+            return nullptr;
+        }
+        if (!rarest || it->second.size() < rarest->size()) {
+            rarest = &it->second;
+        }
+    }
+    return rarest;
+}
+
+void HistorySearchIndex::verify(const std::vector<uint32_t>& ids, const std::string& query,
+                                std::vector<uint32_t>& candidates) const {
+    // Trigrams can match out of order; confirm the substring
+    for (uint32_t id : ids) {
+        if (contains(lines_[id].text, query)) {
+            candidates.push_back(id);
+        }
+    }
+}
+
+void HistorySearchIndex::unlink(uint32_t id) {
+    Line& line = lines_[id];
+    if (line.newer != NONE) {
+        lines_[line.newer].older = line.older;
+    }
+    else {
+        newest_ = line.older;
+    }
+    if (line.older != NONE) {
+        lines_[line.older].newer = line.newer;
+    }
+    line.newer = NONE;
+    line.older = NONE;
+}
+
+void HistorySearchIndex::push_newest(uint32_t id) {
+    Line& line = lines_[id];
+    line.newer = NONE;
+    line.older = newest_;
+    if (newest_ != NONE) {
+        lines_[newest_].newer = id;
+    }
+    newest_ = id;
+}
+
+bool HistorySearchIndex::walk_recency(std::string_view query, uint64_t before, uint32_t& best) const {
+    // Queries of three or more characters give up after MAX_WALK lines and
+    // let the caller use the postings; shorter ones have no postings to use
+    size_t budget = query.size() >= 3 ? MAX_WALK : SIZE_MAX;
+    for (uint32_t id = newest_; id != NONE && budget > 0; id = lines_[id].older) {
+        const Line& line = lines_[id];
+        if (line.last_seq >= before) {
+            continue;
+        }
+        if (contains(line.text, query)) {
+            best = id;
+            return true;
+        }
+        --budget;
+    }
+    return false;
+}
+
+} // namespace core
+} // namespace customos
@@ -0,0 +1,313 @@
+#include "core/job_control.h"
+#include "core/command_metrics.h"
+#include <algorithm>
+#include <chrono>
+
+namespace customos {
+namespace core {
+
+namespace {
+
+thread_local std::shared_ptr<std::atomic<bool>> t_cancel_flag;
+
+} // anonymous namespace
+
+// WorkerPool
+
+WorkerPool::WorkerPool()
+    : stopping_(false)
+    , size_(std::max(2u, std::thread::hardware_concurrency())) {
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+WorkerPool& WorkerPool::instance() {
+    static WorkerPool instance;
+    return instance;
+}
+
+void WorkerPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (threads_.empty()) {
+            start_threads();
+        }
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+size_t WorkerPool::thread_count() const {
+    return size_;
+}
+
+void WorkerPool::start_threads() {
+    // Caller holds mutex_
+    threads_.reserve(size_);
+    for (size_t i = 0; i < size_; ++i) {
+        threads_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+void WorkerPool::worker_loop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        try {
+            task();
+        }
+        catch (...) {
+            // A failing task must not take the worker down
+        }
+    }
+}
+
+// JobTable
+
+struct JobTable::Job {
+    int id = 0;
+    std::string command;
+    JobState state = JobState::QUEUED;
+    int exit_code = -1;
+    std::chrono::steady_clock::time_point started;
+    double wall_ms = 0.0;
+    double cpu_ms = 0.0;
+    std::shared_ptr<std::atomic<bool>> cancel_flag = std::make_shared<std::atomic<bool>>(false);
+    OutputSink output;  // written only by the job's worker thread
+};
+
+JobTable::JobTable()
+    : next_id_(1) {
+}
+
+JobTable::~JobTable() = default;
+
+JobTable& JobTable::instance() {
+    static JobTable instance;
+    return instance;
+}
+
+int JobTable::start(const std::string& command, JobWork work) {
+    auto job = std::make_shared<Job>();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->id = next_id_++;
+        job->command = command;
+        jobs_[job->id] = job;
+    }
+
+    WorkerPool::instance().submit([this, job, work = std::move(work)]() {
+        run(job, work);
+    });
+    return job->id;
+}
+
+void JobTable::run(const std::shared_ptr<Job>& job, const JobWork& work) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (job->cancel_flag->load()) {
+            job->state = JobState::KILLED;
+            finished_cv_.notify_all();
+            return;
+        }
+        job->state = JobState::RUNNING;
+        job->started = std::chrono::steady_clock::now();
+    }
+
+    t_cancel_flag = job->cancel_flag;
+    uint64_t cpu_start = CommandMetrics::thread_cpu_us();
+
+    int exit_code = -1;
+    try {
+        exit_code = work(job->output);
+    }
+    catch (...) {
+        exit_code = -1;
+    }
+
+    double cpu_ms = (CommandMetrics::thread_cpu_us() - cpu_start) / 1000.0;
+    t_cancel_flag.reset();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    job->exit_code = exit_code;
+    job->cpu_ms = cpu_ms;
+    job->wall_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - job->started).count();
+    job->state = job->cancel_flag->load() ? JobState::KILLED : JobState::DONE;
+    finished_cv_.notify_all();
+}
+
+JobInfo JobTable::describe(const Job& job) {
+    // Caller holds mutex_
+    JobInfo info;
+    info.id = job.id;
+    info.command = job.command;
+    info.state = job.state;
+    info.exit_code = job.exit_code;
+    info.wall_ms = job.wall_ms;
+    info.cpu_ms = job.cpu_ms;
+    info.output_bytes = 0;
+
+    if (job.state == JobState::RUNNING) {
+        info.wall_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - job.started).count();
+    }
+    else if (job.state == JobState::DONE || job.state == JobState::KILLED) {
+        info.output_bytes = job.output.total_bytes();
+    }
+    return info;
+}
+
+std::vector<JobInfo> JobTable::list() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<JobInfo> result;
+    result.reserve(jobs_.size());
+    for (const auto& pair : jobs_) {
+        result.push_back(describe(*pair.second));
+    }
+    return result;
+}
+
+bool JobTable::exists(int id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.count(id) > 0;
+}
+
+int JobTable::latest_id() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.empty() ? 0 : jobs_.rbegin()->first;
+}
+
+bool JobTable::wait(int id, JobInfo& info) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return false;
+    }
+
+    std::shared_ptr<Job> job = it->second;
+    finished_cv_.wait(lock, [&job] {
+        return job->state == JobState::DONE || job->state == JobState::KILLED;
+    });
+    info = describe(*job);
+    return true;
+}
+
+void JobTable::wait_all() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_cv_.wait(lock, [this] { return all_finished(); });
+}
+
+bool JobTable::stop_all() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto& pair : jobs_) {
+        pair.second->cancel_flag->store(true);
+    }
+    return finished_cv_.wait_for(lock, std::chrono::milliseconds(STOP_GRACE_MS),
+                                 [this] { return all_finished(); });
+}
+
+bool JobTable::all_finished() const {
+    // Caller holds mutex_
+    for (const auto& pair : jobs_) {
+        if (pair.second->state == JobState::QUEUED || pair.second->state == JobState::RUNNING) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JobTable::collect(int id, JobInfo& info, std::string& output) {
+    if (!wait(id, info)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return false;  // collected concurrently
+    }
+    output = it->second->output.take();
+    jobs_.erase(it);
+    return true;
+}
+
+bool JobTable::kill(int id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return false;
+    }
+    it->second->cancel_flag->store(true);
+    return true;
+}
+
+void JobTable::kill_all() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& pair : jobs_) {
+        pair.second->cancel_flag->store(true);
+    }
+}
+
+std::vector<FinishedJob> JobTable::reap_finished() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<FinishedJob> result;
+    for (auto it = jobs_.begin(); it != jobs_.end();) {
+        const Job& job = *it->second;
+        if (job.state != JobState::DONE && job.state != JobState::KILLED) {
+            ++it;
+            continue;
+        }
+        FinishedJob finished;
+        finished.info = describe(job);
+        finished.output = it->second->output.take();
+        result.push_back(std::move(finished));
+        it = jobs_.erase(it);
+    }
+    return result;
+}
+
+std::string JobTable::status_line(const JobInfo& info) {
+    std::string line = "[" + std::to_string(info.id) + "] " + state_to_string(info.state);
+    if (info.state == JobState::DONE) {
+        line += " (exit " + std::to_string(info.exit_code) + ")";
+    }
+    return line + "  " + info.command;
+}
+
+std::shared_ptr<std::atomic<bool>> JobTable::current_cancel_flag() {
+    return t_cancel_flag;
+}
+
+std::string JobTable::state_to_string(JobState state) {
+    switch (state) {
+        case JobState::QUEUED: return "Queued";
+        case JobState::RUNNING: return "Running";
+        case JobState::DONE: return "Done";
+        case JobState::KILLED: return "Killed";
+        default: return "Unknown";
+    }
+}
+
+} // namespace core
+} // namespace customos
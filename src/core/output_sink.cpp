@@ -0,0 +1,174 @@
+#include "core/output_sink.h"
+#include <algorithm>
+#include <cstring>
+
+namespace customos {
+namespace core {
+
+OutputSink::OutputSink(Drain drain, size_t chunk_size, bool flush_on_sync)
+    : drain_(std::move(drain))
+    , chunk_size_(chunk_size == 0 ? DEFAULT_CHUNK_SIZE : chunk_size)
+    , flush_on_sync_(flush_on_sync)
+    , broken_(false)
+    , total_bytes_(0)
+    , native_fd_(-1) {
+    start_chunk();
+}
+
+OutputSink::~OutputSink() {
+    if (drain_) {
+        flush();
+    }
+}
+
+void OutputSink::write(const char* data, size_t size) {
+    xsputn(data, static_cast<std::streamsize>(size));
+}
+
+void OutputSink::write(const std::string& text) {
+    write(text.data(), text.size());
+}
+
+bool OutputSink::flush() {
+    if (!drain_) {
+        return !broken_;
+    }
+
+    // Drained sinks never seal chunks: the put area is handed over in place
+    // and reused for the next writes
+    size_t used = current_used();
+    if (used > 0) {
+        if (!broken_ && !drain_(pbase(), used)) {
+            broken_ = true;
+        }
+        total_bytes_ += used;
+        setp(pbase(), epptr());
+    }
+    return !broken_;
+}
+
+std::string OutputSink::take() {
+    std::string result;
+
+    if (chunks_.empty()) {
+        size_t used = current_used();
+        total_bytes_ += used;
+        current_.resize(used);
+        result = std::move(current_);
+    }
+    else {
+        seal_current();
+        size_t total = 0;
+        for (const auto& chunk : chunks_) {
+            total += chunk.size();
+        }
+        result.reserve(total);
+        for (const auto& chunk : chunks_) {
+            result += chunk;
+        }
+    }
+
+    // The next write allocates a fresh chunk
+    chunks_.clear();
+    current_ = std::string();
+    setp(nullptr, nullptr);
+    return result;
+}
+
+size_t OutputSink::buffered_bytes() const {
+    size_t total = current_used();
+    for (const auto& chunk : chunks_) {
+        total += chunk.size();
+    }
+    return total;
+}
+
+OutputSink::int_type OutputSink::overflow(int_type ch) {
+    if (drain_ && pbase()) {
+        flush();
+    }
+    else {
+        seal_current();
+        start_chunk();
+    }
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+std::streamsize OutputSink::xsputn(const char* s, std::streamsize n) {
+    // Large writes to a drained sink skip the buffer entirely
+    if (drain_ && static_cast<size_t>(n) >= chunk_size_) {
+        flush();
+        if (!broken_ && !drain_(s, static_cast<size_t>(n))) {
+            broken_ = true;
+        }
+        total_bytes_ += static_cast<size_t>(n);
+        return n;
+    }
+
+    std::streamsize written = 0;
+    while (written < n) {
+        std::streamsize room = epptr() - pptr();
+        if (room == 0) {
+            overflow(traits_type::eof());
+            room = epptr() - pptr();
+        }
+        std::streamsize count = std::min(room, n - written);
+        std::memcpy(pptr(), s + written, static_cast<size_t>(count));
+        pbump(static_cast<int>(count));
+        written += count;
+    }
+    return n;
+}
+
+int OutputSink::sync() {
+    if (flush_on_sync_) {
+        flush();
+    }
+    return 0;
+}
+
+void OutputSink::seal_current() {
+    size_t used = current_used();
+    if (used == 0) {
+        return;
+    }
+    total_bytes_ += used;
+    current_.resize(used);
+    chunks_.push_back(std::move(current_));
+    current_ = std::string();
+    setp(nullptr, nullptr);
+}
+
+void OutputSink::start_chunk() {
+    current_.resize(chunk_size_);
+    setp(&current_[0], &current_[0] + current_.size());
+}
+
+OutputSink::Drain OutputSink::to_streambuf(std::streambuf* target) {
+    return [target](const char* data, size_t size) {
+        bool ok = target->sputn(data, static_cast<std::streamsize>(size)) == static_cast<std::streamsize>(size);
+        target->pubsync();
+        return ok;
+    };
+}
+
+OutputSink::Drain OutputSink::to_file(std::FILE* file) {
+    // Flushed through so a native_fd() writer appends after us
+    return [file](const char* data, size_t size) {
+        return std::fwrite(data, 1, size, file) == size && std::fflush(file) == 0;
+    };
+}
+
+OutputSink::Drain OutputSink::to_stream(std::shared_ptr<CommandStream> stream) {
+    return [stream](const char* data, size_t size) {
+        return stream->write(data, size);
+    };
+}
+
+} // namespace core
+} // namespace customos
@@ -6,12 +6,23 @@
 #include "vault/password_manager.h"
 #include "network/packet_analyzer.h"
 #include "core/tab_completion.h"
+#include "core/job_control.h"
+#include "core/startup_profile.h"
+#include "core/command_history.h"
+#include "core/history_journal.h"
 #include "ai/ai_module.h"
+#include "database/internal_db.h"
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <cstdlib>
 #include <csignal>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include <filesystem>
+#include <cstdio>
+#include <cerrno>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -24,10 +35,108 @@
 namespace customos {
 namespace core {
 
+namespace {
+
+// Set by Shell::request_stop from a signal handler; loops check it
+volatile std::sig_atomic_t g_stop_requested = 0;
+
+int read_key() {
+    int ch = 0;
+#ifdef _WIN32
+    DWORD read;
+    ReadConsole(GetStdHandle(STD_INPUT_HANDLE), &ch, 1, &read, NULL);
+#else
+    // Handlers are installed without SA_RESTART, so a signal ends the read;
+    // go on reading unless it asked the shell to stop
+    while ((ch = getchar()) == EOF && ferror(stdin) && errno == EINTR && !g_stop_requested) {
+        clearerr(stdin);
+    }
+#endif
+    return ch;
+}
+
+// Keystroke trace for bench/completion_bench. When NOVASHELL_KEYTRACE
+// names a file, every key the line editor reads is appended to it as
+// "<ms since the previous key> <key code> <cursor> <line before the key>".
+class KeyTrace {
+public:
+    static KeyTrace& instance() {
+        static KeyTrace trace;
+        return trace;
+    }
+
+    void record(int key, const std::string& line, size_t cursor) {
+        if (!out_.is_open()) {
+            return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        out_ << std::chrono::duration_cast<std::chrono::milliseconds>(now - last_).count() << ' ' << key << ' '
+             << cursor << ' ' << line << '\n';
+        if (key == '\n' || key == '\r') {
+            out_.flush();
+        }
+        last_ = now;
+    }
+
+private:
+    KeyTrace() : last_(std::chrono::steady_clock::now()) {
+        if (const char* path = std::getenv("NOVASHELL_KEYTRACE")) {
+            out_.open(path, std::ios::app);
+        }
+    }
+
+    std::ofstream out_;
+    std::chrono::steady_clock::time_point last_;
+};
+
+#ifndef _WIN32
+// Delivers keystrokes one at a time without echo while the line editor
+// runs (it echoes itself). Signals stay enabled so Ctrl-C still works.
+// One at a time; the saved settings are static so a signal handler can
+// put them back (restore()).
+class RawTerminal {
+public:
+    RawTerminal() {
+        if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_) == 0) {
+            termios raw = saved_;
+            raw.c_lflag &= ~(ICANON | ECHO | IEXTEN);
+            raw.c_cc[VMIN] = 1;
+            raw.c_cc[VTIME] = 0;
+            active_ = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+        }
+    }
+
+    ~RawTerminal() {
+        restore();
+    }
+
+    // Async-signal-safe
+    static void restore() {
+        if (active_) {
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+            active_ = 0;
+        }
+    }
+
+    RawTerminal(const RawTerminal&) = delete;
+    RawTerminal& operator=(const RawTerminal&) = delete;
+
+private:
+    static termios saved_;
+    static volatile std::sig_atomic_t active_;
+};
+
+termios RawTerminal::saved_;
+volatile std::sig_atomic_t RawTerminal::active_ = 0;
+#endif
+
+} // anonymous namespace
+
 Shell::Shell() 
     : prompt_("novashell> ")
     , running_(false)
     , initialized_(false)
+    , interactive_(false)
     , history_index_(-1) {
 }
 
@@ -44,39 +153,58 @@ bool Shell::initialize() {
 
     try {
         // Initialize logger first (using singleton)
-        auto& logger = logging::Logger::instance();
-        logger.set_log_level(logging::LogLevel::INFO);
-        logger.enable_console_output(false);
-        logger.enable_file_output(false);  // Disable file logging
+        {
+            StartupProfile::Phase phase("logger");
+            auto& logger = logging::Logger::instance();
+            logger.set_log_level(logging::LogLevel::INFO);
+            logger.enable_console_output(false);
+            logger.enable_file_output(false);  // Disable file logging
+            logger.set_async(true);            // callers only enqueue; a writer thread does the rest
+            if (!logger.set_audit_journal(".customos/audit.journal")) {
+                std::cerr << "Warning: audit journal unavailable; audit entries are kept in memory only "
+                             "(audit-verify checks it)\n";
+            }
+        }
 
         LOG_INFO("Initializing NovaShell...");
 
         // Authentication uses singleton, no need to initialize
-        
-        // Initialize command processor
-        command_processor_ = std::make_unique<CommandProcessor>();
-        if (!command_processor_->initialize()) {
-            LOG_ERROR("Failed to initialize command processor");
-            return false;
-        }
 
-        // Initialize tab completion
-        if (!core::TabCompletion::instance().initialize()) {
-            LOG_ERROR("Failed to initialize tab completion");
-            return false;
+        // Register command handlers; subsystems they use (vault, AI, network,
+        // ...) construct their singletons when a command first needs them
+        {
+            StartupProfile::Phase phase("command registration");
+            command_processor_ = std::make_unique<CommandProcessor>();
+            if (!command_processor_->initialize()) {
+                LOG_ERROR("Failed to initialize command processor");
+                return false;
+            }
         }
 
-        // Initialize AI modules
-        if (!ai::initialize_ai_modules()) {
-            LOG_ERROR("Failed to initialize AI modules");
-            // Don't fail startup if AI modules fail - they can be initialized later
-        }
+        // Tab completion loads its learning model from disk, so it is brought
+        // up on the first Tab press or learned command. The model's path is
+        // fixed now, before a `cd` can change what a relative path means.
+        std::string model_path = std::filesystem::absolute(".customos/command_model").string();
+        LazySubsystems::instance().add("completion", [this, model_path] {
+            LazySubsystems::instance().ensure("ai");  // AI completion provider
+            core::TabCompletion::instance().set_command_registry(command_processor_->get_registry());
+            core::TabCompletion::instance().set_learning_path(model_path);
+            return core::TabCompletion::instance().initialize();
+        });
 
         // Load configuration
-        load_configuration();
+        {
+            StartupProfile::Phase phase("configuration");
+            load_configuration();
+        }
 
-        // Display welcome message
-        display_welcome();
+        // Map the history log; only its tail is parsed
+        {
+            StartupProfile::Phase phase("history");
+            if (!CommandHistory::instance().open(".customos/history.log")) {
+                LOG_WARNING("Command history log unavailable; history is kept in memory only");
+            }
+        }
 
         initialized_ = true;
         LOG_INFO("NovaShell initialized successfully");
@@ -106,9 +234,19 @@ void Shell::run() {
     }
 
     running_ = true;
+    interactive_ = true;
 
-    while (running_) {
+    // Display welcome message
+    display_welcome();
+
+    while (running_ && !g_stop_requested) {
         try {
+            // Report background jobs that finished since the last prompt,
+            // with their output, and forget them
+            for (const auto& job : JobTable::instance().reap_finished()) {
+                std::cout << job.output << JobTable::status_line(job.info) << "\n";
+            }
+
             // Display prompt
             std::cout << prompt_;
             std::cout.flush();
@@ -131,6 +269,94 @@ void Shell::run() {
             LOG_ERROR(std::string("Shell error: ") + e.what());
         }
     }
+
+    interactive_ = false;
+
+    if (g_stop_requested) {
+        std::cout << "\nShutting down NovaShell...\n";
+    }
+}
+
+void Shell::request_stop() {
+    g_stop_requested = 1;
+#ifndef _WIN32
+    RawTerminal::restore();
+#endif
+}
+
+int Shell::run_batch(std::istream& input, const std::string& source) {
+    if (!initialized_) {
+        std::cerr << "Shell not initialized. Call initialize() first.\n";
+        return 1;
+    }
+
+    // Learning and history writes of many commands share one transaction;
+    // commit periodically so a long script does not hold the database
+    const size_t COMMANDS_PER_TRANSACTION = 256;
+    auto& db = database::InternalDB::instance();
+    bool in_transaction = db.begin_transaction();
+
+    std::vector<double> durations;
+    size_t failures = 0;
+    size_t line_number = 0;
+    auto batch_start = std::chrono::steady_clock::now();
+
+    running_ = true;
+    std::string line;
+    while (running_ && !g_stop_requested && std::getline(input, line)) {
+        ++line_number;
+
+        // Trim, skip blanks and '#' comments
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+        size_t end = line.find_last_not_of(" \t\r");
+        std::string command = line.substr(begin, end - begin + 1);
+
+        auto start = std::chrono::steady_clock::now();
+        bool success = execute_command(command);
+        durations.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+
+        if (!success) {
+            ++failures;
+            std::cerr << source << ":" << line_number << ": command failed: " << command << "\n";
+        }
+
+        if (in_transaction && durations.size() % COMMANDS_PER_TRANSACTION == 0) {
+            db.commit_transaction();
+            in_transaction = db.begin_transaction();
+        }
+    }
+    running_ = false;
+
+    if (in_transaction) {
+        db.commit_transaction();
+    }
+    std::cout.flush();
+
+    double total_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - batch_start).count();
+
+    std::cerr << "Batch " << source << ": " << durations.size() << " commands, "
+              << failures << " failed, " << std::fixed << std::setprecision(3) << total_ms << " ms total";
+    if (!durations.empty()) {
+        std::vector<double> sorted = durations;
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&sorted](double p) {
+            return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+        };
+        double sum = 0.0;
+        for (double d : sorted) sum += d;
+
+        std::cerr << " (mean " << sum / sorted.size() << " ms, p50 " << percentile(0.50)
+                  << " ms, p95 " << percentile(0.95) << " ms, max " << sorted.back() << " ms)";
+    }
+    std::cerr << "\n";
+    std::cerr.unsetf(std::ios::floatfield);
+
+    return failures == 0 ? 0 : 1;
 }
 
 bool Shell::execute_command(const std::string& command) {
@@ -138,13 +364,8 @@ bool Shell::execute_command(const std::string& command) {
         return true;
     }
 
-    // Add command to history (avoid duplicates of last command)
-    if (command_history_.empty() || command_history_.back() != command) {
-        command_history_.push_back(command);
-        if (command_history_.size() > 1000) {  // Keep last 1000 commands
-            command_history_.erase(command_history_.begin());
-        }
-    }
+    // Add command to history (repeats of the last command are skipped)
+    CommandHistory::instance().record(command, auth::Authentication::instance().get_current_user());
 
     // Check for built-in shell commands
     if (command == "exit" || command == "quit") {
@@ -172,14 +393,6 @@ bool Shell::execute_command(const std::string& command) {
     // Process command
     auto result = command_processor_->process(command);
 
-    // Learn from successful command execution for better future suggestions
-    if (result.success) {
-        static std::string previous_command;
-        core::TabCompletion::instance().learn_from_command(command, previous_command);
-        core::TabCompletion::instance().add_to_history(command);
-        previous_command = command;
-    }
-
     // Display output
     if (!result.output.empty()) {
         std::cout << result.output;
@@ -188,25 +401,51 @@ bool Shell::execute_command(const std::string& command) {
         }
     }
 
+    // Learn from successful command execution for better future suggestions.
+    // Done after the output is shown since the first call loads completion;
+    // only the interactive loop loads it, never batch or one-shot commands.
+    if (result.success && interactive_ && LazySubsystems::instance().ensure("completion")) {
+        static std::string previous_command;
+        core::TabCompletion::instance().learn_from_command(command, previous_command);
+        core::TabCompletion::instance().add_to_history(command);
+        previous_command = command;
+    }
+
     return result.success;
 }
 
-void Shell::shutdown() {
+bool Shell::shutdown() {
     if (!initialized_) {
-        return;
+        return true;
     }
 
     LOG_INFO("Shutting down NovaShell...");
 
     running_ = false;
+
+    // Cancellation is cooperative; a job that ignores it keeps its handler
+    // (and so the command processor) in use
+    bool jobs_stopped = JobTable::instance().stop_all();
+    if (!jobs_stopped) {
+        std::cerr << "NovaShell: background jobs did not stop; exiting without them\n";
+    }
     
     // Save history
     save_history();
 
     // Cleanup subsystems
-    command_processor_.reset();
+    core::TabCompletion::instance().shutdown();
+    core::TabCompletion::instance().set_command_registry(nullptr);
+    if (jobs_stopped) {
+        command_processor_.reset();
+    }
+    else {
+        command_processor_.release();
+    }
+    logging::Logger::instance().flush();
 
     initialized_ = false;
+    return jobs_stopped;
 }
 
 std::string Shell::get_prompt() const {
@@ -217,13 +456,21 @@ void Shell::set_prompt(const std::string& prompt) {
     prompt_ = prompt;
 }
 
+CommandProcessor* Shell::get_command_processor() {
+    return command_processor_.get();
+}
+
 void Shell::load_configuration() {
     // TODO: Load configuration from file
     // For now, use defaults
 }
 
 void Shell::save_history() {
-    // TODO: Save command history to file
+    // Write queued SQLite rows, syncing the log through the journal's hook,
+    // then detach and release the log file. Done here, not in destructors:
+    // the journal is a static destroyed before CommandHistory.
+    HistoryJournal::instance().flush();
+    CommandHistory::instance().close();
 }
 
 std::string Shell::read_input() {
@@ -243,6 +490,7 @@ std::string Shell::read_input_with_completion() {
     std::string current_line;
     size_t cursor_pos = 0;
     std::vector<std::string> completion_matches;
+    std::vector<core::CompletionMatch> completion_details;  // as returned, for the listing
     size_t completion_index = 0;
     std::string original_line;
 
@@ -252,6 +500,8 @@ std::string Shell::read_input_with_completion() {
     DWORD mode;
     GetConsoleMode(hConsole, &mode);
     SetConsoleMode(hConsole, mode & ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT));
+#else
+    RawTerminal raw_terminal;
 #endif
 
     while (true) {
@@ -261,16 +511,35 @@ std::string Shell::read_input_with_completion() {
         DWORD read;
         ReadConsole(hConsole, &ch, 1, &read, NULL);
 #else
-        ch = getchar();
+        ch = read_key();
+        if (ch == EOF) {
+            running_ = false;
+            std::cout << std::endl;
+            break;
+        }
 #endif
+        KeyTrace::instance().record(ch, current_line, cursor_pos);
 
         if (ch == '\n' || ch == '\r') {
             std::cout << std::endl;
             break;
         }
+        else if (ch == 18) {  // Ctrl-R: reverse incremental history search
+            bool execute = reverse_search(current_line);
+            cursor_pos = current_line.length();
+            completion_matches.clear();
+            history_index_ = -1;
+            original_line = current_line;
+            if (execute) {
+                std::cout << std::endl;
+                break;
+            }
+        }
         else if (ch == '\t') {  // Tab key pressed
             if (completion_matches.empty()) {
-                auto matches = core::TabCompletion::instance().complete(current_line, cursor_pos);
+                LazySubsystems::instance().ensure("completion");
+                completion_details = core::TabCompletion::instance().complete(current_line, cursor_pos);
+                const auto& matches = completion_details;
 
                 // Separate AI/learning suggestions for special display
                 std::vector<std::string> ai_matches;
@@ -312,7 +581,7 @@ std::string Shell::read_input_with_completion() {
                     std::cout << "\n";  // Move to next line
 
                     // Show AI suggestions first with special highlighting
-                    auto matches = core::TabCompletion::instance().complete(current_line, cursor_pos);
+                    const auto& matches = completion_details;
                     std::vector<std::string> ai_suggestions, learning_suggestions, regular_suggestions;
 
                     for (const auto& match : matches) {
@@ -381,15 +650,16 @@ std::string Shell::read_input_with_completion() {
 
             if (seq1 == '[') {
                 if (seq2 == 'A') {  // Up arrow
-                    if (!command_history_.empty()) {
+                    auto& history = CommandHistory::instance();
+                    if (history.size() > 0) {
                         if (history_index_ == -1) {
                             original_line = current_line;
-                            history_index_ = command_history_.size() - 1;
+                            history_index_ = static_cast<int>(history.size()) - 1;
                         } else if (history_index_ > 0) {
                             history_index_--;
                         }
 
-                        current_line = command_history_[history_index_];
+                        current_line = history.at(history_index_);
                         cursor_pos = current_line.length();
 
                         // Clear line and rewrite with prompt
@@ -400,9 +670,10 @@ std::string Shell::read_input_with_completion() {
                 }
                 else if (seq2 == 'B') {  // Down arrow
                     if (history_index_ != -1) {
-                        if (history_index_ < static_cast<int>(command_history_.size()) - 1) {
+                        auto& history = CommandHistory::instance();
+                        if (history_index_ < static_cast<int>(history.size()) - 1) {
                             history_index_++;
-                            current_line = command_history_[history_index_];
+                            current_line = history.at(history_index_);
                         } else {
                             history_index_ = -1;
                             current_line = original_line;
@@ -491,6 +762,90 @@ std::string Shell::read_input_with_completion() {
     return current_line;
 }
 
+bool Shell::reverse_search(std::string& line) {
+    const HistorySearchIndex& index = CommandHistory::instance().search_index();
+    HistorySearchIndex::Cursor cursor;
+    std::string query;
+    std::string match;
+    uint64_t match_seq = HistorySearchIndex::NEWEST;
+    bool failed = false;
+    size_t shown = 0;
+
+    // Rewrite the current terminal line, blanking what is left of the last one
+    auto show = [&shown](const std::string& text) {
+        std::cout << "\r" << text;
+        if (shown > text.size()) {
+            std::cout << std::string(shown - text.size(), ' ') << "\r" << text;
+        }
+        shown = text.size();
+        std::cout.flush();
+    };
+    auto draw = [&]() {
+        show(std::string(failed ? "(failed reverse-i-search)`" : "(reverse-i-search)`") + query + "': " + match);
+    };
+    auto search = [&](uint64_t before) {
+        std::string found;
+        uint64_t seq;
+        if (index.find(query, before, cursor, found, seq)) {
+            match = found;
+            match_seq = seq;
+            failed = false;
+        }
+        else {
+            failed = !query.empty();
+        }
+    };
+
+    draw();
+    while (true) {
+        int ch = read_key();
+        if (ch == '\n' || ch == '\r') {
+            if (!match.empty()) {
+                line = match;
+            }
+            show(prompt_ + line);
+            return true;
+        }
+        else if (ch == 7 || ch == EOF) {  // Ctrl-G: give up, keep the original line
+            show(prompt_ + line);
+            return false;
+        }
+        else if (ch == 27) {  // ESC or an arrow key: edit the match
+            int seq1 = read_key();
+            if (seq1 == '[') {
+                read_key();
+            }
+            if (!match.empty()) {
+                line = match;
+            }
+            show(prompt_ + line);
+            return false;
+        }
+        else if (ch == 18) {  // Ctrl-R again: next older match
+            if (!query.empty()) {
+                search(match_seq);
+            }
+        }
+        else if (ch == 127 || ch == 8) {
+            if (!query.empty()) {
+                query.pop_back();
+                match.clear();
+                match_seq = HistorySearchIndex::NEWEST;
+                failed = false;
+                if (!query.empty()) {
+                    search(HistorySearchIndex::NEWEST);
+                }
+            }
+        }
+        else if (ch >= 32 && ch <= 126) {
+            // Keep the current match if it still fits the longer query
+            query.push_back(static_cast<char>(ch));
+            search(match.empty() ? HistorySearchIndex::NEWEST : match_seq + 1);
+        }
+        draw();
+    }
+}
+
 void Shell::handle_signal(int signal) {
     if (signal == SIGINT) {
         std::cout << "\n";
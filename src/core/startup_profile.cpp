@@ -0,0 +1,139 @@
+#include "core/startup_profile.h"
+#include <algorithm>
+#include <iomanip>
+
+namespace customos {
+namespace core {
+
+namespace {
+
+double to_ms(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+} // anonymous namespace
+
+// StartupProfile
+
+StartupProfile::StartupProfile()
+    : origin_(std::chrono::steady_clock::now())
+    , enabled_(false) {
+}
+
+StartupProfile& StartupProfile::instance() {
+    static StartupProfile instance;
+    return instance;
+}
+
+void StartupProfile::set_enabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    enabled_ = enabled;
+}
+
+bool StartupProfile::is_enabled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return enabled_;
+}
+
+void StartupProfile::record(const std::string& phase, std::chrono::steady_clock::time_point start,
+                            std::chrono::steady_clock::time_point end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back({phase, to_ms(start - origin_), to_ms(end - start)});
+}
+
+std::vector<StartupProfile::Entry> StartupProfile::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_;
+}
+
+void StartupProfile::report(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!enabled_) {
+        return;
+    }
+
+    double elapsed = to_ms(std::chrono::steady_clock::now() - origin_);
+
+    out << "Startup profile (" << std::fixed << std::setprecision(3) << elapsed << " ms since start)\n";
+    out << std::left << std::setw(28) << "PHASE" << std::right
+        << std::setw(12) << "AT (ms)" << std::setw(12) << "TOOK (ms)" << "\n";
+    // Phases are recorded when they end; list them in the order they began
+    std::vector<Entry> ordered = entries_;
+    std::stable_sort(ordered.begin(), ordered.end(), [](const Entry& a, const Entry& b) {
+        return a.start_ms < b.start_ms;
+    });
+    for (const auto& entry : ordered) {
+        out << std::left << std::setw(28) << entry.phase << std::right
+            << std::setw(12) << entry.start_ms << std::setw(12) << entry.duration_ms << "\n";
+    }
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+}
+
+StartupProfile::Phase::Phase(const std::string& name)
+    : name_(name)
+    , start_(std::chrono::steady_clock::now()) {
+}
+
+StartupProfile::Phase::~Phase() {
+    StartupProfile::instance().record(name_, start_, std::chrono::steady_clock::now());
+}
+
+// LazySubsystems
+
+struct LazySubsystems::Subsystem {
+    Initializer init;
+    std::once_flag once;
+    bool ready = false;
+};
+
+LazySubsystems& LazySubsystems::instance() {
+    static LazySubsystems instance;
+    return instance;
+}
+
+void LazySubsystems::add(const std::string& name, Initializer init) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto subsystem = std::make_shared<Subsystem>();
+    subsystem->init = std::move(init);
+    subsystems_[name] = subsystem;
+}
+
+bool LazySubsystems::ensure(const std::string& name) {
+    std::shared_ptr<Subsystem> subsystem;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = subsystems_.find(name);
+        if (it == subsystems_.end()) {
+            return false;
+        }
+        subsystem = it->second;
+    }
+
+    // Initializers may be slow (database, network); run them outside mutex_
+    // so unrelated subsystems can come up concurrently
+    std::call_once(subsystem->once, [&] {
+        StartupProfile::Phase phase("lazy: " + name);
+        bool ok = false;
+        try {
+            ok = subsystem->init();
+        }
+        catch (...) {
+            ok = false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        subsystem->ready = ok;
+    });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subsystem->ready;
+}
+
+bool LazySubsystems::is_ready(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = subsystems_.find(name);
+    return it != subsystems_.end() && it->second->ready;
+}
+
+} // namespace core
+} // namespace customos
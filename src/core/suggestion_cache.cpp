@@ -0,0 +1,366 @@
+#include "core/suggestion_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+namespace customos {
+namespace core {
+
+namespace {
+
+// Record layout, native byte order:
+//   u32 payload length | u64 key | i64 created | u32 length, typed |
+//   u32 count | count x (u32 length, suggestion)
+const size_t LENGTH_FIELD = sizeof(uint32_t);
+
+struct Reader {
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+
+    template <typename T>
+    bool read(T& value) {
+        if (size - pos < sizeof(T)) return false;
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool read_string(std::string& text) {
+        uint32_t length;
+        if (!read(length) || size - pos < length) return false;
+        text.assign(data + pos, length);
+        pos += length;
+        return true;
+    }
+};
+
+template <typename T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void put_string(std::string& out, const std::string& text) {
+    put(out, static_cast<uint32_t>(text.size()));
+    out += text;
+}
+
+// Decodes the payload after the length field
+bool decode(const char* data, size_t size, uint64_t& key, int64_t& created, std::string& typed,
+            std::vector<std::string>& suggestions) {
+    Reader reader{data, size};
+    uint32_t count;
+    if (!reader.read(key) || !reader.read(created) || !reader.read_string(typed) || !reader.read(count)) {
+        return false;
+    }
+    suggestions.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string suggestion;
+        if (!reader.read_string(suggestion)) {
+            return false;
+        }
+        suggestions.push_back(std::move(suggestion));
+    }
+    return true;
+}
+
+bool starts_with(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+} // anonymous namespace
+
+SuggestionCache::SuggestionCache() {
+}
+
+SuggestionCache::~SuggestionCache() {
+}
+
+std::string SuggestionCache::normalize(const std::string& typed) {
+    // Runs of whitespace become one space; a trailing space is kept, as
+    // "git " asks for something other than "git" does
+    std::string out;
+    out.reserve(typed.size());
+    bool space = false;
+    for (char c : typed) {
+        if (c == ' ' || c == '\t') {
+            space = !out.empty();
+            continue;
+        }
+        if (space) {
+            out += ' ';
+            space = false;
+        }
+        out += c;
+    }
+    if (space) {
+        out += ' ';
+    }
+    return out;
+}
+
+uint64_t SuggestionCache::hash_key(const std::string& normalized, const std::string& directory) {
+    // FNV-1a over "<typed>\0<directory>"
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    auto mix = [&hash](std::string_view text) {
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 0x100000001b3ULL;
+        }
+    };
+    mix(normalized);
+    mix(std::string_view("\0", 1));
+    mix(directory);
+    return hash;
+}
+
+bool SuggestionCache::expired(int64_t created) {
+    int64_t ttl = std::chrono::duration_cast<std::chrono::seconds>(TTL).count();
+    return static_cast<int64_t>(std::time(nullptr)) - created >= ttl;
+}
+
+bool SuggestionCache::open(const std::string& path) {
+    std::string contents;
+    {
+        std::ifstream in(path, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Latest record per key; earlier ones are dead
+    struct Live {
+        uint64_t offset;
+        uint32_t length;
+        int64_t created;
+    };
+    std::unordered_map<uint64_t, Live> live;
+    size_t records = 0;
+    size_t pos = 0;
+    while (contents.size() - pos >= LENGTH_FIELD) {
+        uint32_t payload;
+        std::memcpy(&payload, contents.data() + pos, sizeof(payload));
+        if (contents.size() - pos - LENGTH_FIELD < payload) {
+            break;  // torn by a crash
+        }
+        uint64_t key;
+        int64_t created;
+        std::string typed;
+        std::vector<std::string> suggestions;
+        if (!decode(contents.data() + pos + LENGTH_FIELD, payload, key, created, typed, suggestions)) {
+            break;
+        }
+        live[key] = {pos, static_cast<uint32_t>(LENGTH_FIELD + payload), created};
+        ++records;
+        pos += LENGTH_FIELD + payload;
+    }
+
+    std::vector<Live> keep;
+    for (const auto& item : live) {
+        if (!expired(item.second.created)) {
+            keep.push_back(item.second);
+        }
+    }
+    std::sort(keep.begin(), keep.end(), [](const Live& a, const Live& b) { return a.created > b.created; });
+    if (keep.size() > DISK_ENTRIES) {
+        keep.resize(DISK_ENTRIES);
+    }
+    // Oldest first, so a rewritten file reads in the order it was built
+    std::reverse(keep.begin(), keep.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    path_ = path;
+    disk_.clear();
+    if (keep.size() == records && pos == contents.size()) {
+        for (const auto& record : keep) {
+            uint64_t key;
+            std::memcpy(&key, contents.data() + record.offset + LENGTH_FIELD, sizeof(key));
+            disk_[key] = {record.offset, record.length, record.created};
+        }
+        return true;
+    }
+
+    // Dead, expired or torn records: rewrite with only the kept ones
+    std::string temp_path = path + ".tmp";
+    std::string compacted;
+    for (const auto& record : keep) {
+        uint64_t key;
+        std::memcpy(&key, contents.data() + record.offset + LENGTH_FIELD, sizeof(key));
+        disk_[key] = {compacted.size(), record.length, record.created};
+        compacted.append(contents, record.offset, record.length);
+    }
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(compacted.data(), static_cast<std::streamsize>(compacted.size()));
+        if (!out) {
+            disk_.clear();
+            path_.clear();
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp_path, path, ec);
+    if (ec) {
+        disk_.clear();
+        path_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SuggestionCache::find(const std::string& typed, const std::string& directory,
+                           std::vector<std::string>& suggestions) {
+    std::string normalized = normalize(typed);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    bool from_disk = false;
+    if (lookup(hash_key(normalized, directory), normalized, suggestions, from_disk)) {
+        ++(from_disk ? stats_.disk_hits : stats_.hits);
+        return true;
+    }
+
+    // Reuse the longest cached prefix whose suggestions still fit
+    std::vector<std::string> candidates;
+    for (size_t length = normalized.size(); length-- > 1;) {
+        std::string prefix = normalized.substr(0, length);
+        if (!lookup(hash_key(prefix, directory), prefix, candidates, from_disk)) {
+            continue;
+        }
+        suggestions.clear();
+        for (const auto& candidate : candidates) {
+            if (starts_with(normalize(candidate), normalized)) {
+                suggestions.push_back(candidate);
+            }
+        }
+        if (!suggestions.empty()) {
+            ++stats_.prefix_hits;
+            return true;
+        }
+    }
+
+    ++stats_.misses;
+    return false;
+}
+
+void SuggestionCache::store(const std::string& typed, const std::string& directory,
+                            const std::vector<std::string>& suggestions) {
+    Entry entry;
+    entry.typed = normalize(typed);
+    entry.key = hash_key(entry.typed, directory);
+    entry.suggestions = suggestions;
+    entry.created = static_cast<int64_t>(std::time(nullptr));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    append_record(entry);
+    insert_memory(std::move(entry));
+}
+
+SuggestionCache::Stats SuggestionCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.memory_entries = memory_.size();
+    stats.disk_entries = disk_.size();
+    return stats;
+}
+
+bool SuggestionCache::lookup(uint64_t key, const std::string& normalized, std::vector<std::string>& suggestions,
+                             bool& from_disk) {
+    auto it = memory_.find(key);
+    if (it != memory_.end()) {
+        if (it->second->typed != normalized || expired(it->second->created)) {
+            return false;
+        }
+        lru_.splice(lru_.begin(), lru_, it->second);
+        suggestions = it->second->suggestions;
+        from_disk = false;
+        return true;
+    }
+
+    auto record = disk_.find(key);
+    if (record == disk_.end() || expired(record->second.created)) {
+        return false;
+    }
+    Entry entry;
+    if (!read_record(record->second, entry) || entry.typed != normalized) {
+        return false;
+    }
+    suggestions = entry.suggestions;
+    from_disk = true;
+    insert_memory(std::move(entry));
+    return true;
+}
+
+void SuggestionCache::insert_memory(Entry entry) {
+    auto it = memory_.find(entry.key);
+    if (it != memory_.end()) {
+        lru_.erase(it->second);
+        memory_.erase(it);
+    }
+    uint64_t key = entry.key;
+    lru_.push_front(std::move(entry));
+    memory_[key] = lru_.begin();
+
+    while (lru_.size() > MEMORY_ENTRIES) {
+        memory_.erase(lru_.back().key);
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+}
+
+bool SuggestionCache::read_record(const DiskRecord& record, Entry& entry) const {
+    std::ifstream in(path_, std::ios::binary);
+    if (!in.seekg(static_cast<std::streamoff>(record.offset))) {
+        return false;
+    }
+    std::string data(record.length, '\0');
+    if (!in.read(&data[0], static_cast<std::streamsize>(data.size()))) {
+        return false;
+    }
+    return decode(data.data() + LENGTH_FIELD, data.size() - LENGTH_FIELD, entry.key, entry.created, entry.typed,
+                  entry.suggestions);
+}
+
+void SuggestionCache::append_record(const Entry& entry) {
+    if (path_.empty()) {
+        return;
+    }
+
+    std::string payload;
+    put(payload, entry.key);
+    put(payload, entry.created);
+    put_string(payload, entry.typed);
+    put(payload, static_cast<uint32_t>(entry.suggestions.size()));
+    for (const auto& suggestion : entry.suggestions) {
+        put_string(payload, suggestion);
+    }
+    std::string record;
+    put(record, static_cast<uint32_t>(payload.size()));
+    record += payload;
+
+    // Another session may have appended since; take the offset from the file
+    std::ofstream out(path_, std::ios::binary | std::ios::app);
+    out.seekp(0, std::ios::end);
+    std::streamoff offset = out.tellp();
+    if (offset < 0 || !out.write(record.data(), static_cast<std::streamsize>(record.size()))) {
+        return;
+    }
+    disk_[entry.key] = {static_cast<uint64_t>(offset), static_cast<uint32_t>(record.size()), entry.created};
+
+    // The file itself is trimmed on the next open
+    if (disk_.size() > DISK_ENTRIES) {
+        auto oldest = disk_.begin();
+        for (auto it = disk_.begin(); it != disk_.end(); ++it) {
+            if (it->second.created < oldest->second.created) {
+                oldest = it;
+            }
+        }
+        disk_.erase(oldest);
+    }
+}
+
+} // namespace core
+} // namespace customos
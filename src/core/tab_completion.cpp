@@ -1,5 +1,10 @@
 #include "core/tab_completion.h"
 #include "core/command_registry.h"
+#include "core/job_control.h"
+#include "core/fuzzy_matcher.h"
+#include "core/directory_cache.h"
+#include "core/command_model.h"
+#include "core/suggestion_cache.h"
 #include "git/git_manager.h"
 #include "database/db_manager.h"
 #include "ai/ai_module.h"
@@ -7,11 +12,13 @@
 #include "auth/authentication.h"
 #include "database/internal_db.h"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <sstream>
 #include <filesystem>
 #include <unordered_map>
-#include <unordered_set>
 #include <chrono>
 #include <iomanip>
 
@@ -22,41 +29,80 @@ namespace core {
 
 struct TabCompletion::Impl {
     std::vector<std::shared_ptr<ICompletionProvider>> providers;
-    bool case_sensitive = false;
-    bool fuzzy_matching = false;
-    int max_suggestions = 20;
+    CompletionSettings settings;
     bool smart_completion = true;
+    std::chrono::milliseconds deadline = DEFAULT_DEADLINE;
+    std::atomic<const CommandRegistry*> registry{nullptr};
     std::vector<std::string> history;
-    std::mutex mutex;
-
-    // Learning system
-    struct CommandPattern {
-        std::string command;
-        std::string context;  // time, day, location
-        int frequency = 1;
-        std::chrono::system_clock::time_point last_used;
-        std::unordered_set<std::string> next_commands;  // commands used after this one
-        std::unordered_map<std::string, int> argument_patterns;  // common arguments
+    std::mutex mutex;       // providers, settings and history
+    std::mutex data_mutex;  // the learning model, used by providers
+
+    // Bumped by every complete(); requests from older calls are stale
+    std::atomic<uint64_t> generation{0};
+
+    // Results of one complete() call
+    struct Round {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::vector<CompletionMatch> matches;
+        size_t outstanding = 0;
+        bool closed = false;  // deadline passed; later results are dropped
+
+        void deliver(std::vector<CompletionMatch> found) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!closed) {
+                    matches.insert(matches.end(), std::make_move_iterator(found.begin()),
+                                   std::make_move_iterator(found.end()));
+                }
+                --outstanding;
+            }
+            done.notify_all();
+        }
     };
 
-    std::unordered_map<std::string, CommandPattern> command_patterns;
-    std::unordered_map<std::string, std::vector<std::string>> workflow_sequences;
-    std::unordered_map<std::string, int> time_based_patterns;  // hour -> command frequency
-    std::unordered_map<std::string, int> context_patterns;     // context -> command frequency
+    // Fast providers of one round, claimed one at a time
+    struct FastBatch {
+        std::vector<std::shared_ptr<ICompletionProvider>> providers;
+        std::atomic<size_t> next{0};
+        CompletionContext context;
+        std::chrono::steady_clock::time_point deadline;
+    };
 
-    // AI suggestion cache
-    struct AISuggestion {
-        std::string input;
-        std::vector<std::string> suggestions;
-        std::chrono::system_clock::time_point timestamp;
+    // A blocking provider's runner thread and its one queued request
+    struct BlockingSlot {
+        std::mutex mutex;
+        bool running = false;
+        std::function<void()> queued;
+        std::thread runner;  // joined before it is replaced, and on shutdown
     };
-    std::unordered_map<std::string, AISuggestion> ai_cache;
+    std::unordered_map<std::string, std::shared_ptr<BlockingSlot>> blocking_slots;
+
+    ~Impl() {
+        join_runners();
+    }
+
+    void join_runners();
+
+    void dispatch_blocking(const std::shared_ptr<ICompletionProvider>& provider,
+                           const CompletionContext& context,
+                           const std::shared_ptr<Round>& round);
+
+    static void run_fast(const std::shared_ptr<FastBatch>& batch, const std::shared_ptr<Round>& round, bool late);
+
+    // Learning system
+    CommandModel model;
+    std::string learning_path = ".customos/command_model";
+
+    // AI suggestions by typed text and directory, kept across sessions
+    SuggestionCache ai_cache;
 
     CompletionContext parse_context(const std::string& line, int cursor_pos) {
         CompletionContext ctx;
         ctx.line = line;
         ctx.cursor_position = cursor_pos;
-        ctx.current_directory = fs::current_path().string();
+        ctx.word_index = 0;
+        ctx.current_directory = DirectoryCache::instance().current_directory();
         
         // Split into words
         std::istringstream iss(line.substr(0, cursor_pos));
@@ -73,28 +119,89 @@ struct TabCompletion::Impl {
         return ctx;
     }
 
-    bool matches(const std::string& text, const std::string& prefix) {
-        if (!case_sensitive) {
-            std::string text_lower = text;
-            std::string prefix_lower = prefix;
-            std::transform(text_lower.begin(), text_lower.end(), text_lower.begin(), ::tolower);
-            std::transform(prefix_lower.begin(), prefix_lower.end(), prefix_lower.begin(), ::tolower);
-            return text_lower.find(prefix_lower) == 0;
+    static bool matches(const std::string& text, const std::string& prefix, bool case_sensitive) {
+        if (text.size() < prefix.size()) {
+            return false;
+        }
+        if (case_sensitive) {
+            return text.compare(0, prefix.size(), prefix) == 0;
+        }
+        for (size_t i = 0; i < prefix.size(); ++i) {
+            if (::tolower(static_cast<unsigned char>(text[i])) != ::tolower(static_cast<unsigned char>(prefix[i]))) {
+                return false;
+            }
         }
-        return text.find(prefix) == 0;
+        return true;
     }
 
-    std::vector<CompletionMatch> filter_matches(const std::vector<CompletionMatch>& matches) {
+    // Entries of the prefix's directory whose names match its last component
+    static std::vector<CompletionMatch> complete_paths(const std::string& prefix, bool directories_only,
+                                                       const CompletionSettings& settings) {
+        std::vector<CompletionMatch> found;
+        fs::path search_path = prefix.empty() ? "." : prefix;
+        fs::path dir = search_path.parent_path();
+        if (dir.empty()) dir = ".";
+        std::string name_prefix = prefix.empty() ? "" : search_path.filename().string();
+
+        auto listing = DirectoryCache::instance().get(dir.string());
+        if (!listing) {
+            return found;
+        }
+        auto add = [&](size_t i, int score) {
+            CompletionMatch match;
+            match.text = (dir / listing->names[i]).string();
+            match.description = listing->is_directory[i] ? "Directory" : "File";
+            match.priority = listing->is_directory[i] ? 8 : 5;
+            match.score = score;
+            found.push_back(match);
+        };
+
+        size_t limit = static_cast<size_t>(settings.max_suggestions);
+        if (settings.fuzzy_matching && !name_prefix.empty()) {
+            FuzzyMatcher matcher(name_prefix, settings.case_sensitive);
+            for (const auto& ranked : matcher.rank(listing->names, listing->masks, limit * 2)) {
+                if (!directories_only || listing->is_directory[ranked.index]) {
+                    add(ranked.index, ranked.score);
+                }
+            }
+            return found;
+        }
+
+        // Directories sort ahead of files, so no more than `limit` of each
+        // can survive filter_matches
+        size_t directories = 0;
+        size_t files = 0;
+        auto range = listing->prefix_range(name_prefix);
+        for (size_t i = range.first; i < range.second; ++i) {
+            if (settings.case_sensitive && listing->names[i].compare(0, name_prefix.size(), name_prefix) != 0) {
+                continue;
+            }
+            size_t& count = listing->is_directory[i] ? directories : files;
+            if (count >= limit || (directories_only && !listing->is_directory[i])) {
+                continue;
+            }
+            ++count;
+            add(i, 0);
+            if (directories >= limit && (directories_only || files >= limit)) {
+                break;
+            }
+        }
+        return found;
+    }
+
+    static std::vector<CompletionMatch> filter_matches(const std::vector<CompletionMatch>& matches,
+                                                       size_t max_suggestions) {
         std::vector<CompletionMatch> filtered = matches;
         
         // Sort by priority and alphabetically
         std::sort(filtered.begin(), filtered.end(), [](const CompletionMatch& a, const CompletionMatch& b) {
             if (a.priority != b.priority) return a.priority > b.priority;
+            if (a.score != b.score) return a.score > b.score;
             return a.text < b.text;
         });
         
         // Limit to max_suggestions
-        if (filtered.size() > static_cast<size_t>(max_suggestions)) {
+        if (filtered.size() > max_suggestions) {
             filtered.resize(max_suggestions);
         }
         
@@ -129,19 +236,156 @@ bool TabCompletion::initialize() {
     return true;
 }
 
+namespace {
+
+std::vector<CompletionMatch> call_provider(ICompletionProvider& provider, const CompletionContext& context) {
+    try {
+        return provider.get_completions(context);
+    } catch (...) {
+        return {};  // a failing provider contributes nothing
+    }
+}
+
+} // anonymous namespace
+
 std::vector<CompletionMatch> TabCompletion::complete(const std::string& line, int cursor_position) {
-    std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    
-    CompletionContext ctx = pimpl_->parse_context(line, cursor_position);
+    std::vector<std::shared_ptr<ICompletionProvider>> providers;
+    std::chrono::milliseconds deadline;
+    CompletionSettings settings;
+    {
+        // Held only for the snapshot: providers run without it
+        std::lock_guard<std::mutex> lock(pimpl_->mutex);
+        providers = pimpl_->providers;
+        deadline = pimpl_->deadline;
+        settings = pimpl_->settings;
+    }
+
+    uint64_t generation = ++pimpl_->generation;
+    auto batch = std::make_shared<Impl::FastBatch>();
+    batch->context = pimpl_->parse_context(line, cursor_position);
+    batch->context.settings = settings;
+    batch->context.is_stale = [impl = pimpl_.get(), generation] { return impl->generation.load() != generation; };
+    batch->deadline = std::chrono::steady_clock::now() + deadline;
+
+    auto round = std::make_shared<Impl::Round>();
+    round->outstanding = providers.size();
+
+    for (const auto& provider : providers) {
+        if (provider->may_block()) {
+            pimpl_->dispatch_blocking(provider, batch->context, round);
+        }
+        else {
+            batch->providers.push_back(provider);
+        }
+    }
+
+    // Fast providers run on pool workers while this thread waits
+    for (size_t i = 0; i < batch->providers.size(); ++i) {
+        WorkerPool::instance().submit([batch, round] { Impl::run_fast(batch, round, false); });
+    }
+
     std::vector<CompletionMatch> all_matches;
-    
-    // Get completions from all providers
-    for (const auto& provider : pimpl_->providers) {
-        auto matches = provider->get_completions(ctx);
-        all_matches.insert(all_matches.end(), matches.begin(), matches.end());
+    {
+        std::unique_lock<std::mutex> lock(round->mutex);
+        round->done.wait_until(lock, batch->deadline, [&round] { return round->outstanding == 0; });
+    }
+    // Providers no worker has picked up (the pool is busy with jobs) are
+    // local and quick, so run them here rather than return nothing
+    Impl::run_fast(batch, round, true);
+    {
+        std::lock_guard<std::mutex> lock(round->mutex);
+        round->closed = true;
+        all_matches.swap(round->matches);
+    }
+
+    return Impl::filter_matches(all_matches, static_cast<size_t>(settings.max_suggestions));
+}
+
+void TabCompletion::Impl::dispatch_blocking(const std::shared_ptr<ICompletionProvider>& provider,
+                                            const CompletionContext& context,
+                                            const std::shared_ptr<Round>& round) {
+    std::shared_ptr<BlockingSlot> slot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& entry = blocking_slots[provider->get_name()];
+        if (!entry) {
+            entry = std::make_shared<BlockingSlot>();
+        }
+        slot = entry;
+    }
+
+    std::function<void()> request = [provider, context, round] {
+        if (context.is_stale()) {
+            round->deliver({});  // the user kept typing; never started
+            return;
+        }
+        round->deliver(call_provider(*provider, context));
+    };
+
+    std::function<void()> dropped;
+    {
+        std::lock_guard<std::mutex> lock(slot->mutex);
+        if (slot->running) {
+            // Only the newest request waits behind the one in flight
+            dropped = std::move(slot->queued);
+            slot->queued = std::move(request);
+        }
+        else {
+            // The previous runner has finished its last request
+            if (slot->runner.joinable()) {
+                slot->runner.join();
+            }
+            slot->running = true;
+            slot->runner = std::thread([slot, request]() mutable {
+                while (request) {
+                    request();
+                    std::lock_guard<std::mutex> lock(slot->mutex);
+                    request = std::move(slot->queued);
+                    slot->queued = nullptr;
+                    if (!request) {
+                        slot->running = false;
+                    }
+                }
+            });
+        }
+    }
+    if (dropped) {
+        dropped();  // stale by now, so it only reports back
+    }
+}
+
+void TabCompletion::Impl::join_runners() {
+    std::vector<std::shared_ptr<BlockingSlot>> slots;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& pair : blocking_slots) {
+            slots.push_back(pair.second);
+        }
+    }
+    for (const auto& slot : slots) {
+        std::thread runner;
+        {
+            std::lock_guard<std::mutex> lock(slot->mutex);
+            runner = std::move(slot->runner);
+        }
+        if (runner.joinable()) {
+            runner.join();
+        }
+    }
+}
+
+void TabCompletion::Impl::run_fast(const std::shared_ptr<FastBatch>& batch, const std::shared_ptr<Round>& round,
+                                   bool late) {
+    // Claim providers until none are left. Workers skip the ones they
+    // reach after the deadline; the caller's late pass runs them.
+    size_t index;
+    while ((index = batch->next.fetch_add(1)) < batch->providers.size()) {
+        if (!late && std::chrono::steady_clock::now() >= batch->deadline) {
+            round->deliver({});
+            continue;
+        }
+        round->deliver(call_provider(*batch->providers[index], batch->context));
     }
-    
-    return pimpl_->filter_matches(all_matches);
 }
 
 std::string TabCompletion::complete_single(const std::string& line, int cursor_position) {
@@ -152,6 +396,15 @@ std::string TabCompletion::complete_single(const std::string& line, int cursor_p
     return "";
 }
 
+void TabCompletion::set_command_registry(const CommandRegistry* registry) {
+    pimpl_->registry.store(registry);
+}
+
+void TabCompletion::shutdown() {
+    ++pimpl_->generation;  // queued requests see themselves as stale
+    pimpl_->join_runners();
+}
+
 bool TabCompletion::register_provider(std::shared_ptr<ICompletionProvider> provider) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
     pimpl_->providers.push_back(provider);
@@ -171,99 +424,41 @@ bool TabCompletion::unregister_provider(const std::string& name) {
     return false;
 }
 
-std::vector<CompletionMatch> TabCompletion::complete_commands(const std::string& prefix) {
-    // TODO: Get commands from registry
+std::vector<CompletionMatch> TabCompletion::complete_commands(const std::string& prefix,
+                                                              const CompletionSettings& settings) {
     std::vector<CompletionMatch> matches;
-    
-    std::vector<std::string> commands = {
-        "help", "version", "exit", "quit", "clear", "cls", "whoami",
-        "login", "logout", "create-user", "adduser",
-        "vault-init", "vault-unlock", "vault-lock", "vault-add", "vault-get", "vault-list", "vault-delete", "vault-search",
-        "git", "git-status", "git-add", "git-commit", "git-push", "git-pull", "git-branch", "git-checkout", "git-log",
-        "db", "db-connect", "db-query", "db-list-tables", "db-export", "db-import",
-        "net-interfaces", "net-stats", "net-capture", "net-stop", "net-packets", "net-protocols",
-        "monitor-start", "monitor-stats", "proc-list", "proc-kill",
-        "note-add", "note-list", "note-get", "snippet-add", "snippet-get", "snippet-search",
-        "env-create", "env-switch", "env-list",
-        "task-schedule", "task-list", "task-cancel",
-        "remind", "remind-list", "remind-dismiss",
-        "p2p-start", "p2p-share", "p2p-list", "p2p-unshare",
-        "ai-init", "ai-suggest", "ai-completion-stats",
-        "theme-list", "theme-set", "theme-create",
-        "ssh-start", "ssh-stop", "ssh-connections",
-        "container-list", "container-start", "container-stop", "image-pull", "image-build",
-        "docker-init", "docker-ps",
-        "mobile-api-start", "mobile-api-stop", "mobile-api-status",
-        "remote-desktop-start", "remote-desktop-sessions",
-        "remote-desktop-terminals", "remote-desktop-switch", "remote-desktop-capture-terminal",
-        "remote-desktop-displays", "remote-desktop-fullscreen", "remote-desktop-set-display",
-        "remote-desktop-windows",
-        "analytics-dashboard", "analytics-insights", "analytics-metrics"
-    };
-    
-    for (const auto& cmd : commands) {
-        if (pimpl_->matches(cmd, prefix)) {
-            CompletionMatch match;
-            match.text = cmd;
-            match.description = "Command";
-            match.priority = 10;
-            matches.push_back(match);
-        }
+
+    // Command names are lower case, so a case-insensitive match only needs
+    // the prefix folded
+    std::string key = prefix;
+    if (!settings.case_sensitive) {
+        std::transform(key.begin(), key.end(), key.begin(), ::tolower);
     }
-    
-    return matches;
-}
 
-std::vector<CompletionMatch> TabCompletion::complete_files(const std::string& prefix) {
-    std::vector<CompletionMatch> matches;
-    
-    try {
-        fs::path search_path = prefix.empty() ? "." : prefix;
-        fs::path dir = search_path.parent_path();
-        if (dir.empty()) dir = ".";
-        
-        for (const auto& entry : fs::directory_iterator(dir)) {
-            std::string filename = entry.path().filename().string();
-            if (pimpl_->matches(filename, prefix)) {
-                CompletionMatch match;
-                match.text = entry.path().string();
-                match.description = entry.is_directory() ? "Directory" : "File";
-                match.priority = entry.is_directory() ? 8 : 5;
-                matches.push_back(match);
-            }
-        }
-    } catch (...) {
-        // Ignore errors
+    const CommandRegistry* registry = pimpl_->registry.load();
+    if (!registry) {
+        return matches;
     }
-    
+    for (const auto& name : registry->suggest_commands(key, static_cast<size_t>(settings.max_suggestions))) {
+        const CommandInfo* info = registry->get_command(name);
+        CompletionMatch match;
+        match.text = name;
+        match.description = info && !info->description.empty() ? info->description : "Command";
+        match.priority = 10;
+        matches.push_back(match);
+    }
+
     return matches;
 }
 
-std::vector<CompletionMatch> TabCompletion::complete_directories(const std::string& prefix) {
-    std::vector<CompletionMatch> matches;
-    
-    try {
-        fs::path search_path = prefix.empty() ? "." : prefix;
-        fs::path dir = search_path.parent_path();
-        if (dir.empty()) dir = ".";
-        
-        for (const auto& entry : fs::directory_iterator(dir)) {
-            if (entry.is_directory()) {
-                std::string dirname = entry.path().filename().string();
-                if (pimpl_->matches(dirname, prefix)) {
-                    CompletionMatch match;
-                    match.text = entry.path().string();
-                    match.description = "Directory";
-                    match.priority = 8;
-                    matches.push_back(match);
-                }
-            }
-        }
-    } catch (...) {
-        // Ignore errors
-    }
-    
-    return matches;
+std::vector<CompletionMatch> TabCompletion::complete_files(const std::string& prefix,
+                                                           const CompletionSettings& settings) {
+    return Impl::complete_paths(prefix, false, settings);
+}
+
+std::vector<CompletionMatch> TabCompletion::complete_directories(const std::string& prefix,
+                                                                 const CompletionSettings& settings) {
+    return Impl::complete_paths(prefix, true, settings);
 }
 
 std::vector<CompletionMatch> TabCompletion::complete_users(const std::string& prefix) {
@@ -278,12 +473,13 @@ std::vector<CompletionMatch> TabCompletion::complete_environment_vars(const std:
     return {};
 }
 
-std::vector<CompletionMatch> TabCompletion::complete_git_branches(const std::string& prefix) {
+std::vector<CompletionMatch> TabCompletion::complete_git_branches(const std::string& prefix,
+                                                                  const CompletionSettings& settings) {
     std::vector<CompletionMatch> matches;
     
     auto branches = git::GitManager::instance().list_branches(false);
     for (const auto& branch : branches) {
-        if (pimpl_->matches(branch.name, prefix)) {
+        if (Impl::matches(branch.name, prefix, settings.case_sensitive)) {
             CompletionMatch match;
             match.text = branch.name;
             match.description = branch.is_current ? "Current branch" : "Branch";
@@ -296,13 +492,14 @@ std::vector<CompletionMatch> TabCompletion::complete_git_branches(const std::str
     return matches;
 }
 
-std::vector<CompletionMatch> TabCompletion::complete_db_tables(const std::string& prefix) {
+std::vector<CompletionMatch> TabCompletion::complete_db_tables(const std::string& prefix,
+                                                               const CompletionSettings& settings) {
     std::vector<CompletionMatch> matches;
     
 #ifdef HAVE_SQLITE3
     auto tables = database::DBManager::instance().list_tables();
     for (const auto& table : tables) {
-        if (pimpl_->matches(table, prefix)) {
+        if (Impl::matches(table, prefix, settings.case_sensitive)) {
             CompletionMatch match;
             match.text = table;
             match.description = "Table";
@@ -316,13 +513,14 @@ std::vector<CompletionMatch> TabCompletion::complete_db_tables(const std::string
     return matches;
 }
 
-std::vector<CompletionMatch> TabCompletion::complete_db_columns(const std::string& table, const std::string& prefix) {
+std::vector<CompletionMatch> TabCompletion::complete_db_columns(const std::string& table, const std::string& prefix,
+                                                                const CompletionSettings& settings) {
     std::vector<CompletionMatch> matches;
     
 #ifdef HAVE_SQLITE3
     auto columns = database::DBManager::instance().list_columns(table);
     for (const auto& column : columns) {
-        if (pimpl_->matches(column, prefix)) {
+        if (Impl::matches(column, prefix, settings.case_sensitive)) {
             CompletionMatch match;
             match.text = column;
             match.description = "Column";
@@ -345,17 +543,22 @@ std::vector<CompletionMatch> TabCompletion::complete_plugins(const std::string&
 
 void TabCompletion::set_case_sensitive(bool sensitive) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    pimpl_->case_sensitive = sensitive;
+    pimpl_->settings.case_sensitive = sensitive;
 }
 
 void TabCompletion::set_fuzzy_matching(bool enabled) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    pimpl_->fuzzy_matching = enabled;
+    pimpl_->settings.fuzzy_matching = enabled;
 }
 
 void TabCompletion::set_max_suggestions(int max) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    pimpl_->max_suggestions = max;
+    pimpl_->settings.max_suggestions = max;
+}
+
+void TabCompletion::set_deadline(std::chrono::milliseconds deadline) {
+    std::lock_guard<std::mutex> lock(pimpl_->mutex);
+    pimpl_->deadline = deadline;
 }
 
 void TabCompletion::add_to_history(const std::string& command) {
@@ -370,8 +573,22 @@ std::vector<CompletionMatch> TabCompletion::complete_from_history(const std::str
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
     
     std::vector<CompletionMatch> matches;
+    const CompletionSettings& settings = pimpl_->settings;
+    if (settings.fuzzy_matching && !prefix.empty()) {
+        FuzzyMatcher matcher(prefix, settings.case_sensitive);
+        for (const auto& ranked : matcher.rank(pimpl_->history, static_cast<size_t>(settings.max_suggestions))) {
+            CompletionMatch match;
+            match.text = pimpl_->history[ranked.index];
+            match.description = "From history";
+            match.priority = 6;
+            match.score = ranked.score;
+            matches.push_back(match);
+        }
+        return matches;
+    }
+
     for (const auto& cmd : pimpl_->history) {
-        if (pimpl_->matches(cmd, prefix)) {
+        if (Impl::matches(cmd, prefix, settings.case_sensitive)) {
             CompletionMatch match;
             match.text = cmd;
             match.description = "From history";
@@ -389,7 +606,6 @@ void TabCompletion::enable_smart_completion(bool enabled) {
 }
 
 std::vector<CompletionMatch> TabCompletion::get_smart_suggestions(const CompletionContext& context) {
-    std::lock_guard<std::mutex> lock(pimpl_->mutex);
     std::vector<CompletionMatch> suggestions;
 
     // Get AI suggestions
@@ -414,25 +630,22 @@ std::vector<CompletionMatch> TabCompletion::get_ai_suggestions(const CompletionC
         return suggestions;
     }
 
-    // Create cache key from context
-    std::string cache_key = context.line.substr(0, context.cursor_position);
-    cache_key += "|" + context.current_directory;
-
-    // Check cache first (5 minute expiry)
-    auto now = std::chrono::system_clock::now();
-    if (pimpl_->ai_cache.count(cache_key)) {
-        auto& cached = pimpl_->ai_cache[cache_key];
-        auto age = now - cached.timestamp;
-        if (std::chrono::duration_cast<std::chrono::minutes>(age).count() < 5) {
-            for (const auto& suggestion : cached.suggestions) {
-                CompletionMatch match;
-                match.text = suggestion;
-                match.description = "🤖 AI suggestion";
-                match.priority = 15;  // High priority for AI
-                suggestions.push_back(match);
-            }
-            return suggestions;
+    std::string typed = context.line.substr(0, context.cursor_position);
+    std::vector<std::string> cached;
+    if (pimpl_->ai_cache.find(typed, context.current_directory, cached)) {
+        for (const auto& suggestion : cached) {
+            CompletionMatch match;
+            match.text = suggestion;
+            match.description = "🤖 AI suggestion";
+            match.priority = 15;  // High priority for AI
+            suggestions.push_back(match);
         }
+        return suggestions;
+    }
+
+    // Not worth a round-trip if the user has typed on since
+    if (context.is_stale && context.is_stale()) {
+        return suggestions;
     }
 
     // Get AI suggestions from Gemini
@@ -477,6 +690,7 @@ std::vector<CompletionMatch> TabCompletion::get_ai_suggestions(const CompletionC
         auto response = ai::GeminiClient::instance().generate_content(prompt);
 
         if (response.success && !response.content.empty()) {
+            std::vector<std::string> lines;
             std::istringstream iss(response.content);
             std::string line;
             while (std::getline(iss, line) && suggestions.size() < 5) {
@@ -493,14 +707,13 @@ std::vector<CompletionMatch> TabCompletion::get_ai_suggestions(const CompletionC
                     match.description = "🤖 AI suggestion";
                     match.priority = 15;  // High priority for AI
                     suggestions.push_back(match);
-
-                    // Cache the suggestion
-                    pimpl_->ai_cache[cache_key].suggestions.push_back(line);
+                    lines.push_back(line);
                 }
             }
 
-            if (!suggestions.empty()) {
-                pimpl_->ai_cache[cache_key].timestamp = now;
+            // Cached even when stale, for the next Tab on this line
+            if (!lines.empty()) {
+                pimpl_->ai_cache.store(typed, context.current_directory, lines);
             }
         }
     } catch (...) {
@@ -512,38 +725,30 @@ std::vector<CompletionMatch> TabCompletion::get_ai_suggestions(const CompletionC
 
 std::vector<CompletionMatch> TabCompletion::get_learned_suggestions(const CompletionContext& context) {
     std::vector<CompletionMatch> suggestions;
-
-    if (context.words.empty()) return suggestions;
-
-    std::string current_cmd = context.words[0];
     std::string partial = context.partial_word;
 
-    // Find patterns for current command
-    if (pimpl_->command_patterns.count(current_cmd)) {
-        const auto& pattern = pimpl_->command_patterns[current_cmd];
-
-        // Suggest common arguments
-        for (const auto& arg_pair : pattern.argument_patterns) {
-            if (arg_pair.first.find(partial) != std::string::npos && arg_pair.second > 2) {
-                CompletionMatch match;
-                match.text = arg_pair.first;
-                match.description = "📊 Learned argument (" + std::to_string(arg_pair.second) + " uses)";
-                match.priority = 12;
-                suggestions.push_back(match);
-            }
+    std::lock_guard<std::mutex> lock(pimpl_->data_mutex);
+
+    if (context.words.empty() || context.word_index == 0) {
+        // Commands that tend to follow the ones just run
+        for (const auto& prediction : pimpl_->model.predict_next(partial, 5)) {
+            CompletionMatch match;
+            match.text = prediction.text;
+            match.description = "🔄 Workflow suggestion";
+            match.priority = 11;
+            suggestions.push_back(match);
         }
+        return suggestions;
     }
 
-    // Suggest next commands in workflow
-    if (pimpl_->workflow_sequences.count(current_cmd)) {
-        for (const auto& next_cmd : pimpl_->workflow_sequences[current_cmd]) {
-            if (next_cmd.find(partial) == 0) {
-                CompletionMatch match;
-                match.text = next_cmd;
-                match.description = "🔄 Workflow suggestion";
-                match.priority = 11;
-                suggestions.push_back(match);
-            }
+    // Suggest common arguments
+    for (const auto& prediction : pimpl_->model.predict_arguments(context.words[0], partial, 5)) {
+        if (prediction.count > 2) {
+            CompletionMatch match;
+            match.text = prediction.text;
+            match.description = "📊 Learned argument (" + std::to_string(prediction.count) + " uses)";
+            match.priority = 12;
+            suggestions.push_back(match);
         }
     }
 
@@ -552,28 +757,25 @@ std::vector<CompletionMatch> TabCompletion::get_learned_suggestions(const Comple
 
 std::vector<CompletionMatch> TabCompletion::get_context_suggestions(const CompletionContext& context) {
     std::vector<CompletionMatch> suggestions;
+    if (!context.words.empty() && context.word_index > 0) {
+        return suggestions;
+    }
 
     // Get current time context
     auto now = std::chrono::system_clock::now();
     auto time_t = std::chrono::system_clock::to_time_t(now);
     std::tm tm = *std::localtime(&time_t);
-    int hour = tm.tm_hour;
-    std::string time_context = std::to_string(hour);
-
-    // Get day context
-    std::string day_context = (tm.tm_wday == 0 || tm.tm_wday == 6) ? "weekend" : "weekday";
-
-    // Find time-based patterns
-    if (pimpl_->time_based_patterns.count(time_context)) {
-        // Suggest commands commonly used at this time
-        for (const auto& pattern : pimpl_->command_patterns) {
-            if (pattern.second.frequency > 3 && context.partial_word.empty()) {
-                CompletionMatch match;
-                match.text = pattern.first;
-                match.description = "⏰ Time-based suggestion";
-                match.priority = 10;
-                suggestions.push_back(match);
-            }
+
+    std::lock_guard<std::mutex> lock(pimpl_->data_mutex);
+
+    // Commands commonly used at this hour
+    for (const auto& prediction : pimpl_->model.predict_for_hour(tm.tm_hour, context.partial_word, 5)) {
+        if (prediction.count > 3) {
+            CompletionMatch match;
+            match.text = prediction.text;
+            match.description = "⏰ Time-based suggestion";
+            match.priority = 10;
+            suggestions.push_back(match);
         }
     }
 
@@ -581,121 +783,57 @@ std::vector<CompletionMatch> TabCompletion::get_context_suggestions(const Comple
 }
 
 void TabCompletion::learn_from_command(const std::string& command, const std::string& previous_command) {
-    std::lock_guard<std::mutex> lock(pimpl_->mutex);
-
     if (command.empty()) return;
 
     auto now = std::chrono::system_clock::now();
+    auto time_t = std::chrono::system_clock::to_time_t(now);
+    std::tm tm = *std::localtime(&time_t);
 
-    // Parse command
-    std::istringstream iss(command);
-    std::vector<std::string> words;
-    std::string word;
-    while (iss >> word) {
-        words.push_back(word);
-    }
-
-    if (words.empty()) return;
-
-    std::string cmd = words[0];
-
-    // Update command pattern
-    if (!pimpl_->command_patterns.count(cmd)) {
-        pimpl_->command_patterns[cmd] = Impl::CommandPattern{cmd, "", 0, now};
-    }
+    std::lock_guard<std::mutex> lock(pimpl_->data_mutex);
+    pimpl_->model.learn(command, previous_command, tm.tm_hour);
+}
 
-    auto& pattern = pimpl_->command_patterns[cmd];
-    pattern.frequency++;
-    pattern.last_used = now;
+void TabCompletion::set_learning_path(const std::string& base_path) {
+    std::lock_guard<std::mutex> lock(pimpl_->data_mutex);
+    pimpl_->learning_path = base_path;
+}
 
-    // Learn arguments
-    if (words.size() > 1) {
-        std::string args = command.substr(cmd.length());
-        args.erase(args.begin(), std::find_if(args.begin(), args.end(), [](int ch) { return !std::isspace(ch); }));
-        if (!args.empty()) {
-            pattern.argument_patterns[args]++;
-        }
+void TabCompletion::load_learning_data() {
+    std::lock_guard<std::mutex> lock(pimpl_->data_mutex);
+    if (!pimpl_->model.open(pimpl_->learning_path)) {
+        // Still learns in memory; the snapshot is written on exit
     }
-
-    // Learn workflow sequences
-    if (!previous_command.empty()) {
-        std::istringstream prev_iss(previous_command);
-        std::string prev_cmd;
-        prev_iss >> prev_cmd;
-
-        if (!prev_cmd.empty()) {
-            pimpl_->workflow_sequences[prev_cmd].push_back(cmd);
-
-            // Keep only most common next commands (limit to 10)
-            if (pimpl_->workflow_sequences[prev_cmd].size() > 10) {
-                // Sort by frequency and keep top 10
-                std::unordered_map<std::string, int> freq;
-                for (const auto& next : pimpl_->workflow_sequences[prev_cmd]) {
-                    freq[next]++;
-                }
-
-                std::vector<std::pair<std::string, int>> sorted(freq.begin(), freq.end());
-                std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
-                    return a.second > b.second;
-                });
-
-                pimpl_->workflow_sequences[prev_cmd].clear();
-                for (size_t i = 0; i < std::min(size_t(10), sorted.size()); ++i) {
-                    pimpl_->workflow_sequences[prev_cmd].push_back(sorted[i].first);
-                }
-            }
-        }
+    fs::path cache_path = fs::path(pimpl_->learning_path).parent_path() / "ai_suggestions.cache";
+    if (!pimpl_->ai_cache.open(cache_path.string())) {
+        // Memory-only for this session
     }
+}
 
-    // Learn time-based patterns
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm = *std::localtime(&time_t);
-    std::string hour_key = std::to_string(tm.tm_hour);
-    pimpl_->time_based_patterns[hour_key]++;
-
-    // Store in database for persistence
-    try {
-        auto& db = database::InternalDB::instance();
-        db.add_analytics_data("command_usage_" + cmd, 1.0, "count",
-                             "{\"hour\": " + std::to_string(tm.tm_hour) + ", \"day\": " + std::to_string(tm.tm_wday) + "}");
-    } catch (...) {
-        // Ignore database errors
+std::vector<std::pair<std::string, uint32_t>> TabCompletion::learned_command_counts(size_t limit) {
+    std::lock_guard<std::mutex> lock(pimpl_->data_mutex);
+    std::vector<std::pair<std::string, uint32_t>> counts;
+    for (auto& prediction : pimpl_->model.top_commands(limit)) {
+        counts.emplace_back(std::move(prediction.text), prediction.count);
     }
+    return counts;
 }
 
-void TabCompletion::load_learning_data() {
-    try {
-        auto& db = database::InternalDB::instance();
-        auto analytics = db.get_analytics_data("command_usage_", 1000);
-
-        for (const auto& data : analytics) {
-            if (data.count("metric_name") && data.at("metric_name").find("command_usage_") == 0) {
-                std::string cmd = data.at("metric_name").substr(14); // Remove "command_usage_" prefix
-                if (!pimpl_->command_patterns.count(cmd)) {
-                    pimpl_->command_patterns[cmd] = Impl::CommandPattern{cmd, "", 0, std::chrono::system_clock::now()};
-                }
-                if (data.count("value")) {
-                    pimpl_->command_patterns[cmd].frequency += static_cast<int>(std::stod(data.at("value")));
-                }
-            }
-        }
-    } catch (...) {
-        // Ignore loading errors
-    }
+SuggestionCache::Stats TabCompletion::ai_cache_stats() const {
+    return pimpl_->ai_cache.stats();
 }
 
 // Built-in providers implementation
 
 std::vector<CompletionMatch> CommandCompletionProvider::get_completions(const CompletionContext& context) {
     if (context.word_index == 0) {
-        return TabCompletion::instance().complete_commands(context.partial_word);
+        return TabCompletion::instance().complete_commands(context.partial_word, context.settings);
     }
     return {};
 }
 
 std::vector<CompletionMatch> FileCompletionProvider::get_completions(const CompletionContext& context) {
     if (context.word_index > 0) {
-        return TabCompletion::instance().complete_files(context.partial_word);
+        return TabCompletion::instance().complete_files(context.partial_word, context.settings);
     }
     return {};
 }
@@ -724,7 +862,7 @@ std::vector<CompletionMatch> GitCompletionProvider::get_completions(const Comple
         }
         else if (context.words.size() > 1 && (context.words[1] == "checkout" || context.words[1] == "branch")) {
             // Complete branch names
-            return TabCompletion::instance().complete_git_branches(context.partial_word);
+            return TabCompletion::instance().complete_git_branches(context.partial_word, context.settings);
         }
     }
     return {};
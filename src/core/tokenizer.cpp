@@ -0,0 +1,254 @@
+#include "core/tokenizer.h"
+
+namespace customos {
+namespace core {
+
+namespace {
+
+// Characters that end a run of plain word characters
+inline bool is_special(char c) {
+    switch (c) {
+        case ' ': case '\t': case '\r': case '\n':
+        case '|': case '&': case '<': case '>':
+        case '\\': case '\'': case '"': case '$':
+            return true;
+        default:
+            return false;
+    }
+}
+
+inline bool is_name_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+inline bool is_name_char(char c) {
+    return is_name_start(c) || (c >= '0' && c <= '9');
+}
+
+std::string_view operator_text(TokenType type) {
+    switch (type) {
+        case TokenType::PIPE: return "|";
+        case TokenType::REDIRECT_IN: return "<";
+        case TokenType::REDIRECT_OUT: return ">";
+        case TokenType::REDIRECT_APPEND: return ">>";
+        case TokenType::BACKGROUND: return "&";
+        default: return "";
+    }
+}
+
+} // anonymous namespace
+
+void Tokenizer::begin_word() {
+    if (!in_word_) {
+        in_word_ = true;
+        word_start_ = arena_.size();
+    }
+}
+
+void Tokenizer::end_word() {
+    if (in_word_) {
+        spans_.push_back({TokenType::WORD, word_start_, arena_.size() - word_start_});
+        in_word_ = false;
+    }
+}
+
+void Tokenizer::push_operator(TokenType type) {
+    end_word();
+    spans_.push_back({type, 0, 0});
+}
+
+size_t Tokenizer::expand_variable(std::string_view line, size_t dollar, const VariableLookup& lookup) {
+    // Returns the index just past the variable reference. A '$' that does
+    // not start a valid reference is kept literally.
+    size_t i = dollar + 1;
+    std::string_view name;
+    size_t next;
+
+    if (i < line.size() && line[i] == '{') {
+        size_t close = line.find('}', i + 1);
+        if (close == std::string_view::npos || close == i + 1) {
+            arena_.push_back('$');
+            return i;
+        }
+        name = line.substr(i + 1, close - i - 1);
+        next = close + 1;
+    }
+    else if (i < line.size() && is_name_start(line[i])) {
+        size_t end = i + 1;
+        while (end < line.size() && is_name_char(line[end])) {
+            ++end;
+        }
+        name = line.substr(i, end - i);
+        next = end;
+    }
+    else {
+        arena_.push_back('$');
+        return i;
+    }
+
+    std::string_view value;
+    if (lookup && lookup(name, value)) {
+        arena_.append(value.data(), value.size());
+    }
+    return next;
+}
+
+bool Tokenizer::tokenize(std::string_view line, const VariableLookup& lookup) {
+    arena_.clear();
+    spans_.clear();
+    tokens_.clear();
+    error_.clear();
+    in_word_ = false;
+
+    // Unescaped text is never longer than the input; only expansions grow it
+    if (arena_.capacity() < line.size()) {
+        arena_.reserve(line.size());
+    }
+
+    size_t i = 0;
+    const size_t n = line.size();
+
+    while (i < n) {
+        char c = line[i];
+        switch (c) {
+            case ' ': case '\t': case '\r': case '\n':
+                end_word();
+                ++i;
+                break;
+
+            case '|':
+                push_operator(TokenType::PIPE);
+                ++i;
+                break;
+
+            case '&':
+                push_operator(TokenType::BACKGROUND);
+                ++i;
+                break;
+
+            case '<':
+                push_operator(TokenType::REDIRECT_IN);
+                ++i;
+                break;
+
+            case '>':
+                if (i + 1 < n && line[i + 1] == '>') {
+                    push_operator(TokenType::REDIRECT_APPEND);
+                    i += 2;
+                }
+                else {
+                    push_operator(TokenType::REDIRECT_OUT);
+                    ++i;
+                }
+                break;
+
+            case '\\':
+                begin_word();
+                if (i + 1 < n) {
+                    arena_.push_back(line[i + 1]);
+                    i += 2;
+                }
+                else {
+                    arena_.push_back('\\');
+                    ++i;
+                }
+                break;
+
+            case '\'': {
+                size_t close = line.find('\'', i + 1);
+                begin_word();
+                if (close == std::string_view::npos) {
+                    arena_.push_back('\'');
+                    ++i;
+                    break;
+                }
+                arena_.append(line.data() + i + 1, close - i - 1);
+                i = close + 1;
+                break;
+            }
+
+            case '"': {
+                // Find the closing quote first so an unmatched one stays literal
+                size_t close = i + 1;
+                while (close < n && line[close] != '"') {
+                    close += (line[close] == '\\') ? 2 : 1;
+                }
+                begin_word();
+                if (close >= n) {
+                    arena_.push_back('"');
+                    ++i;
+                    break;
+                }
+
+                size_t j = i + 1;
+                while (j < close) {
+                    char d = line[j];
+                    if (d == '\\' && j + 1 < close &&
+                        (line[j + 1] == '"' || line[j + 1] == '\\' || line[j + 1] == '$' || line[j + 1] == '`')) {
+                        arena_.push_back(line[j + 1]);
+                        j += 2;
+                    }
+                    else if (d == '$') {
+                        j = expand_variable(line.substr(0, close), j, lookup);
+                    }
+                    else {
+                        arena_.push_back(d);
+                        ++j;
+                    }
+                }
+                i = close + 1;
+                break;
+            }
+
+            case '$':
+                begin_word();
+                i = expand_variable(line, i, lookup);
+                break;
+
+            default: {
+                // Copy the whole run of plain characters at once
+                begin_word();
+                size_t end = i + 1;
+                while (end < n && !is_special(line[end])) {
+                    ++end;
+                }
+                arena_.append(line.data() + i, end - i);
+                i = end;
+                break;
+            }
+        }
+    }
+    end_word();
+
+    // The arena no longer grows; hand out views into it
+    tokens_.reserve(spans_.size());
+    for (const auto& span : spans_) {
+        if (span.type == TokenType::WORD) {
+            tokens_.push_back({span.type, std::string_view(arena_.data() + span.offset, span.length)});
+        }
+        else {
+            tokens_.push_back({span.type, operator_text(span.type)});
+        }
+    }
+
+    // Operators must be followed by what they operate on
+    for (size_t t = 0; t < tokens_.size(); ++t) {
+        TokenType type = tokens_[t].type;
+        bool needs_word = type == TokenType::REDIRECT_IN || type == TokenType::REDIRECT_OUT ||
+                          type == TokenType::REDIRECT_APPEND;
+        if (needs_word && (t + 1 == tokens_.size() || tokens_[t + 1].type != TokenType::WORD)) {
+            error_ = "expected a file name after '" + std::string(tokens_[t].text) + "'";
+            return false;
+        }
+        // No command separators: '&' may only end the line
+        if (type == TokenType::BACKGROUND && t + 1 != tokens_.size()) {
+            error_ = "'&' is only allowed at the end of a command";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace core
+} // namespace customos
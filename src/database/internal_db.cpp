@@ -1,7 +1,9 @@
 #include "database/internal_db.h"
+#include "logging/logger.h"
 #include <sqlite3.h>
 #include <mutex>
 #include <sstream>
+#include <ctime>
 
 namespace customos {
 namespace database {
@@ -10,6 +12,7 @@ struct InternalDB::Impl {
     sqlite3* db = nullptr;
     std::string db_path;
     bool initialized = false;
+    int transaction_depth = 0;
     std::mutex mutex;
 
     bool execute(const std::string& sql) {
@@ -1575,6 +1578,44 @@ bool InternalDB::add_history(const std::string& command, const std::string& user
     return rc == SQLITE_DONE;
 }
 
+bool InternalDB::add_history_batch(const std::vector<HistoryRow>& rows) {
+    std::lock_guard<std::mutex> lock(pimpl_->mutex);
+    if (!pimpl_->db) {
+        return false;
+    }
+    if (rows.empty()) {
+        return true;
+    }
+
+    // Inside a caller's transaction (batch mode) the rows simply join it
+    bool own_transaction = pimpl_->transaction_depth == 0;
+    if (own_transaction && !pimpl_->execute("BEGIN")) {
+        return false;
+    }
+
+    sqlite3_stmt* stmt;
+    const char* sql = "INSERT INTO history (command, user, timestamp) VALUES (?, ?, datetime(?, 'unixepoch'))";
+    bool ok = sqlite3_prepare_v2(pimpl_->db, sql, -1, &stmt, nullptr) == SQLITE_OK;
+    if (ok) {
+        for (const auto& row : rows) {
+            sqlite3_bind_text(stmt, 1, row.command.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, row.user.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int64(stmt, 3, row.timestamp);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                ok = false;
+                break;
+            }
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+    }
+
+    if (own_transaction) {
+        ok = pimpl_->execute(ok ? "COMMIT" : "ROLLBACK") && ok;
+    }
+    return ok;
+}
+
 std::vector<std::string> InternalDB::get_history(int limit) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
     
@@ -1803,29 +1844,67 @@ std::vector<std::string> InternalDB::get_active_sessions() {
     return {};
 }
 
-bool InternalDB::log_audit(const std::string& user, const std::string& action, const std::string& details) {
+bool InternalDB::log_audit(const std::string& user, const std::string& action, const std::string& details,
+                           logging::AuditEventType event_type, bool success) {
+    // Goes to the logger's audit journal, which commits entries in groups,
+    // rather than one INSERT (and transaction) per entry
+    logging::AuditEntry entry;
+    entry.event_type = event_type;
+    entry.user = user;
+    entry.action = action;
+    entry.success = success;
+    entry.timestamp = time(nullptr);
+    entry.details = details;
+    return logging::Logger::instance().audit(entry);
+}
+
+std::vector<std::string> InternalDB::get_audit_log(int limit) {
+    // Newest first, read through the journal's index
+    std::vector<std::string> result;
+    if (limit <= 0) {
+        return result;
+    }
+    for (const auto& record : logging::Logger::instance().read_audit_journal(static_cast<size_t>(limit))) {
+        char when[32];
+        std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", std::localtime(&record.entry.timestamp));
+        std::ostringstream line;
+        line << "#" << record.sequence << " " << when << " " << record.entry.user << " " << record.entry.action;
+        if (!record.entry.target.empty()) {
+            line << " " << record.entry.target;
+        }
+        if (!record.entry.details.empty()) {
+            line << " (" << record.entry.details << ")";
+        }
+        line << " [" << (record.entry.success ? "SUCCESS" : "FAILED") << "] " << record.hash.substr(0, 16);
+        result.push_back(line.str());
+    }
+    return result;
+}
+
+bool InternalDB::begin_transaction() {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    
-    sqlite3_stmt* stmt;
-    const char* sql = "INSERT INTO audit_log (user, action, details) VALUES (?, ?, ?)";
-    
-    if (sqlite3_prepare_v2(pimpl_->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    if (!pimpl_->db) {
         return false;
     }
-
-    sqlite3_bind_text(stmt, 1, user.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, action.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, details.c_str(), -1, SQLITE_TRANSIENT);
-    
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    return rc == SQLITE_DONE;
+    if (pimpl_->transaction_depth++ > 0) {
+        return true;
+    }
+    if (!pimpl_->execute("BEGIN")) {
+        pimpl_->transaction_depth = 0;
+        return false;
+    }
+    return true;
 }
 
-std::vector<std::string> InternalDB::get_audit_log(int limit) {
-    // TODO: Implement
-    return {};
+bool InternalDB::commit_transaction() {
+    std::lock_guard<std::mutex> lock(pimpl_->mutex);
+    if (!pimpl_->db || pimpl_->transaction_depth == 0) {
+        return false;
+    }
+    if (--pimpl_->transaction_depth > 0) {
+        return true;
+    }
+    return pimpl_->execute("COMMIT");
 }
 
 bool InternalDB::vacuum() {
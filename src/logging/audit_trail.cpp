@@ -1,9 +1,639 @@
-#include "logging/logger.h"
+#include "logging/audit_trail.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef HAVE_OPENSSL
+#include <openssl/sha.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
 
 namespace customos {
 namespace logging {
 
-// Audit trail implementation - extended functionality in logger.cpp
+namespace {
+
+const char MAGIC[4] = {'N', 'S', 'A', 'J'};
+const char VERSION = 1;
+const size_t HEADER_SIZE = sizeof(MAGIC) + 2;
+const size_t MAX_FIELD = 0xFFFF;
+// Sequence, timestamp, two flag bytes and four empty strings
+const size_t MIN_PAYLOAD = 2 * sizeof(uint64_t) + 2 + 4 * sizeof(uint16_t);
+const size_t MIN_RECORD = sizeof(uint32_t) + MIN_PAYLOAD + AuditJournal::HASH_SIZE;
+
+#ifdef HAVE_OPENSSL
+const char HASH_ALGORITHM = 1;  // SHA-256
+#else
+const char HASH_ALGORITHM = 2;  // FNV-1a fallback
+#endif
+
+// hash(previous | payload), HASH_SIZE bytes
+std::string chain_hash(const std::string& previous, const char* payload, size_t length) {
+    std::string input = previous;
+    input.append(payload, length);
+#ifdef HAVE_OPENSSL
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(input.data()), input.size(), hash);
+    return std::string(reinterpret_cast<const char*>(hash), sizeof(hash));
+#else
+    // Fallback when OpenSSL is not available: detects accidental damage,
+    // but is easy to forge (NOT SECURE)
+    std::string result;
+    for (uint64_t lane = 0; lane < AuditJournal::HASH_SIZE / 8; ++lane) {
+        uint64_t hash = 14695981039346656037ull ^ lane;
+        for (char c : input) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        result.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    }
+    return result;
+#endif
+}
+
+std::string to_hex(const std::string& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (unsigned char c : bytes) {
+        hex += digits[c >> 4];
+        hex += digits[c & 0x0F];
+    }
+    return hex;
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void put_text(std::string& out, const std::string& text) {
+    uint16_t length = static_cast<uint16_t>(std::min(text.size(), MAX_FIELD));
+    put(out, length);
+    out.append(text, 0, length);
+}
+
+template <typename T>
+bool get(const char*& in, const char* end, T& value) {
+    if (static_cast<size_t>(end - in) < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return true;
+}
+
+bool get_text(const char*& in, const char* end, std::string& text) {
+    uint16_t length;
+    if (!get(in, end, length) || static_cast<size_t>(end - in) < length) {
+        return false;
+    }
+    text.assign(in, length);
+    in += length;
+    return true;
+}
+
+void encode_payload(std::string& out, uint64_t sequence, const AuditEntry& entry) {
+    put(out, sequence);
+    put(out, static_cast<int64_t>(entry.timestamp));
+    put(out, static_cast<uint8_t>(entry.event_type));
+    put(out, static_cast<uint8_t>(entry.success ? 1 : 0));
+    put_text(out, entry.user);
+    put_text(out, entry.action);
+    put_text(out, entry.target);
+    put_text(out, entry.details);
+}
+
+// Appends one whole record and moves `chain` on to its hash
+uint32_t encode_record(std::string& out, uint64_t sequence, const AuditEntry& entry, std::string& chain) {
+    size_t start = out.size();
+    put(out, uint32_t(0));
+    encode_payload(out, sequence, entry);
+    uint32_t length = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+    std::memcpy(&out[start], &length, sizeof(length));
+
+    chain = chain_hash(chain, out.data() + start + sizeof(length), length);
+    out += chain;
+    return length;
+}
+
+bool decode_payload(const char* in, size_t length, uint64_t& sequence, AuditEntry& entry) {
+    const char* end = in + length;
+    int64_t timestamp;
+    uint8_t event_type;
+    uint8_t success;
+    if (!get(in, end, sequence) || !get(in, end, timestamp) || !get(in, end, event_type) ||
+        !get(in, end, success) || !get_text(in, end, entry.user) || !get_text(in, end, entry.action) ||
+        !get_text(in, end, entry.target) || !get_text(in, end, entry.details)) {
+        return false;
+    }
+    entry.timestamp = static_cast<time_t>(timestamp);
+    entry.event_type = static_cast<AuditEventType>(event_type);
+    entry.success = success != 0;
+    return true;
+}
+
+// Whether `bytes`, the start of a record's payload that runs past the end of
+// the file, fits a record cut short by a crash: it is the next sequence and
+// its string lengths add up to `length`. A damaged length field does not.
+bool torn_payload(const std::string& bytes, uint32_t length, uint64_t sequence) {
+    const char* in = bytes.data();
+    const char* end = in + bytes.size();
+    uint64_t stored_sequence;
+    if (!get(in, end, stored_sequence) || stored_sequence != sequence) {
+        return false;
+    }
+    size_t used = MIN_PAYLOAD - 4 * sizeof(uint16_t);
+    in = bytes.data() + std::min(used, bytes.size());
+    for (int field = 0; field < 4; ++field) {
+        uint16_t text_length;
+        if (!get(in, end, text_length)) {
+            return true;  // cut off before this field
+        }
+        used += sizeof(text_length) + text_length;
+        if (used > length) {
+            return false;
+        }
+        in += std::min<size_t>(text_length, end - in);
+    }
+    return used == length;
+}
+
+bool write_all(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1 << 30)));
+#else
+        ssize_t written = ::write(fd, data, size);
+#endif
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool sync_file(int fd) {
+#ifdef _WIN32
+    return _commit(fd) == 0;
+#elif defined(__APPLE__)
+    return fsync(fd) == 0;
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+void close_file(int fd) {
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+}
+
+// flock on the whole journal until it goes out of scope. Committers take it
+// exclusively on their own descriptor, readers shared on one of their own,
+// so no one sees another process's batch half written. Nothing on Windows,
+// where only one process writes the journal.
+class FileLock {
+public:
+    explicit FileLock(int fd) : fd_(fd), owned_(false) {
+        lock(true);
+    }
+
+    explicit FileLock(const std::string& path) : fd_(-1), owned_(true) {
+#ifndef _WIN32
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        lock(false);
+#else
+        (void)path;
+#endif
+    }
+
+    ~FileLock() {
+#ifndef _WIN32
+        if (fd_ >= 0) {
+            flock(fd_, LOCK_UN);
+            if (owned_) {
+                ::close(fd_);
+            }
+        }
+#endif
+    }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    void lock(bool exclusive) {
+#ifndef _WIN32
+        while (fd_ >= 0 && flock(fd_, exclusive ? LOCK_EX : LOCK_SH) != 0 && errno == EINTR) {
+        }
+#else
+        (void)exclusive;
+#endif
+    }
+
+    int fd_;
+    bool owned_;
+};
+
+} // anonymous namespace
+
+AuditJournal::AuditJournal()
+    : fd_(-1)
+    , appended_(0)
+    , durable_(0)
+    , sync_requested_(false)
+    , stopping_(false)
+    , failed_(false)
+    , end_offset_(0) {
+}
+
+AuditJournal::~AuditJournal() {
+    close();
+}
+
+bool AuditJournal::open(const std::string& path) {
+    close();
+
+    // Absolute, so reads still find the file after a `cd`
+    std::error_code ec;
+    fs::path absolute = fs::absolute(path, ec);
+    if (ec) {
+        return false;
+    }
+    fs::create_directories(absolute.parent_path(), ec);
+
+    path_ = absolute.string();
+#ifdef _WIN32
+    fd_ = _open(path_.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+#endif
+    if (fd_ < 0) {
+        return false;
+    }
+
+    bool loaded;
+    {
+        FileLock file_lock(fd_);
+        loaded = load_index();
+    }
+    if (!loaded) {
+        close_file(fd_);
+        fd_ = -1;
+        index_.clear();
+        return false;
+    }
+
+    appended_ = durable_ = 0;
+    stopping_ = false;
+    failed_ = false;
+    committer_ = std::thread([this] { commit_loop(); });
+    return true;
+}
+
+bool AuditJournal::load_index() {
+    index_.clear();
+    chain_.assign(HASH_SIZE, '\0');
+    end_offset_ = 0;
+
+    std::error_code ec;
+    uint64_t file_size = fs::file_size(path_, ec);
+    if (ec) {
+        return false;
+    }
+    if (file_size == 0) {
+        std::string header(MAGIC, sizeof(MAGIC));
+        header += VERSION;
+        header += HASH_ALGORITHM;
+        end_offset_ = HEADER_SIZE;
+        return write_all(fd_, header.data(), header.size()) && sync_file(fd_);
+    }
+
+    std::ifstream in(path_, std::ios::binary);
+    char header[HEADER_SIZE];
+    if (file_size < HEADER_SIZE || !in.read(header, HEADER_SIZE) ||
+        std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || header[4] != VERSION || header[5] != HASH_ALGORITHM) {
+        return false;
+    }
+    in.close();
+
+    end_offset_ = HEADER_SIZE;
+    Tail tail = index_new_records();
+    if (tail == Tail::DAMAGED) {
+        return false;  // left as it is for audit-verify to report
+    }
+    if (!index_.empty() && !last_record_intact()) {
+        // Its length reached the disk but not all of its bytes
+        end_offset_ = index_.back().offset;
+        index_.pop_back();
+        tail = Tail::TORN;
+    }
+    return tail == Tail::CLEAN || cut_tail();
+}
+
+AuditJournal::Tail AuditJournal::index_new_records() {
+    std::error_code ec;
+    uint64_t file_size = fs::file_size(path_, ec);
+    if (ec || file_size < end_offset_) {
+        return Tail::DAMAGED;
+    }
+    if (file_size == end_offset_) {
+        return Tail::CLEAN;
+    }
+
+    // Only lengths and the last chain hash are read; verify() checks the rest
+    std::ifstream in(path_, std::ios::binary);
+    uint64_t offset = end_offset_;
+    Tail tail = Tail::CLEAN;
+    while (offset < file_size) {
+        uint32_t length;
+        if (file_size - offset < MIN_RECORD) {
+            tail = Tail::TORN;
+            break;
+        }
+        in.seekg(static_cast<std::streamoff>(offset));
+        if (!in.read(reinterpret_cast<char*>(&length), sizeof(length)) || length < MIN_PAYLOAD) {
+            tail = Tail::DAMAGED;
+            break;
+        }
+        if (offset + sizeof(length) + length + HASH_SIZE > file_size) {
+            // Cut short by a crash, or a damaged length that would take
+            // intact records with it if cut
+            std::string partial(static_cast<size_t>(std::min<uint64_t>(length, file_size - offset - sizeof(length))),
+                                '\0');
+            bool torn = in.read(&partial[0], partial.size()) && torn_payload(partial, length, index_.size() + 1);
+            tail = torn ? Tail::TORN : Tail::DAMAGED;
+            break;
+        }
+        index_.push_back(IndexEntry{offset, length});
+        offset += sizeof(length) + length + HASH_SIZE;
+    }
+
+    if (offset > end_offset_) {
+        in.clear();
+        in.seekg(static_cast<std::streamoff>(offset - HASH_SIZE));
+        if (!in.read(&chain_[0], HASH_SIZE)) {
+            return Tail::DAMAGED;
+        }
+    }
+    end_offset_ = offset;
+    return tail;
+}
+
+bool AuditJournal::last_record_intact() {
+    std::ifstream in(path_, std::ios::binary);
+    std::string previous(HASH_SIZE, '\0');
+    if (index_.size() > 1) {
+        const IndexEntry& before = index_[index_.size() - 2];
+        in.seekg(static_cast<std::streamoff>(before.offset + sizeof(uint32_t) + before.length));
+        if (!in.read(&previous[0], HASH_SIZE)) {
+            return false;
+        }
+    }
+    const IndexEntry& last = index_.back();
+    std::string payload(last.length, '\0');
+    in.seekg(static_cast<std::streamoff>(last.offset + sizeof(uint32_t)));
+    if (!in.read(&payload[0], last.length)) {
+        return false;
+    }
+    return chain_hash(previous, payload.data(), payload.size()) == chain_;
+}
+
+bool AuditJournal::cut_tail() {
+    // Never acknowledged: a crash came before its fsync finished
+    std::error_code ec;
+    fs::resize_file(path_, end_offset_, ec);
+    if (ec) {
+        return false;
+    }
+    if (!index_.empty()) {
+        std::ifstream in(path_, std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(end_offset_ - HASH_SIZE));
+        return static_cast<bool>(in.read(&chain_[0], HASH_SIZE));
+    }
+    chain_.assign(HASH_SIZE, '\0');
+    return true;
+}
+
+void AuditJournal::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    if (committer_.joinable()) {
+        committer_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0) {
+        close_file(fd_);
+        fd_ = -1;
+    }
+    committed_.notify_all();
+}
+
+bool AuditJournal::is_open() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fd_ >= 0 && !stopping_;
+}
+
+bool AuditJournal::append(const AuditEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0 || stopping_ || failed_) {
+        return false;
+    }
+
+    pending_.push_back(entry);
+    ++appended_;
+    if (pending_.size() == 1 || pending_.size() >= GROUP_COMMIT_SIZE) {
+        work_ready_.notify_one();
+    }
+    return true;
+}
+
+void AuditJournal::commit_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<AuditEntry> batch;
+    std::vector<IndexEntry> added;
+    std::string encoded;
+    while (true) {
+        work_ready_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) {
+            break;
+        }
+
+        // Let a group build up unless it is full or someone is waiting on it
+        work_ready_.wait_for(lock, GROUP_COMMIT_INTERVAL, [this] {
+            return stopping_ || sync_requested_ || pending_.size() >= GROUP_COMMIT_SIZE;
+        });
+
+        batch.swap(pending_);
+        pending_.clear();
+        sync_requested_ = false;
+        int fd = fd_;
+        lock.unlock();
+
+        bool written = false;
+        {
+            // Other processes append to the same file. Under the lock, pick
+            // up what they added since our last commit, then number and
+            // chain this batch after it.
+            FileLock file_lock(fd);
+            lock.lock();
+            Tail tail = index_new_records();
+            bool ready = tail == Tail::CLEAN || (tail == Tail::TORN && cut_tail());
+            uint64_t sequence = index_.size();
+            uint64_t offset = end_offset_;
+            std::string chain = chain_;
+            lock.unlock();
+
+            encoded.clear();
+            added.clear();
+            for (const auto& entry : batch) {
+                uint64_t start = offset + encoded.size();
+                added.push_back(IndexEntry{start, encode_record(encoded, ++sequence, entry, chain)});
+            }
+            written = ready && write_all(fd, encoded.data(), encoded.size()) && sync_file(fd);
+
+            lock.lock();
+            if (written) {
+                index_.insert(index_.end(), added.begin(), added.end());
+                end_offset_ = offset + encoded.size();
+                chain_ = chain;
+            }
+            lock.unlock();
+        }
+        lock.lock();
+
+        if (written) {
+            durable_ += batch.size();
+        }
+        else {
+            failed_ = true;
+        }
+        batch.clear();
+        committed_.notify_all();
+    }
+}
+
+bool AuditJournal::sync() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (fd_ < 0) {
+        return false;
+    }
+    uint64_t target = appended_;
+    if (durable_ < target) {
+        sync_requested_ = true;
+        work_ready_.notify_one();
+        committed_.wait(lock, [this, target] { return durable_ >= target || failed_ || fd_ < 0; });
+    }
+    return durable_ >= target;
+}
+
+std::vector<AuditRecord> AuditJournal::newest(size_t count) {
+    sync();
+
+    std::vector<AuditRecord> records;
+    FileLock file_lock(path_);
+    std::vector<IndexEntry> wanted;
+    {
+        // Take in what other processes have committed meanwhile
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0) {
+            return records;
+        }
+        index_new_records();
+        size_t first = index_.size() - std::min(count, index_.size());
+        wanted.assign(index_.begin() + first, index_.end());
+    }
+
+    std::ifstream in(path_, std::ios::binary);
+    std::string payload;
+    std::string hash(HASH_SIZE, '\0');
+    for (auto it = wanted.rbegin(); it != wanted.rend(); ++it) {
+        payload.resize(it->length);
+        in.seekg(static_cast<std::streamoff>(it->offset + sizeof(uint32_t)));
+        if (!in.read(&payload[0], it->length) || !in.read(&hash[0], HASH_SIZE)) {
+            break;
+        }
+        AuditRecord record;
+        if (!decode_payload(payload.data(), payload.size(), record.sequence, record.entry)) {
+            break;
+        }
+        record.hash = to_hex(hash);
+        records.push_back(std::move(record));
+    }
+    return records;
+}
+
+uint64_t AuditJournal::verify() {
+    sync();
+
+    // Reads the file itself, so it also checks a journal open() refused
+    FileLock file_lock(path_);
+    std::error_code ec;
+    uint64_t file_size = path_.empty() ? 0 : fs::file_size(path_, ec);
+    if (ec || file_size == 0) {
+        return 0;
+    }
+
+    std::ifstream in(path_, std::ios::binary);
+    char header[HEADER_SIZE];
+    if (!in.read(header, HEADER_SIZE) || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0 ||
+        header[4] != VERSION || header[5] != HASH_ALGORITHM) {
+        return 1;
+    }
+
+    std::string chain(HASH_SIZE, '\0');
+    std::string payload;
+    std::string stored(HASH_SIZE, '\0');
+    AuditEntry entry;
+    uint64_t offset = HEADER_SIZE;
+    for (uint64_t expected = 1; offset < file_size; ++expected) {
+        uint32_t length;
+        uint64_t sequence;
+        if (!in.read(reinterpret_cast<char*>(&length), sizeof(length)) ||
+            offset + sizeof(length) + length + HASH_SIZE > file_size) {
+            return expected;
+        }
+        payload.resize(length);
+        if (!in.read(&payload[0], length) || !in.read(&stored[0], HASH_SIZE) ||
+            !decode_payload(payload.data(), payload.size(), sequence, entry) || sequence != expected) {
+            return expected;
+        }
+        chain = chain_hash(chain, payload.data(), payload.size());
+        if (chain != stored) {
+            return expected;
+        }
+        offset += sizeof(length) + length + HASH_SIZE;
+    }
+    return 0;
+}
+
+uint64_t AuditJournal::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size() + (appended_ - durable_);
+}
 
 } // namespace logging
 } // namespace customos
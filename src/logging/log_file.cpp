@@ -0,0 +1,472 @@
+#include "logging/log_file.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace customos {
+namespace logging {
+
+namespace {
+
+const char MAGIC[4] = {'N', 'S', 'L', 'G'};
+const char VERSION = 1;
+const size_t HEADER_SIZE = sizeof(MAGIC) + 1;
+const char NAME_RECORD = 0x01;
+const char ENTRY_RECORD = 0x02;
+const char* SEGMENT_PREFIX = "log-";
+const char* SEGMENT_SUFFIX = ".nlog";
+const char* COMPRESSED_SUFFIX = ".nlog.gz";
+
+void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+bool get_varint(const char*& in, const char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && in < end; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(*in++);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+std::string segment_name(uint64_t sequence) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%s%06llu%s", SEGMENT_PREFIX, static_cast<unsigned long long>(sequence),
+                  SEGMENT_SUFFIX);
+    return name;
+}
+
+// Sequence number of a segment file name, or 0 if it is not one
+uint64_t segment_sequence(const std::string& name) {
+    size_t prefix = std::strlen(SEGMENT_PREFIX);
+    if (name.compare(0, prefix, SEGMENT_PREFIX) != 0) {
+        return 0;
+    }
+    size_t digits = prefix;
+    while (digits < name.size() && name[digits] >= '0' && name[digits] <= '9') {
+        ++digits;
+    }
+    std::string rest = name.substr(digits);
+    if (digits == prefix || (rest != SEGMENT_SUFFIX && rest != COMPRESSED_SUFFIX)) {
+        return 0;
+    }
+    // Too many digits for 64 bits: not one of ours
+    uint64_t sequence = 0;
+    auto parsed = std::from_chars(name.data() + prefix, name.data() + digits, sequence);
+    if (parsed.ec != std::errc() || parsed.ptr != name.data() + digits) {
+        return 0;
+    }
+    return sequence;
+}
+
+bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool decode(const char* data, size_t size, const std::function<bool(const LogEntryView&)>& visit) {
+    if (size < HEADER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || data[sizeof(MAGIC)] != VERSION) {
+        return false;
+    }
+
+    std::vector<std::string_view> names;
+    const char* in = data + HEADER_SIZE;
+    const char* end = data + size;
+    int64_t time_us = 0;
+    while (in < end) {
+        char tag = *in++;
+        if (tag == NAME_RECORD) {
+            uint64_t id, length;
+            if (!get_varint(in, end, id) || !get_varint(in, end, length) ||
+                length > static_cast<uint64_t>(end - in) || id != names.size()) {
+                break;
+            }
+            names.emplace_back(in, static_cast<size_t>(length));
+            in += length;
+        }
+        else if (tag == ENTRY_RECORD) {
+            if (in == end) {
+                break;
+            }
+            LogEntryView entry;
+            entry.level = static_cast<LogLevel>(*in++);
+            uint64_t delta, source, category, length;
+            if (!get_varint(in, end, delta) || !get_varint(in, end, source) || !get_varint(in, end, category) ||
+                !get_varint(in, end, length) || source >= names.size() || category >= names.size() ||
+                length > static_cast<uint64_t>(end - in)) {
+                break;
+            }
+            time_us += unzigzag(delta);
+            entry.time_us = time_us;
+            entry.source = names[source];
+            entry.category = names[category];
+            entry.message = std::string_view(in, static_cast<size_t>(length));
+            in += length;
+            if (!visit(entry)) {
+                return true;
+            }
+        }
+        else {
+            break;  // torn or foreign bytes: the rest is unreadable
+        }
+    }
+    return true;
+}
+
+bool read_file(const std::string& path, std::string& contents) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+} // anonymous namespace
+
+LogFileWriter::LogFileWriter()
+    : file_(nullptr), sequence_(0), segment_bytes_(0), last_time_us_(0) {
+}
+
+LogFileWriter::~LogFileWriter() {
+    close();
+}
+
+bool LogFileWriter::open(const Options& options) {
+    close();
+    options_ = options;
+
+    // Absolute, so rotation and readers still find the segments after a `cd`
+    std::error_code ec;
+    fs::path directory = fs::absolute(options_.directory, ec);
+    if (ec) {
+        return false;
+    }
+    options_.directory = directory.string();
+    fs::create_directories(options_.directory, ec);
+    auto existing = LogFileReader::segments(options_.directory);
+    sequence_ = 0;
+    for (const auto& path : existing) {
+        std::string name = fs::path(path).filename().string();
+        sequence_ = std::max(sequence_, segment_sequence(name));
+        // Left uncompressed by a session that did not close cleanly. Another
+        // writer's current segment is locked, and the compression skips it.
+        if (options_.compress && ends_with(name, SEGMENT_SUFFIX)) {
+            compress_in_background(path);
+        }
+    }
+    return start_segment();
+}
+
+void LogFileWriter::close() {
+    if (file_) {
+        flush();
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    for (auto& compression : compressions_) {
+        compression.wait();
+    }
+    compressions_.clear();
+}
+
+bool LogFileWriter::is_open() const {
+    return file_ != nullptr;
+}
+
+bool LogFileWriter::start_segment() {
+#ifndef _WIN32
+    // Another writer in the same directory may have taken the next number,
+    // and may already have compressed it; never reuse it. The lock marks the
+    // segment as in use until it is closed.
+    int fd = -1;
+    for (int attempt = 0; attempt < 64 && fd < 0; ++attempt) {
+        std::string path = (fs::path(options_.directory) / segment_name(++sequence_)).string();
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0 && errno != EEXIST) {
+            return false;
+        }
+        // Checked after creating: a compression finishing meanwhile renames
+        // its .gz into place before it removes the plain file
+        std::error_code ec;
+        if (fd >= 0 && fs::exists(path + ".gz", ec)) {
+            ::close(fd);
+            ::unlink(path.c_str());
+            fd = -1;
+        }
+    }
+    if (fd < 0) {
+        return false;
+    }
+    flock(fd, LOCK_EX);
+    file_ = fdopen(fd, "wb");
+    if (!file_) {
+        ::close(fd);
+        return false;
+    }
+#else
+    std::string path = (fs::path(options_.directory) / segment_name(++sequence_)).string();
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        return false;
+    }
+#endif
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+
+    names_.clear();
+    last_time_us_ = 0;
+    segment_bytes_ = 0;
+    segment_started_ = std::chrono::steady_clock::now();
+    pending_.assign(MAGIC, sizeof(MAGIC));
+    pending_ += VERSION;
+    return flush();
+}
+
+uint32_t LogFileWriter::intern(std::string_view name) {
+    auto it = names_.find(std::string(name));
+    if (it != names_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.emplace(std::string(name), id);
+    pending_ += NAME_RECORD;
+    put_varint(pending_, id);
+    put_varint(pending_, name.size());
+    pending_.append(name.data(), name.size());
+    return id;
+}
+
+void LogFileWriter::append(LogLevel level, int64_t time_us, std::string_view source, std::string_view category,
+                           std::string_view message) {
+    if (!file_) {
+        return;
+    }
+    // Names are per segment, so rotate before encoding, never in between
+    if (segment_bytes_ + pending_.size() >= options_.max_segment_bytes ||
+        std::chrono::steady_clock::now() - segment_started_ >= options_.max_segment_age) {
+        if (!rotate()) {
+            return;
+        }
+    }
+
+    uint32_t source_id = intern(source);
+    uint32_t category_id = intern(category);
+    pending_ += ENTRY_RECORD;
+    pending_ += static_cast<char>(level);
+    put_varint(pending_, zigzag(time_us - last_time_us_));
+    put_varint(pending_, source_id);
+    put_varint(pending_, category_id);
+    put_varint(pending_, message.size());
+    pending_.append(message.data(), message.size());
+    last_time_us_ = time_us;
+}
+
+bool LogFileWriter::flush() {
+    if (!file_ || pending_.empty()) {
+        return file_ != nullptr;
+    }
+    size_t written = std::fwrite(pending_.data(), 1, pending_.size(), file_);
+    segment_bytes_ += written;
+    bool ok = written == pending_.size();
+    pending_.clear();
+    return ok;
+}
+
+bool LogFileWriter::rotate() {
+    if (!file_) {
+        return false;
+    }
+    flush();
+    std::fclose(file_);
+    file_ = nullptr;
+
+    if (options_.compress) {
+        compress_in_background((fs::path(options_.directory) / segment_name(sequence_)).string());
+    }
+    return start_segment();
+}
+
+void LogFileWriter::compress_in_background(const std::string& path) {
+#ifdef HAVE_ZLIB
+    // Forget compressions that have finished
+    compressions_.erase(std::remove_if(compressions_.begin(), compressions_.end(),
+                                       [](std::future<void>& compression) {
+                                           return compression.wait_for(std::chrono::seconds(0)) ==
+                                                  std::future_status::ready;
+                                       }),
+                        compressions_.end());
+
+    compressions_.push_back(std::async(std::launch::async, [path] {
+#ifndef _WIN32
+        // A writer holds its current segment locked; only compress segments
+        // nobody is writing. Held until the plain copy is removed.
+        int lock_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (lock_fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (flock(lock_fd, LOCK_EX | LOCK_NB) != 0 || fstat(lock_fd, &info) != 0 ||
+            static_cast<size_t>(info.st_size) < HEADER_SIZE) {
+            ::close(lock_fd);  // in use, or created but not yet locked
+            return;
+        }
+        struct LockGuard {
+            int fd;
+            ~LockGuard() { ::close(fd); }
+        } guard{lock_fd};
+#endif
+        std::string contents;
+        if (!read_file(path, contents)) {
+            return;
+        }
+        std::string temp_path = path + ".gz.tmp";
+        gzFile out = gzopen(temp_path.c_str(), "wb6");
+        if (!out) {
+            return;
+        }
+        bool ok = contents.empty() ||
+                  gzwrite(out, contents.data(), static_cast<unsigned>(contents.size())) ==
+                      static_cast<int>(contents.size());
+        ok = gzclose(out) == Z_OK && ok;
+        std::error_code ec;
+        if (!ok) {
+            fs::remove(temp_path, ec);
+            return;
+        }
+        // Readers listing the directory meanwhile see one copy or the other
+        fs::rename(temp_path, path + ".gz", ec);
+        if (!ec) {
+            fs::remove(path, ec);
+        }
+    }));
+#else
+    (void)path;  // kept uncompressed
+#endif
+}
+
+void LogFileWriter::remove_older_than(time_t cutoff) {
+    auto age = std::chrono::seconds(std::max<time_t>(0, time(nullptr) - cutoff));
+    auto threshold = fs::file_time_type::clock::now() - age;
+
+    std::string current = segment_name(sequence_);
+    for (const auto& path : LogFileReader::segments(options_.directory)) {
+        if (fs::path(path).filename().string() == current) {
+            continue;
+        }
+        std::error_code ec;
+        auto written = fs::last_write_time(path, ec);
+        if (!ec && written < threshold) {
+            fs::remove(path, ec);
+        }
+    }
+}
+
+std::vector<std::string> LogFileReader::segments(const std::string& directory) {
+    std::vector<std::pair<uint64_t, std::string>> found;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        uint64_t sequence = segment_sequence(it->path().filename().string());
+        if (sequence != 0) {
+            found.emplace_back(sequence, it->path().string());
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < found.size(); ++i) {
+        // Mid-compression both copies exist; the plain one is complete
+        if (i + 1 < found.size() && found[i + 1].first == found[i].first) {
+            bool first_plain = ends_with(found[i].second, SEGMENT_SUFFIX);
+            paths.push_back(first_plain ? found[i].second : found[i + 1].second);
+            ++i;
+            continue;
+        }
+        paths.push_back(found[i].second);
+    }
+    return paths;
+}
+
+bool LogFileReader::scan(const std::string& path, const std::function<bool(const LogEntryView&)>& visit) {
+    if (ends_with(path, COMPRESSED_SUFFIX)) {
+#ifdef HAVE_ZLIB
+        gzFile in = gzopen(path.c_str(), "rb");
+        if (!in) {
+            return false;
+        }
+        std::string contents;
+        char buffer[1 << 16];
+        int read;
+        while ((read = gzread(in, buffer, sizeof(buffer))) > 0) {
+            contents.append(buffer, static_cast<size_t>(read));
+        }
+        gzclose(in);
+        return decode(contents.data(), contents.size(), visit);
+#else
+        return false;
+#endif
+    }
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    bool ok = decode(static_cast<const char*>(mapped), size, visit);
+    munmap(mapped, size);
+    return ok;
+#else
+    std::string contents;
+    if (!read_file(path, contents)) {
+        return false;
+    }
+    return decode(contents.data(), contents.size(), visit);
+#endif
+}
+
+} // namespace logging
+} // namespace customos
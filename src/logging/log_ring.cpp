@@ -0,0 +1,56 @@
+#include "logging/log_ring.h"
+#include <algorithm>
+#include <cstring>
+
+namespace customos {
+namespace logging {
+
+void LogRecord::assign(LogLevel record_level, std::string_view text, std::string_view from, int64_t when_us) {
+    time_us = when_us;
+    expand = nullptr;
+    level = record_level;
+    source_length = static_cast<uint16_t>(std::min(from.size(), SOURCE_BYTES));
+    message_length = static_cast<uint16_t>(std::min(text.size(), MESSAGE_BYTES));
+    truncated = text.size() > MESSAGE_BYTES;
+    std::memcpy(source, from.data(), source_length);
+    std::memcpy(message, text.data(), message_length);
+}
+
+void LogRecord::message_text(std::string& out) const {
+    if (expand) {
+        expand(message, out);
+        return;
+    }
+    out.append(message, message_length);
+    if (truncated) {
+        out += "...";
+    }
+}
+
+LogRing::LogRing(size_t capacity) : enqueue_pos_(0), dequeue_pos_(0) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    cells_.reset(new Cell[size]);
+    mask_ = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool LogRing::try_pop(LogRecord& record) {
+    Cell& cell = cells_[dequeue_pos_ & mask_];
+    size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (sequence != dequeue_pos_ + 1) {
+        return false;  // empty, or a producer is still filling it
+    }
+    record = cell.record;
+    // Free the cell for the producer one lap ahead
+    cell.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+}
+
+} // namespace logging
+} // namespace customos
@@ -0,0 +1,270 @@
+#include "logging/log_store.h"
+#include <algorithm>
+#include <iterator>
+
+namespace customos {
+namespace logging {
+
+namespace {
+
+// Rough cost of one index word beyond its characters (node, bucket, vector)
+const size_t TERM_OVERHEAD = 64;
+
+time_t entry_time(const LogEntry& entry) {
+    return entry.timestamp;
+}
+
+time_t entry_time(const AuditEntry& entry) {
+    return entry.timestamp;
+}
+
+uint32_t entry_kind(const LogEntry& entry) {
+    return 1u << static_cast<unsigned>(entry.level);
+}
+
+uint32_t entry_kind(const AuditEntry& entry) {
+    return 1u << static_cast<unsigned>(entry.event_type);
+}
+
+// The text that is indexed and searched
+template <typename Fn>
+void entry_texts(const LogEntry& entry, Fn fn) {
+    fn(entry.message);
+}
+
+template <typename Fn>
+void entry_texts(const AuditEntry& entry, Fn fn) {
+    fn(entry.user);
+    fn(entry.action);
+    fn(entry.target);
+    fn(entry.details);
+}
+
+size_t entry_bytes(const LogEntry& entry) {
+    return sizeof(entry) + entry.message.capacity() + entry.source.capacity() + entry.user.capacity() +
+           entry.category.capacity();
+}
+
+size_t entry_bytes(const AuditEntry& entry) {
+    return sizeof(entry) + entry.user.capacity() + entry.action.capacity() + entry.target.capacity() +
+           entry.details.capacity();
+}
+
+bool is_word_char(char c) {
+    unsigned char u = static_cast<unsigned char>(c);
+    return (u >= '0' && u <= '9') || (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || u == '_' || u >= 0x80;
+}
+
+// Calls fn(word, begin, end) for each maximal run of word characters
+template <typename Fn>
+void for_each_word(const std::string& text, Fn fn) {
+    size_t i = 0;
+    while (i < text.size()) {
+        if (!is_word_char(text[i])) {
+            ++i;
+            continue;
+        }
+        size_t begin = i;
+        while (i < text.size() && is_word_char(text[i])) {
+            ++i;
+        }
+        fn(text.substr(begin, i - begin), begin, i);
+    }
+}
+
+bool starts_with(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // anonymous namespace
+
+template <typename Entry>
+void LogStore<Entry>::add_to_segment(Segment& segment, Entry entry) {
+    uint16_t position = static_cast<uint16_t>(segment.entries.size());
+    time_t when = entry_time(entry);
+    if (segment.entries.empty()) {
+        segment.first_time = segment.last_time = when;
+    }
+    else {
+        segment.first_time = std::min(segment.first_time, when);
+        segment.last_time = std::max(segment.last_time, when);
+    }
+    segment.kinds |= entry_kind(entry);
+
+    entry_texts(entry, [&segment, position](const std::string& text) {
+        for_each_word(text, [&segment, position](std::string word, size_t, size_t) {
+            auto it = segment.terms.find(word);
+            if (it == segment.terms.end()) {
+                segment.bytes += TERM_OVERHEAD + word.size();
+                it = segment.terms.emplace(std::move(word), std::vector<uint16_t>()).first;
+            }
+            if (it->second.empty() || it->second.back() != position) {
+                it->second.push_back(position);
+                segment.bytes += sizeof(uint16_t);
+            }
+        });
+    });
+
+    segment.bytes += entry_bytes(entry);
+    segment.entries.push_back(std::move(entry));
+}
+
+template <typename Entry>
+void LogStore<Entry>::append(Entry entry) {
+    if (segments_.empty() || segments_.back().entries.size() >= SEGMENT_ENTRIES ||
+        segments_.back().bytes >= SEGMENT_BYTES) {
+        segments_.emplace_back();
+        if (segments_.size() > MAX_SEGMENTS) {
+            bytes_ -= segments_.front().bytes;
+            segments_.pop_front();
+        }
+    }
+    Segment& segment = segments_.back();
+    size_t before = segment.bytes;
+    add_to_segment(segment, std::move(entry));
+    bytes_ += segment.bytes - before;
+}
+
+template <typename Entry>
+void LogStore<Entry>::scan_newest(uint32_t kinds, const Visit& visit) const {
+    for (auto segment = segments_.rbegin(); segment != segments_.rend(); ++segment) {
+        if (!(segment->kinds & kinds)) {
+            continue;
+        }
+        for (auto entry = segment->entries.rbegin(); entry != segment->entries.rend(); ++entry) {
+            if ((entry_kind(*entry) & kinds) && !visit(*entry)) {
+                return;
+            }
+        }
+    }
+}
+
+template <typename Entry>
+bool LogStore<Entry>::candidates(const Segment& segment, const std::string& text, std::vector<uint16_t>& out) {
+    // A word in the middle of `text` is a whole word of the entry; the
+    // first may be the end of a longer one, the last the start of one
+    bool has_words = false;
+    bool first = true;
+    std::vector<uint16_t> matched;
+    std::vector<uint16_t> merged;
+    for_each_word(text, [&](const std::string& word, size_t begin, size_t end) {
+        bool open_left = begin == 0;
+        bool open_right = end == text.size();
+        matched.clear();
+        if (!open_left && !open_right) {
+            auto it = segment.terms.find(word);
+            if (it != segment.terms.end()) {
+                matched = it->second;
+            }
+        }
+        else {
+            for (const auto& term : segment.terms) {
+                bool hit = open_left && open_right ? term.first.find(word) != std::string::npos
+                           : open_left             ? ends_with(term.first, word)
+                                                   : starts_with(term.first, word);
+                if (hit) {
+                    merged.clear();
+                    std::set_union(matched.begin(), matched.end(), term.second.begin(), term.second.end(),
+                                   std::back_inserter(merged));
+                    matched.swap(merged);
+                }
+            }
+        }
+
+        if (first) {
+            out.swap(matched);
+            first = false;
+        }
+        else {
+            merged.clear();
+            std::set_intersection(out.begin(), out.end(), matched.begin(), matched.end(), std::back_inserter(merged));
+            out.swap(merged);
+        }
+        has_words = true;
+    });
+    return has_words;
+}
+
+template <typename Entry>
+void LogStore<Entry>::search(const std::string& text, time_t start, time_t end, uint32_t kinds,
+                             const std::function<bool(const Entry&)>& match, const Visit& visit) const {
+    std::vector<uint16_t> positions;
+    for (const auto& segment : segments_) {
+        if (!(segment.kinds & kinds) || (start != 0 && segment.last_time < start) ||
+            (end != 0 && segment.first_time > end)) {
+            continue;
+        }
+
+        auto consider = [&](const Entry& entry) {
+            time_t when = entry_time(entry);
+            if ((start != 0 && when < start) || (end != 0 && when > end) || !(entry_kind(entry) & kinds) ||
+                !match(entry)) {
+                return true;
+            }
+            return visit(entry);
+        };
+
+        if (candidates(segment, text, positions)) {
+            for (uint16_t position : positions) {
+                if (!consider(segment.entries[position])) {
+                    return;
+                }
+            }
+        }
+        else {
+            for (const auto& entry : segment.entries) {
+                if (!consider(entry)) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+template <typename Entry>
+void LogStore<Entry>::erase_before(time_t cutoff) {
+    std::deque<Segment> kept;
+    bytes_ = 0;
+    for (auto& segment : segments_) {
+        if (segment.last_time < cutoff) {
+            continue;
+        }
+        if (segment.first_time < cutoff) {
+            // Straddles the cutoff: rebuild from the entries that stay
+            Segment rebuilt;
+            for (auto& entry : segment.entries) {
+                if (entry_time(entry) >= cutoff) {
+                    add_to_segment(rebuilt, std::move(entry));
+                }
+            }
+            segment = std::move(rebuilt);
+        }
+        bytes_ += segment.bytes;
+        kept.push_back(std::move(segment));
+    }
+    segments_.swap(kept);
+}
+
+template <typename Entry>
+size_t LogStore<Entry>::size() const {
+    size_t count = 0;
+    for (const auto& segment : segments_) {
+        count += segment.entries.size();
+    }
+    return count;
+}
+
+template <typename Entry>
+size_t LogStore<Entry>::bytes() const {
+    return bytes_;
+}
+
+template class LogStore<LogEntry>;
+template class LogStore<AuditEntry>;
+
+} // namespace logging
+} // namespace customos
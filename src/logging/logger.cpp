@@ -1,4 +1,8 @@
 #include "logging/logger.h"
+#include "logging/log_ring.h"
+#include "logging/log_store.h"
+#include "logging/log_file.h"
+#include "logging/audit_trail.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -6,51 +10,110 @@
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <vector>
 #include <map>
 #include <algorithm>
 #include <memory>
 #include <ctime>
-#include <ctime>
 #include <string>
+#include <string_view>
+#include <filesystem>
 
 namespace customos {
 namespace logging {
 
+const char* log_level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::CRITICAL: return "CRITICAL";
+        default: return "UNKNOWN";
+    }
+}
+
 struct Logger::Impl {
-    std::vector<LogEntry> log_entries;
-    std::vector<AuditEntry> audit_entries;
-    LogLevel min_level = LogLevel::INFO;
+    // Records the writer takes from the ring per batch
+    static constexpr size_t BATCH_RECORDS = 256;
+    // Longest the writer sleeps; also covers a wake-up a producer missed
+    static constexpr std::chrono::milliseconds IDLE_WAIT{50};
+
+    LogStore<LogEntry> log_entries;
+    LogStore<AuditEntry> audit_entries;
     std::string log_file;
     bool console_output = true;
     bool file_output = true;
     std::mutex mutex;
     std::ofstream file_stream;
+    LogFileWriter binary_log;
+    AuditJournal audit_journal;  // has its own lock; used without `mutex`
+
+    // Async mode
+    std::unique_ptr<LogRing> ring;
+    std::atomic<bool> async{false};
+    std::atomic<OverflowPolicy> overflow{OverflowPolicy::DROP};
+    std::atomic<uint64_t> pushed{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> writer_idle{false};
+    std::thread writer;
+    std::mutex writer_mutex;
+    std::condition_variable wake;     // producers and flush() -> writer
+    std::condition_variable drained;  // writer -> flush()
+    uint64_t written = 0;             // records taken from the ring; writer_mutex
+    bool stopping = false;            // writer_mutex
+    uint64_t reported_drops = 0;      // writer only
+
+    // Local time of the last second formatted; mutex held
+    time_t cached_second = -1;
+    char cached_time[32] = {};
+
+    const char* format_time(time_t seconds) {
+        if (seconds != cached_second) {
+            std::tm local{};
+#ifdef _WIN32
+            localtime_s(&local, &seconds);
+#else
+            localtime_r(&seconds, &local);
+#endif
+            strftime(cached_time, sizeof(cached_time), "%Y-%m-%d %H:%M:%S", &local);
+            cached_second = seconds;
+        }
+        return cached_time;
+    }
 
-    std::string get_timestamp() {
-        time_t now = time(nullptr);
-        char buf[32];
-        strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&now));
-        return std::string(buf);
-    }
-
-    std::string level_to_string(LogLevel level) {
-        switch (level) {
-            case LogLevel::TRACE: return "TRACE";
-            case LogLevel::DEBUG: return "DEBUG";
-            case LogLevel::INFO: return "INFO";
-            case LogLevel::WARNING: return "WARNING";
-            case LogLevel::ERROR: return "ERROR";
-            case LogLevel::CRITICAL: return "CRITICAL";
-            default: return "UNKNOWN";
+
+    // "[time] [LEVEL] [source] message", no newline; mutex held
+    void format_line(std::string& out, LogLevel level, time_t timestamp, std::string_view source,
+                     std::string_view message) {
+        out += '[';
+        out += format_time(timestamp);
+        out += "] [";
+        out += log_level_name(level);
+        out += "] ";
+        if (!source.empty()) {
+            out += '[';
+            out += source;
+            out += "] ";
         }
+        out += message;
     }
+
+    // Claim a ring cell for `fill`, applying the overflow policy
+    template <typename Fill>
+    void enqueue(Fill&& fill);
+    void writer_loop();
+    size_t write_batch();  // mutex held
 };
 
-Logger::Logger() : pimpl_(std::make_unique<Impl>()) {
+Logger::Logger() : min_level_(LogLevel::INFO), pimpl_(std::make_unique<Impl>()) {
 }
 
 Logger::~Logger() {
+    set_async(false);
     flush();
 }
 
@@ -59,45 +122,173 @@ Logger& Logger::instance() {
     return instance;
 }
 
+namespace {
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // anonymous namespace
+
+template <typename Fill>
+void Logger::Impl::enqueue(Fill&& fill) {
+    if (!ring->try_push(fill)) {
+        if (overflow.load(std::memory_order_relaxed) == OverflowPolicy::DROP) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        do {
+            wake.notify_one();
+            std::this_thread::yield();
+        } while (!ring->try_push(fill));
+    }
+    pushed.fetch_add(1);
+    if (writer_idle.load()) {
+        wake.notify_one();
+    }
+}
+
+bool Logger::enqueue_encoded(LogLevel level, const char* source, size_t size, Encoder encode, const void* context,
+                             Expander expand) {
+    if (size > LogRecord::MESSAGE_BYTES || !pimpl_->async.load(std::memory_order_acquire)) {
+        return false;
+    }
+    int64_t when = now_us();
+    pimpl_->enqueue([&](LogRecord& record) {
+        record.assign(level, std::string_view(), source ? source : "", when);
+        encode(record.message, context);
+        record.message_length = static_cast<uint16_t>(size);
+        record.expand = expand;
+    });
+    return true;
+}
+
+size_t Logger::Impl::write_batch() {
+    std::string out;
+    std::string errors;  // ERROR and above go to stderr on the console
+    LogRecord record;
+    size_t count = 0;
+    while (count < BATCH_RECORDS && ring->try_pop(record)) {
+        ++count;
+        LogEntry entry;
+        entry.level = record.level;
+        record.message_text(entry.message);
+        entry.source.assign(record.source, record.source_length);
+        entry.timestamp = static_cast<time_t>(record.time_us / 1000000);
+        entry.category = "general";
+
+        std::string& target = (console_output && entry.level >= LogLevel::ERROR) ? errors : out;
+        format_line(target, entry.level, entry.timestamp, entry.source, entry.message);
+        target += '\n';
+        binary_log.append(entry.level, record.time_us, entry.source, entry.category, entry.message);
+        log_entries.append(std::move(entry));
+    }
+
+    uint64_t drops = dropped.load(std::memory_order_relaxed);
+    if (drops != reported_drops) {
+        LogEntry entry;
+        entry.level = LogLevel::WARNING;
+        entry.message = std::to_string(drops - reported_drops) + " log records dropped, queue full";
+        entry.source = "Logger";
+        entry.timestamp = time(nullptr);
+        entry.category = "general";
+        format_line(out, entry.level, entry.timestamp, entry.source, entry.message);
+        out += '\n';
+        log_entries.append(std::move(entry));
+        reported_drops = drops;
+    }
+
+    // One write per stream for the whole batch
+    if (console_output) {
+        if (!out.empty()) {
+            std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+            std::cout.flush();
+        }
+        if (!errors.empty()) {
+            std::cerr.write(errors.data(), static_cast<std::streamsize>(errors.size()));
+            std::cerr.flush();
+        }
+    }
+    if (file_output && file_stream.is_open()) {
+        out += errors;
+        if (!out.empty()) {
+            file_stream.write(out.data(), static_cast<std::streamsize>(out.size()));
+            file_stream.flush();
+        }
+    }
+    binary_log.flush();
+    return count;
+}
+
+void Logger::Impl::writer_loop() {
+    for (;;) {
+        size_t count;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            count = write_batch();
+        }
+
+        std::unique_lock<std::mutex> lock(writer_mutex);
+        if (count > 0) {
+            written += count;
+            drained.notify_all();
+            continue;
+        }
+        if (stopping) {
+            break;  // the ring was empty after the stop was requested
+        }
+        writer_idle.store(true);
+        wake.wait_for(lock, IDLE_WAIT, [this] { return stopping || pushed.load() != written; });
+        writer_idle.store(false);
+    }
+}
+
 void Logger::log(LogLevel level, const std::string& message, const std::string& source) {
-    std::lock_guard<std::mutex> lock(pimpl_->mutex);
+    if (!enabled(level)) {
+        return;
+    }
 
-    if (level < pimpl_->min_level) {
+    if (pimpl_->async.load(std::memory_order_acquire)) {
+        int64_t when = now_us();
+        pimpl_->enqueue([&](LogRecord& record) { record.assign(level, message, source, when); });
         return;
     }
 
+    int64_t when = now_us();
+    std::lock_guard<std::mutex> lock(pimpl_->mutex);
+
     LogEntry entry;
     entry.level = level;
     entry.message = message;
     entry.source = source;
-    entry.timestamp = time(nullptr);
+    entry.timestamp = static_cast<time_t>(when / 1000000);
     entry.category = "general";
 
-    pimpl_->log_entries.push_back(entry);
-
     // Format output
-    std::stringstream ss;
-    ss << "[" << pimpl_->get_timestamp() << "] "
-       << "[" << pimpl_->level_to_string(level) << "] ";
-    
-    if (!source.empty()) {
-        ss << "[" << source << "] ";
-    }
-    
-    ss << message;
+    time_t entry_time = entry.timestamp;
+    std::string line;
+    pimpl_->format_line(line, level, entry_time, source, message);
+
+    pimpl_->log_entries.append(std::move(entry));
 
     // Console output
     if (pimpl_->console_output) {
         if (level >= LogLevel::ERROR) {
-            std::cerr << ss.str() << std::endl;
+            std::cerr << line << std::endl;
         } else {
-            std::cout << ss.str() << std::endl;
+            std::cout << line << std::endl;
         }
     }
 
     // File output
     if (pimpl_->file_output && pimpl_->file_stream.is_open()) {
-        pimpl_->file_stream << ss.str() << std::endl;
+        pimpl_->file_stream << line << std::endl;
+    }
+
+    if (pimpl_->binary_log.is_open()) {
+        pimpl_->binary_log.append(level, when, source, "general", message);
+        pimpl_->binary_log.flush();
     }
 }
 
@@ -125,9 +316,13 @@ void Logger::critical(const std::string& message, const std::string& source) {
     log(LogLevel::CRITICAL, message, source);
 }
 
-void Logger::audit(const AuditEntry& entry) {
+bool Logger::audit(const AuditEntry& entry) {
+    // Queued for the journal's next group commit
+    bool journaled = pimpl_->audit_journal.append(entry);
+    int64_t when = now_us();  // entry.timestamp only has whole seconds
+
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    pimpl_->audit_entries.push_back(entry);
+    pimpl_->audit_entries.append(entry);
 
     // Also log to regular log
     std::stringstream ss;
@@ -140,8 +335,13 @@ void Logger::audit(const AuditEntry& entry) {
     log_entry.message = ss.str();
     log_entry.timestamp = entry.timestamp;
     log_entry.category = "audit";
-    
-    pimpl_->log_entries.push_back(log_entry);
+
+    if (pimpl_->binary_log.is_open()) {
+        pimpl_->binary_log.append(log_entry.level, when, "", log_entry.category, log_entry.message);
+        pimpl_->binary_log.flush();
+    }
+    pimpl_->log_entries.append(std::move(log_entry));
+    return journaled;
 }
 
 void Logger::audit_command(const std::string& command, bool success) {
@@ -179,67 +379,73 @@ void Logger::audit_file_access(const std::string& file, const std::string& actio
 
 std::vector<LogEntry> Logger::get_logs(size_t max_count, LogLevel min_level) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    
+
+    // Levels at or above min_level
+    uint32_t levels = ~((1u << static_cast<unsigned>(min_level)) - 1);
     std::vector<LogEntry> result;
-    for (auto it = pimpl_->log_entries.rbegin(); it != pimpl_->log_entries.rend() && result.size() < max_count; ++it) {
-        if (it->level >= min_level) {
-            result.push_back(*it);
-        }
+    if (max_count == 0) {
+        return result;
     }
-    
+    pimpl_->log_entries.scan_newest(levels, [&result, max_count](const LogEntry& entry) {
+        result.push_back(entry);
+        return result.size() < max_count;
+    });
+
     return result;
 }
 
 std::vector<AuditEntry> Logger::get_audit_trail(size_t max_count) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    
+
     std::vector<AuditEntry> result;
-    size_t start = pimpl_->audit_entries.size() > max_count ? 
-                   pimpl_->audit_entries.size() - max_count : 0;
-    
-    for (size_t i = start; i < pimpl_->audit_entries.size(); ++i) {
-        result.push_back(pimpl_->audit_entries[i]);
+    if (max_count == 0) {
+        return result;
     }
-    
+    pimpl_->audit_entries.scan_newest(LogStore<AuditEntry>::ALL_KINDS, [&result, max_count](const AuditEntry& entry) {
+        result.push_back(entry);
+        return result.size() < max_count;
+    });
+    std::reverse(result.begin(), result.end());  // oldest first
+
     return result;
 }
 
 std::vector<LogEntry> Logger::search_logs(const std::string& query, time_t start_time, time_t end_time) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    
+
     std::vector<LogEntry> result;
-    for (const auto& entry : pimpl_->log_entries) {
-        if ((start_time == 0 || entry.timestamp >= start_time) &&
-            (end_time == 0 || entry.timestamp <= end_time) &&
-            entry.message.find(query) != std::string::npos) {
+    pimpl_->log_entries.search(
+        query, start_time, end_time, LogStore<LogEntry>::ALL_KINDS,
+        [&query](const LogEntry& entry) { return entry.message.find(query) != std::string::npos; },
+        [&result](const LogEntry& entry) {
             result.push_back(entry);
-        }
-    }
-    
+            return true;
+        });
+
     return result;
 }
 
 std::vector<AuditEntry> Logger::search_audit(const std::string& user, AuditEventType event_type) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    
+
     std::vector<AuditEntry> result;
-    for (const auto& entry : pimpl_->audit_entries) {
-        if ((user.empty() || entry.user == user)) {
+    pimpl_->audit_entries.search(
+        user, 0, 0, 1u << static_cast<unsigned>(event_type),
+        [&user](const AuditEntry& entry) { return user.empty() || entry.user == user; },
+        [&result](const AuditEntry& entry) {
             result.push_back(entry);
-        }
-    }
-    
+            return true;
+        });
+
     return result;
 }
 
 void Logger::set_log_level(LogLevel level) {
-    std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    pimpl_->min_level = level;
+    min_level_.store(level);
 }
 
 LogLevel Logger::get_log_level() const {
-    std::lock_guard<std::mutex> lock(pimpl_->mutex);
-    return pimpl_->min_level;
+    return min_level_.load();
 }
 
 void Logger::set_log_file(const std::string& filepath) {
@@ -263,33 +469,163 @@ void Logger::enable_file_output(bool enable) {
     pimpl_->file_output = enable;
 }
 
+void Logger::set_async(bool enable, size_t queue_capacity) {
+    if (enable == pimpl_->async.load()) {
+        return;
+    }
+
+    if (enable) {
+        if (!pimpl_->ring || pimpl_->ring->capacity() < queue_capacity) {
+            pimpl_->ring = std::make_unique<LogRing>(queue_capacity);
+        }
+        pimpl_->stopping = false;
+        pimpl_->writer = std::thread([impl = pimpl_.get()] { impl->writer_loop(); });
+        pimpl_->async.store(true, std::memory_order_release);
+        return;
+    }
+
+    // New calls go synchronous; the writer drains what is queued and exits
+    pimpl_->async.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(pimpl_->writer_mutex);
+        pimpl_->stopping = true;
+        pimpl_->wake.notify_one();
+    }
+    pimpl_->writer.join();
+    std::lock_guard<std::mutex> lock(pimpl_->writer_mutex);
+    pimpl_->drained.notify_all();
+}
+
+bool Logger::is_async() const {
+    return pimpl_->async.load();
+}
+
+void Logger::set_overflow_policy(OverflowPolicy policy) {
+    pimpl_->overflow.store(policy);
+}
+
+uint64_t Logger::dropped_records() const {
+    return pimpl_->dropped.load();
+}
+
 void Logger::flush() {
+    if (pimpl_->async.load()) {
+        uint64_t target = pimpl_->pushed.load();
+        std::unique_lock<std::mutex> lock(pimpl_->writer_mutex);
+        pimpl_->wake.notify_one();
+        pimpl_->drained.wait(lock, [this, target] { return pimpl_->written >= target || pimpl_->stopping; });
+    }
+
+    pimpl_->audit_journal.sync();
+
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
     if (pimpl_->file_stream.is_open()) {
         pimpl_->file_stream.flush();
     }
+    pimpl_->binary_log.flush();
+}
+
+bool Logger::set_audit_journal(const std::string& path) {
+    if (path.empty()) {
+        pimpl_->audit_journal.close();
+        return true;
+    }
+    return pimpl_->audit_journal.open(path);
+}
+
+std::vector<AuditRecord> Logger::read_audit_journal(size_t max_count) {
+    if (!pimpl_->audit_journal.is_open()) {
+        return {};
+    }
+    return pimpl_->audit_journal.newest(max_count);
+}
+
+uint64_t Logger::verify_audit_journal() {
+    return pimpl_->audit_journal.verify();
+}
+
+bool Logger::set_binary_log(const std::string& directory, size_t max_segment_bytes, std::chrono::seconds max_segment_age) {
+    std::lock_guard<std::mutex> lock(pimpl_->mutex);
+    pimpl_->binary_log.close();
+    if (directory.empty()) {
+        return true;
+    }
+    LogFileWriter::Options options;
+    options.directory = directory;
+    options.max_segment_bytes = max_segment_bytes;
+    options.max_segment_age = max_segment_age;
+    return pimpl_->binary_log.open(options);
+}
+
+std::vector<LogEntry> Logger::read_binary_logs(size_t max_count) {
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(pimpl_->mutex);
+        if (!pimpl_->binary_log.is_open()) {
+            return {};
+        }
+        pimpl_->binary_log.flush();
+        directory = pimpl_->binary_log.directory();
+    }
+
+    // Newest segment first; from each, its last entries still wanted
+    std::vector<LogEntry> result;
+    auto segments = LogFileReader::segments(directory);
+    for (auto segment = segments.rbegin(); segment != segments.rend() && result.size() < max_count; ++segment) {
+        size_t wanted = max_count - result.size();
+        std::vector<LogEntry> tail;  // circular, `next` is the oldest once full
+        size_t next = 0;
+        LogFileReader::scan(*segment, [&tail, &next, wanted](const LogEntryView& view) {
+            LogEntry entry;
+            entry.level = view.level;
+            entry.message.assign(view.message);
+            entry.source.assign(view.source);
+            entry.timestamp = static_cast<time_t>(view.time_us / 1000000);
+            entry.category.assign(view.category);
+            if (tail.size() < wanted) {
+                tail.push_back(std::move(entry));
+            }
+            else {
+                tail[next] = std::move(entry);
+                next = (next + 1) % wanted;
+            }
+            return true;
+        });
+        for (size_t i = 0; i < tail.size(); ++i) {
+            result.push_back(std::move(tail[(next + tail.size() - 1 - i) % tail.size()]));
+        }
+    }
+    return result;
 }
 
 void Logger::rotate_logs() {
-    // TODO: Implement log rotation
+    std::lock_guard<std::mutex> lock(pimpl_->mutex);
+
+    // Text log: file -> file.1 -> ... -> file.<ROTATED_TEXT_LOGS>
+    const int ROTATED_TEXT_LOGS = 5;
+    if (pimpl_->file_stream.is_open()) {
+        pimpl_->file_stream.close();
+        std::error_code ec;
+        for (int i = ROTATED_TEXT_LOGS - 1; i >= 1; --i) {
+            std::filesystem::rename(pimpl_->log_file + "." + std::to_string(i),
+                                    pimpl_->log_file + "." + std::to_string(i + 1), ec);
+        }
+        std::filesystem::rename(pimpl_->log_file, pimpl_->log_file + ".1", ec);
+        pimpl_->file_stream.open(pimpl_->log_file, std::ios::app);
+    }
+
+    pimpl_->binary_log.rotate();
 }
 
 void Logger::clear_old_logs(int days) {
     std::lock_guard<std::mutex> lock(pimpl_->mutex);
     
     time_t cutoff = time(nullptr) - (days * 24 * 60 * 60);
-    
-    pimpl_->log_entries.erase(
-        std::remove_if(pimpl_->log_entries.begin(), pimpl_->log_entries.end(),
-            [cutoff](const LogEntry& entry) { return entry.timestamp < cutoff; }),
-        pimpl_->log_entries.end()
-    );
-    
-    pimpl_->audit_entries.erase(
-        std::remove_if(pimpl_->audit_entries.begin(), pimpl_->audit_entries.end(),
-            [cutoff](const AuditEntry& entry) { return entry.timestamp < cutoff; }),
-        pimpl_->audit_entries.end()
-    );
+    pimpl_->log_entries.erase_before(cutoff);
+    pimpl_->audit_entries.erase_before(cutoff);
+    if (pimpl_->binary_log.is_open()) {
+        pimpl_->binary_log.remove_older_than(cutoff);
+    }
 }
 
 } // namespace logging
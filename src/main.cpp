@@ -1,60 +1,227 @@
 #include <iostream>
 #include <cstdlib>
+#include <string>
+#include <vector>
 #include <csignal>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 #include "core/shell.h"
+#include "core/startup_profile.h"
+#include "core/daemon.h"
+#include "core/daemon_protocol.h"
 #include "logging/logger.h"
+#include "logging/log_file.h"
 
 using namespace customos;
 
-// Global shell instance for signal handling
-core::Shell* g_shell = nullptr;
+// Daemon instance for signal handling
+core::DaemonServer* g_daemon = nullptr;
 
 void signal_handler(int signal) {
+    // Async-signal-safe only; main calls shutdown() once the loops return
     if (signal == SIGINT || signal == SIGTERM) {
-        std::cout << "\nShutting down NovaShell...\n";
-        if (g_shell) {
-            g_shell->shutdown();
-        }
-        exit(0);
+        core::Shell::request_stop();
+    }
+}
+
+void install_handler(int signal, void (*handler)(int)) {
+#ifdef _WIN32
+    std::signal(signal, handler);
+#else
+    // No SA_RESTART: a blocked read returns so the loop sees the request
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = handler;
+    sigemptyset(&action.sa_mask);
+    sigaction(signal, &action, nullptr);
+#endif
+}
+
+void daemon_signal_handler(int signal) {
+    // Let main unwind normally so the socket file is removed
+    if ((signal == SIGINT || signal == SIGTERM) && g_daemon) {
+        g_daemon->stop();
+    }
+}
+
+bool stdin_is_terminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdin)) != 0;
+#else
+    return isatty(STDIN_FILENO) != 0;
+#endif
+}
+
+int finish(core::Shell& shell, int status) {
+    // A background job that ignored cancellation still runs shell code;
+    // leave without running static destructors under it
+    if (!shell.shutdown()) {
+        std::cout.flush();
+        std::cerr.flush();
+        std::_Exit(status);
+    }
+    return status;
+}
+
+int run_daemon(core::Shell& shell, const std::string& socket_path) {
+    core::DaemonServer server(*shell.get_command_processor());
+    std::string error;
+    if (!server.start(socket_path, error)) {
+        std::cerr << error << "\n";
+        return 1;
     }
+
+    g_daemon = &server;
+    std::signal(SIGINT, daemon_signal_handler);
+    std::signal(SIGTERM, daemon_signal_handler);
+#ifndef _WIN32
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    std::cerr << "NovaShell daemon listening on " << socket_path << "\n";
+    server.run();
+    g_daemon = nullptr;
+    return 0;
+}
+
+// Print every entry in a binary log directory as text (--dump-log)
+int dump_log(const std::string& directory) {
+    auto segments = logging::LogFileReader::segments(directory);
+    if (segments.empty()) {
+        std::cerr << "No log segments in " << directory << "\n";
+        return 1;
+    }
+    std::string line;
+    for (const auto& segment : segments) {
+        logging::LogFileReader::scan(segment, [&line](const logging::LogEntryView& entry) {
+            time_t seconds = static_cast<time_t>(entry.time_us / 1000000);
+            char when[32];
+            std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", std::localtime(&seconds));
+            line.assign(when);
+            line += " [";
+            line += logging::log_level_name(entry.level);
+            line += "] ";
+            if (!entry.source.empty()) {
+                line += '[';
+                line += entry.source;
+                line += "] ";
+            }
+            line += entry.message;
+            line += '\n';
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            return true;
+        });
+    }
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
     // Set up signal handlers
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
+    install_handler(SIGINT, signal_handler);
+    install_handler(SIGTERM, signal_handler);
+
+    // Leading options belong to the shell; everything after is the command
+    bool daemon_mode = false;
+    std::string socket_path;
+    std::string script_path;
+    std::string log_dir;
+    int first_arg = 1;
+    for (; first_arg < argc; ++first_arg) {
+        std::string arg = argv[first_arg];
+        if (arg == "--startup-profile") {
+            core::StartupProfile::instance().set_enabled(true);
+        } else if (arg == "--daemon") {
+            daemon_mode = true;
+        } else if (arg == "--socket" && first_arg + 1 < argc) {
+            socket_path = argv[++first_arg];
+        } else if (arg == "-f" && first_arg + 1 < argc) {
+            script_path = argv[++first_arg];
+        } else if (arg == "--log-dir" && first_arg + 1 < argc) {
+            log_dir = argv[++first_arg];
+        } else if (arg == "--dump-log" && first_arg + 1 < argc) {
+            return dump_log(argv[first_arg + 1]);
+        } else {
+            break;
+        }
+    }
+    std::vector<std::string> args(argv + first_arg, argv + argc);
 
     try {
         // Create and initialize the shell
         core::Shell shell;
-        g_shell = &shell;
 
-        if (!shell.initialize()) {
-            std::cerr << "Failed to initialize NovaShell\n";
-            return 1;
+        {
+            core::StartupProfile::Phase phase("shell initialize");
+            if (!shell.initialize()) {
+                std::cerr << "Failed to initialize NovaShell\n";
+                return 1;
+            }
+        }
+
+        if (!log_dir.empty() && !logging::Logger::instance().set_binary_log(log_dir)) {
+            std::cerr << "Cannot write binary log to " << log_dir << "\n";
+        }
+
+        if (daemon_mode) {
+#ifndef _WIN32
+            if (socket_path.empty()) {
+                socket_path = core::daemon_protocol::default_socket_path();
+            }
+#endif
+            core::StartupProfile::instance().report(std::cerr);
+            int status = run_daemon(shell, socket_path);
+            return finish(shell, status);
+        }
+
+        // Batch mode: -f script, or commands piped in on stdin
+        if (!script_path.empty() || (args.empty() && !stdin_is_terminal())) {
+            int status;
+            if (script_path.empty() || script_path == "-") {
+                status = shell.run_batch(std::cin, "<stdin>");
+            } else {
+                std::ifstream script(script_path);
+                if (!script) {
+                    std::cerr << "Cannot open script: " << script_path << "\n";
+                    return 1;
+                }
+                status = shell.run_batch(script, script_path);
+            }
+            core::StartupProfile::instance().report(std::cerr);
+            return finish(shell, status);
         }
 
         // Check for command-line arguments
-        if (argc > 1) {
+        if (!args.empty()) {
             // Execute command from arguments
             std::string command;
-            for (int i = 1; i < argc; ++i) {
-                command += argv[i];
-                if (i < argc - 1) command += " ";
+            for (size_t i = 0; i < args.size(); ++i) {
+                command += args[i];
+                if (i + 1 < args.size()) command += " ";
+            }
+
+            bool success;
+            {
+                core::StartupProfile::Phase phase("command");
+                success = shell.execute_command(command);
             }
-            
-            bool success = shell.execute_command(command);
-            return success ? 0 : 1;
+            std::cout.flush();
+            core::StartupProfile::instance().report(std::cerr);
+            return finish(shell, success ? 0 : 1);
         } else {
             // Run interactive shell
+            core::StartupProfile::instance().report(std::cerr);
             shell.run();
         }
 
         // Clean shutdown
-        shell.shutdown();
-        g_shell = nullptr;
-
-        return 0;
+        return finish(shell, 0);
     }
     catch (const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << "\n";
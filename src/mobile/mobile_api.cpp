@@ -1,6 +1,7 @@
 #include "mobile/mobile_api.h"
 #include "network/http_server.h"
 #include "core/command_processor.h"
+#include "core/history_journal.h"
 #include "auth/authentication.h"
 #include "vault/password_manager.h"
 #include "database/internal_db.h"
@@ -367,9 +368,11 @@ void MobileAPI::handle_execute_command(const network::HttpRequest& req, network:
         nlohmann::json body = nlohmann::json::parse(req.body);
         std::string command = body["command"];
 
-        // Execute command
+        core::HistoryJournal::instance().append(command, user, "mobile");
+
+        // Execute command, capturing its output in a private sink
         auto& processor = core::CommandProcessor::instance();
-        auto result = processor.process(command);
+        auto result = processor.capture(command);
 
         nlohmann::json response = pimpl_->create_success_response("Command executed");
         response["data"] = {
@@ -388,12 +391,18 @@ void MobileAPI::handle_execute_command(const network::HttpRequest& req, network:
 void MobileAPI::handle_command_history(const network::HttpRequest& req, network::HttpResponse& resp) {
     std::string user = req.headers.at("X-User");
 
-    auto& db = database::InternalDB::instance();
-    auto history = db.get_history(20); // Last 20 commands
+    // Every session's recent commands, newest first; after a restart the
+    // journal is empty until commands run, so fall back to the table
+    auto entries = core::HistoryJournal::instance().merged(20, true);
 
     nlohmann::json history_list = nlohmann::json::array();
-    for (const auto& cmd : history) {
-        history_list.push_back(cmd);
+    if (entries.empty()) {
+        for (const auto& cmd : database::InternalDB::instance().get_history(20)) {
+            history_list.push_back(cmd);
+        }
+    }
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        history_list.push_back(it->command);
     }
 
     nlohmann::json response = pimpl_->create_success_response("Command history retrieved");
@@ -604,7 +613,7 @@ void MobileAPI::handle_analytics_insights(const network::HttpRequest& req, netwo
 // WebSocket for real-time updates
 void MobileAPI::handle_websocket_connection(const std::string& message) {
     // Handle WebSocket messages for real-time updates
-    LOG_INFO("WebSocket message received: " + message);
+    LOG_INFO("WebSocket message received: {}", message);
 }
 
 } // namespace mobile
@@ -237,7 +237,7 @@ struct HttpServer::Impl {
                 parent->log_request(req, resp);
             }
         } catch (const std::exception& e) {
-            LOG_ERROR("HTTP server error handling client: " + std::string(e.what()));
+            LOG_ERROR("HTTP server error handling client: {}", e.what());
         }
 
         active_connections--;
@@ -337,7 +337,7 @@ bool HttpServer::start(int port, const std::string& host) {
         pimpl_->worker_threads.emplace_back(&Impl::worker_thread, pimpl_.get());
     }
 
-    LOG_INFO("HTTP server started on " + host + ":" + std::to_string(port));
+    LOG_INFO("HTTP server started on {}:{}", host, port);
     return true;
 }
 
@@ -455,7 +455,7 @@ void HttpServer::handle_request(const HttpRequest& req, HttpResponse& resp) {
 }
 
 void HttpServer::log_request(const HttpRequest& req, const HttpResponse& resp) {
-    LOG_INFO("HTTP " + req.method + " " + req.path + " " + std::to_string(resp.status_code) + " from " + req.remote_ip);
+    LOG_INFO("HTTP {} {} {} from {}", req.method, req.path, resp.status_code, req.remote_ip);
 }
 
 } // namespace network
@@ -79,7 +79,7 @@ void TaskScheduler::execute_task(ScheduledTask& task) {
         std::lock_guard<std::mutex> lock(pimpl_->mutex);
         pimpl_->tasks.erase(task.id);
         
-        LOG_INFO("One-time task '" + task.title + "' completed and removed from database");
+        LOG_INFO("One-time task '{}' completed and removed from database", task.title);
     } else {
         // Update recurring task in database
         db.update_scheduled_task(task.user, task.id, true); // Keep enabled
@@ -87,7 +87,7 @@ void TaskScheduler::execute_task(ScheduledTask& task) {
         // Schedule next recurrence
         schedule_next_recurrence(task);
         
-        LOG_INFO("Recurring task '" + task.title + "' completed, next run scheduled");
+        LOG_INFO("Recurring task '{}' completed, next run scheduled", task.title);
     }
     
     if (pimpl_->task_callback) {
@@ -121,7 +121,7 @@ void TaskScheduler::execute_task(ScheduledTask& task) {
                     to_remove.push_back(pair.first);
                 }
                 
-                LOG_INFO("Reminder '" + pair.second.title + "' triggered and completed");
+                LOG_INFO("Reminder '{}' triggered and completed", pair.second.title);
             }
         }
         
@@ -206,10 +206,9 @@ void TaskScheduler::load_from_database() {
             }
         }
         
-        LOG_INFO("Loaded " + std::to_string(pimpl_->tasks.size()) + " tasks and " + 
-                std::to_string(pimpl_->reminders.size()) + " reminders from database");
+        LOG_INFO("Loaded {} tasks and {} reminders from database", pimpl_->tasks.size(), pimpl_->reminders.size());
     } catch (const std::exception& e) {
-        LOG_ERROR("Failed to load scheduler data from database: " + std::string(e.what()));
+        LOG_ERROR("Failed to load scheduler data from database: {}", e.what());
     }
 }
 
@@ -254,7 +253,7 @@ std::string TaskScheduler::schedule_task(const std::string& title, const std::st
     }
     
     pimpl_->tasks[task.id] = task;
-    LOG_INFO("Task '" + title + "' scheduled for user '" + user + "'");
+    LOG_INFO("Task '{}' scheduled for user '{}'", title, user);
     return task.id;
 }
 
@@ -269,7 +268,7 @@ bool TaskScheduler::cancel_task(const std::string& task_id) {
         auto& db = database::InternalDB::instance();
         db.delete_scheduled_task(it->second.user, task_id);
         
-        LOG_INFO("Task '" + it->second.title + "' cancelled and removed from database");
+        LOG_INFO("Task '{}' cancelled and removed from database", it->second.title);
         return true;
     }
     return false;
@@ -375,7 +374,7 @@ std::string TaskScheduler::add_reminder(const std::string& title, const std::str
     }
     
     pimpl_->reminders[reminder.id] = reminder;
-    LOG_INFO("Reminder '" + title + "' added for user '" + user + "'");
+    LOG_INFO("Reminder '{}' added for user '{}'", title, user);
     return reminder.id;
 }
 